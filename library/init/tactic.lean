@@ -17,6 +17,10 @@ inductive tactic :
 Type := builtin : tactic
 
 namespace tactic
+inductive tactic_list : Type :=
+| nil  : tactic_list
+| cons : tactic → tactic_list → tactic_list
+
 -- Remark the following names are not arbitrary, the tactic module
 -- uses them when converting Lean expressions into actual tactic objects.
 -- The bultin 'by' construct triggers the process of converting a
@@ -26,6 +30,7 @@ opaque definition or_else     (t1 t2 : tactic) : tactic := builtin
 opaque definition append      (t1 t2 : tactic) : tactic := builtin
 opaque definition interleave  (t1 t2 : tactic) : tactic := builtin
 opaque definition par         (t1 t2 : tactic) : tactic := builtin
+opaque definition first_success_par (ts : tactic_list) : tactic := builtin
 opaque definition fixpoint    (f : tactic → tactic) : tactic := builtin
 opaque definition repeat      (t : tactic) : tactic := builtin
 opaque definition at_most     (t : tactic) (k : num)  : tactic := builtin
@@ -0,0 +1,187 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+# Released under Apache 2.0 license as described in the file LICENSE.
+#
+# Author: agent
+#
+# End-to-end benchmark for the standard and HoTT libraries.
+#
+# The libraries are first compiled (using linja), then every file is processed again,
+# one at a time, with `lean --profile -j 1`. For each file we record the wall time,
+# the peak memory usage, the time spent importing modules, and the time spent in the
+# elaborator, in tactics and in the kernel for each declaration. The time spent in tactics
+# is not included in the elaboration time. LEAN_PATH (HLEAN_PATH for .hlean files) is set to
+# the directory being benchmarked.
+#
+# The results are stored in a JSON file. If a baseline (produced by a previous execution)
+# is provided, then the files and declarations that became slower by more than the given
+# threshold are reported, and the script exits with code 1. The script also exits with code 1
+# if Lean fails to process any file.
+#
+# Usage: bench_lib.py [--lean LEAN] [--output FILE] [--baseline FILE] [--threshold PERCENT]
+#                     [--min-time SECS] [--no-build] [dir ...]
+from __future__ import print_function
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(os.path.realpath(__file__)), ".."))
+
+# Lines produced by `lean --profile`
+PROFILE_LINE = re.compile(r"^(.*):(\d+):(\d+): (type elaboration|elaboration|type checking|tactic execution|import) time"
+                          r"(?: for (\S+))? ([0-9.e+-]+) secs$")
+
+CATEGORY = {"type elaboration": "elaboration",
+            "elaboration":      "elaboration",
+            "type checking":    "kernel",
+            "tactic execution": "tactic",
+            "import":           "import"}
+
+def error(msg):
+    print("Error: %s" % msg, file=sys.stderr)
+    exit(2)
+
+def lean_files(d):
+    r = []
+    for root, _, files in os.walk(d):
+        for f in files:
+            if f.endswith(".lean") or f.endswith(".hlean"):
+                r.append(os.path.join(root, f))
+    return sorted(r)
+
+def build(d):
+    linja = os.path.join(ROOT, "bin", "linja")
+    if not os.path.exists(linja):
+        error("'%s' was not found, use --no-build or configure Lean using cmake" % linja)
+    subprocess.check_call([sys.executable, linja, "all"], cwd=d)
+
+def run_lean(lean, d, fname):
+    """Process fname (a file in the library directory d), and return (wall time, peak memory in KB, output, status)"""
+    env = dict(os.environ)
+    env["HLEAN_PATH" if fname.endswith(".hlean") else "LEAN_PATH"] = d
+    with tempfile.TemporaryFile() as out:
+        start = time.time()
+        p = subprocess.Popen([lean, "--profile", "-j", "1", fname], stdout=out, stderr=subprocess.STDOUT, env=env)
+        _, status, usage = os.wait4(p.pid, 0)
+        wall = time.time() - start
+        p.returncode = status
+        out.seek(0)
+        return wall, usage.ru_maxrss, out.read().decode("utf-8", "replace"), status
+
+def parse_profile(output):
+    """Return (import time, declarations) where declarations maps names to their profile."""
+    import_time = 0.0
+    decls = {}
+    # tactics are executed during the elaboration of the next declaration, and their execution time is
+    # also included in its elaboration time
+    tactic_time = 0.0
+    for line in output.splitlines():
+        m = PROFILE_LINE.match(line.strip())
+        if not m:
+            continue
+        kind, decl, secs = m.group(4), m.group(5), float(m.group(6))
+        cat = CATEGORY[kind]
+        if cat == "import":
+            import_time += secs
+        elif cat == "tactic":
+            tactic_time += secs
+        elif decl:
+            d = decls.setdefault(decl, {"elaboration": 0.0, "tactic": 0.0, "kernel": 0.0})
+            if cat == "elaboration":
+                d["elaboration"] += max(secs - tactic_time, 0.0)
+                d["tactic"] += tactic_time
+                tactic_time = 0.0
+            else:
+                d[cat] += secs
+    return import_time, decls
+
+def bench(lean, dirs):
+    files = {}
+    for d in dirs:
+        for f in lean_files(d):
+            wall, mem, output, status = run_lean(lean, d, f)
+            import_time, decls = parse_profile(output)
+            rel = os.path.relpath(f, ROOT)
+            files[rel] = {"wall": wall,
+                          "max_rss_kb": mem,
+                          "import": import_time,
+                          "elaboration": sum(d["elaboration"] for d in decls.values()),
+                          "tactic": sum(d["tactic"] for d in decls.values()),
+                          "kernel": sum(d["kernel"] for d in decls.values()),
+                          "ok": status == 0,
+                          "decls": decls}
+            print("%-60s %8.2fs %8d KB%s" % (rel, wall, mem, "" if status == 0 else "  FAILED"), file=sys.stderr)
+    total = {k: sum(f[k] for f in files.values()) for k in ["wall", "import", "elaboration", "tactic", "kernel"]}
+    total["max_rss_kb"] = max([f["max_rss_kb"] for f in files.values()] + [0])
+    return {"files": files, "total": total}
+
+def is_regression(new, old, threshold, min_time):
+    return new >= min_time and new > old * (1.0 + threshold / 100.0)
+
+def compare(result, baseline, threshold, min_time):
+    """Return a list of messages describing the regressions with respect to baseline."""
+    msgs = []
+    for fname, new in sorted(result["files"].items()):
+        old = baseline["files"].get(fname)
+        if old is None:
+            continue
+        for k in ["wall", "import", "elaboration", "tactic", "kernel"]:
+            if is_regression(new[k], old[k], threshold, min_time):
+                msgs.append("%s: %s time %.2fs -> %.2fs" % (fname, k, old[k], new[k]))
+        if new["max_rss_kb"] > old["max_rss_kb"] * (1.0 + threshold / 100.0):
+            msgs.append("%s: peak memory %d KB -> %d KB" % (fname, old["max_rss_kb"], new["max_rss_kb"]))
+        for dname, dnew in sorted(new["decls"].items()):
+            dold = old["decls"].get(dname)
+            if dold is None:
+                continue
+            for k in ["elaboration", "tactic", "kernel"]:
+                if is_regression(dnew[k], dold[k], threshold, min_time):
+                    msgs.append("%s: %s %s time %.2fs -> %.2fs" % (fname, dname, k, dold[k], dnew[k]))
+    return msgs
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark the Lean standard and HoTT libraries.")
+    parser.add_argument("dirs", nargs="*", help="library directories (default: library and hott)")
+    parser.add_argument("--lean", default=os.path.join(ROOT, "bin", "lean"), help="Lean executable")
+    parser.add_argument("--output", default="bench_lib.json", help="file for storing the results")
+    parser.add_argument("--baseline", help="results of a previous execution")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="report times (and memory usage) that increased by more than the given percentage")
+    parser.add_argument("--min-time", type=float, default=0.1,
+                        help="ignore times smaller than the given number of seconds")
+    parser.add_argument("--no-build", action="store_true", help="do not compile the libraries before benchmarking")
+    args = parser.parse_args()
+    dirs = [os.path.abspath(d) for d in args.dirs] or [os.path.join(ROOT, "library"), os.path.join(ROOT, "hott")]
+    if not os.path.exists(args.lean):
+        error("Lean executable '%s' was not found" % args.lean)
+    if not args.no_build:
+        for d in dirs:
+            build(d)
+    result = bench(args.lean, dirs)
+    with open(args.output, "w") as out:
+        json.dump(result, out, indent=1, sort_keys=True)
+    print("total: %.2fs (elaboration %.2fs, tactic %.2fs, kernel %.2fs, import %.2fs)" %
+          (result["total"]["wall"], result["total"]["elaboration"], result["total"]["tactic"],
+           result["total"]["kernel"], result["total"]["import"]))
+    failed = sorted(fname for fname, f in result["files"].items() if not f["ok"])
+    for fname in failed:
+        print("failed: %s" % fname)
+    msgs = []
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        msgs = compare(result, baseline, args.threshold, args.min_time)
+        for msg in msgs:
+            print("regression: %s" % msg)
+    if failed or msgs:
+        exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -23,6 +23,7 @@ Author: Leonardo de Moura
 #include "library/coercion.h"
 #include "library/reducible.h"
 #include "library/normalize.h"
+#include "library/vm.h"
 #include "library/print.h"
 #include "library/class.h"
 #include "library/flycheck.h"
@@ -207,8 +208,11 @@ environment print_cmd(parser & p) {
         p.next();
         name c = p.check_constant_next("invalid 'print instances', constant expected");
         environment const & env = p.env();
-        for (name const & i : get_class_instances(env, c)) {
-            p.regular_stream() << i << " : " << env.get(i).get_type() << endl;
+        pvector<name> insts = get_class_instances(env, c);
+        unsigned i = insts.size();
+        while (i > 0) {
+            --i;
+            p.regular_stream() << insts[i] << " : " << env.get(insts[i]).get_type() << endl;
         }
     } else if (p.curr_is_token_or_id(get_classes_tk())) {
         p.next();
@@ -363,7 +367,10 @@ environment eval_cmd(parser & p) {
                         std::unique_ptr<converter>(new all_transparent_converter(p.env())));
         r = normalize(tc, ls, e);
     } else {
-        r = normalize(p.env(), ls, e);
+        optional<expr> v;
+        if (get_eval_vm(p.get_options()))
+            v = vm_eval(p.env(), e);
+        r = v ? *v : normalize(p.env(), ls, e);
     }
     flycheck_information info(p.regular_stream());
     if (info.enabled()) {
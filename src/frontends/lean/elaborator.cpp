@@ -7,6 +7,7 @@ Author: Leonardo de Moura
 #include <utility>
 #include <vector>
 #include "util/flet.h"
+#include "util/timeit.h"
 #include "util/list_fn.h"
 #include "util/lazy_list_fn.h"
 #include "util/sstream.h"
@@ -121,6 +122,7 @@ elaborator::elaborator(elaborator_context & ctx, name_generator const & ngen, bo
     m_tc[0]             = mk_type_checker(ctx.m_env, m_ngen.mk_child(), false);
     m_tc[1]             = mk_type_checker(ctx.m_env, m_ngen.mk_child(), true);
     m_nice_mvar_names   = nice_mvar_names;
+    m_in_cached_pre_term = false;
 }
 
 expr elaborator::mk_local(name const & n, expr const & t, binder_info const & bi) {
@@ -715,12 +717,12 @@ expr elaborator::ensure_type(expr const & e, constraint_seq & cs) {
             return e;
         }
     }
-    list<expr> coes = get_coercions_to_sort(env(), t);
-    if (is_nil(coes)) {
+    // Remark: we ignore other coercions to sort
+    optional<expr> coe = get_coercion_to_sort(env(), t);
+    if (!coe) {
         throw_kernel_exception(env(), e, [=](formatter const & fmt) { return pp_type_expected(fmt, e); });
     } else {
-        // Remark: we ignore other coercions to sort
-        expr r = mk_coercion_app(head(coes), e);
+        expr r = mk_coercion_app(*coe, e);
         save_coercion_info(e, r);
         return r;
     }
@@ -1395,7 +1397,77 @@ expr elaborator::visit_core(expr const & e, constraint_seq & cs) {
     }
 }
 
+/** \brief Return true if the elaboration of \c e may be stored in the file elaborator cache.
+    We only cache closed applications and binders that do not contain placeholders,
+    overloaded notation, tactics or equations.
+*/
+bool elaborator::use_elaborator_cache(expr const & e) {
+    if (!m_ctx.m_cache || infom() || m_in_equation_lhs || m_equation_lhs)
+        return false;
+    if ((!is_app(e) && !is_binding(e)) || has_local(e) || has_free_vars(e) || has_metavar(e))
+        return false;
+    if (m_in_cached_pre_term)
+        return true; // subterms of a cacheable pre-term are also cacheable
+    return is_cacheable_pre_term(e);
+}
+
+/** \brief Return true if \c e does not contain placeholders, overloaded notation, tactics or equations.
+    The result is computed bottom-up and stored in m_cacheable_pre_terms, since use_elaborator_cache is
+    invoked on all subterms of a pre-term that cannot be cached. */
+bool elaborator::is_cacheable_pre_term(expr const & e) {
+    switch (e.kind()) {
+    case expr_kind::Var: case expr_kind::Sort: case expr_kind::Constant:
+        return !has_placeholder(e);
+    default:
+        break;
+    }
+    auto it = m_cacheable_pre_terms.find(e);
+    if (it != m_cacheable_pre_terms.end())
+        return it->second;
+    bool r;
+    if (is_placeholder(e) || is_choice(e) || is_by(e) || is_sorry(e) || is_equations(e) || is_structure_instance(e)) {
+        r = false;
+    } else {
+        switch (e.kind()) {
+        case expr_kind::Var: case expr_kind::Sort: case expr_kind::Constant:
+            lean_unreachable(); // LCOV_EXCL_LINE
+        case expr_kind::Meta: case expr_kind::Local:
+            r = is_cacheable_pre_term(mlocal_type(e));
+            break;
+        case expr_kind::Lambda: case expr_kind::Pi:
+            r = is_cacheable_pre_term(binding_domain(e)) && is_cacheable_pre_term(binding_body(e));
+            break;
+        case expr_kind::App:
+            r = is_cacheable_pre_term(app_fn(e)) && is_cacheable_pre_term(app_arg(e));
+            break;
+        case expr_kind::Macro:
+            r = true;
+            for (unsigned i = 0; r && i < macro_num_args(e); i++)
+                r = is_cacheable_pre_term(macro_arg(e, i));
+            break;
+        }
+    }
+    m_cacheable_pre_terms.insert(mk_pair(e, r));
+    return r;
+}
+
 pair<expr, constraint_seq> elaborator::visit(expr const & e) {
+    if (!use_elaborator_cache(e))
+        return visit_uncached(e);
+    elaborator_cache & cache = *m_ctx.m_cache;
+    if (auto r = cache.find(env(), ios().get_options(), e, m_relax_main_opaque))
+        return mk_pair(*r, constraint_seq());
+    pair<expr, constraint_seq> r;
+    {
+        flet<bool> set(m_in_cached_pre_term, true);
+        r = visit_uncached(e);
+    }
+    if (!r.second && !has_metavar(r.first) && !has_local(r.first) && !has_param_univ(r.first))
+        cache.insert(env(), ios().get_options(), e, m_relax_main_opaque, r.first);
+    return r;
+}
+
+pair<expr, constraint_seq> elaborator::visit_uncached(expr const & e) {
     if (is_extra_info(e)) {
         auto ecs = visit(get_annotation_arg(e));
         save_extra_type_data(e, ecs.first);
@@ -1665,6 +1737,22 @@ bool elaborator::try_using_begin_end(substitution & subst, expr const & mvar, pr
     }
 }
 
+/** \brief Try to instantiate \c mvar using the tactic \c pre_tac provided by the user.
+    Return false if \c pre_tac cannot be converted into a tactic. */
+bool elaborator::solve_using_pre_tactic(substitution & subst, expr const & mvar, proof_state const & ps, expr const & pre_tac) {
+    if (is_begin_end_annotation(pre_tac)) {
+        try_using_begin_end(subst, mvar, ps, pre_tac);
+        return true;
+    }
+
+    if (auto tac = pre_tactic_to_tactic(subst.instantiate_all(pre_tac))) {
+        bool show_failure = true;
+        try_using(subst, mvar, ps, pre_tac, *tac, show_failure);
+        return true;
+    }
+    return false;
+}
+
 void elaborator::solve_unassigned_mvar(substitution & subst, expr mvar, name_set & visited) {
     if (visited.contains(mlocal_name(mvar)))
         return;
@@ -1680,14 +1768,15 @@ void elaborator::solve_unassigned_mvar(substitution & subst, expr mvar, name_set
     bool relax_main_opaque = m_relaxed_mvars.contains(mlocal_name(mvar));
     proof_state ps = to_proof_state(*meta, type, subst, m_ngen.mk_child(), relax_main_opaque);
     if (auto pre_tac = get_pre_tactic_for(mvar)) {
-        if (is_begin_end_annotation(*pre_tac)) {
-            try_using_begin_end(subst, mvar, ps, *pre_tac);
-            return;
-        }
-
-        if (auto tac = pre_tactic_to_tactic(subst.instantiate_all(*pre_tac))) {
-            bool show_failure = true;
-            try_using(subst, mvar, ps, *pre_tac, *tac, show_failure);
+        if (m_ctx.m_profile && pip()) {
+            std::ostringstream msg;
+            pos_info p = pip()->get_pos_info_or_some(*pre_tac);
+            display_pos(msg, pip()->get_file_name(), p.first, p.second);
+            msg << " tactic execution time";
+            timeit timer(diagnostic(env(), ios()).get_stream(), msg.str().c_str());
+            if (solve_using_pre_tactic(subst, mvar, ps, *pre_tac))
+                return;
+        } else if (solve_using_pre_tactic(subst, mvar, ps, *pre_tac)) {
             return;
         }
     }
@@ -9,6 +9,7 @@ Author: Leonardo de Moura
 #include <vector>
 #include "util/list.h"
 #include "kernel/metavar.h"
+#include "kernel/expr_maps.h"
 #include "kernel/type_checker.h"
 #include "library/expr_lt.h"
 #include "library/unifier.h"
@@ -68,6 +69,10 @@ class elaborator : public coercion_info_manager {
     // If m_nice_mvar_names is true, we append (when possible) a more informative name for a metavariable.
     // That is, whenever a metavariables comes from a binding, we add the binding name as a suffix
     bool                 m_nice_mvar_names;
+    // m_in_cached_pre_term is true when we are elaborating a subterm of a pre-term that can be stored in
+    // the file elaborator cache (see elaborator_context::m_cache).
+    bool                 m_in_cached_pre_term;
+    expr_map<bool>       m_cacheable_pre_terms; // cache for is_cacheable_pre_term
     struct choice_expr_elaborator;
 
     environment const & env() const { return m_ctx.m_env; }
@@ -139,6 +144,9 @@ class elaborator : public coercion_info_manager {
     bool is_sorry(expr const & e) const;
     expr visit_sorry(expr const & e);
     expr visit_core(expr const & e, constraint_seq & cs);
+    bool is_cacheable_pre_term(expr const & e);
+    bool use_elaborator_cache(expr const & e);
+    pair<expr, constraint_seq> visit_uncached(expr const & e);
     pair<expr, constraint_seq> visit(expr const & e);
     expr visit(expr const & e, constraint_seq & cs);
     unify_result_seq solve(constraint_seq const & cs);
@@ -152,6 +160,7 @@ class elaborator : public coercion_info_manager {
     bool try_using(substitution & subst, expr const & mvar, proof_state const & ps,
                    expr const & pre_tac, tactic const & tac, bool show_failure);
     bool try_using_begin_end(substitution & subst, expr const & mvar, proof_state ps, expr const & pre_tac);
+    bool solve_using_pre_tactic(substitution & subst, expr const & mvar, proof_state const & ps, expr const & pre_tac);
     void solve_unassigned_mvar(substitution & subst, expr mvar, name_set & visited);
     expr solve_unassigned_mvars(substitution & subst, expr e, name_set & visited);
     expr solve_unassigned_mvars(substitution & subst, expr const & e);
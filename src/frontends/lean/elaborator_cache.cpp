@@ -0,0 +1,132 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#include <unordered_map>
+#include "library/scoped_ext.h"
+#include "frontends/lean/elaborator_cache.h"
+
+namespace lean {
+elaborator_cache::elaborator_cache():m_num_hits(0), m_num_misses(0), m_saved_weight(0) {}
+
+typedef std::unordered_map<tag, tag> tag_map;
+
+/** \brief Store in \c m the tags of \c e indexed by the tags of \c old_e.
+    \pre \c old_e and \c e are structurally equal. */
+static void collect_tags(expr const & old_e, expr const & e, tag_map & m) {
+    if (is_eqp(old_e, e))
+        return;
+    if (old_e.get_tag() != nulltag && e.get_tag() != nulltag && old_e.get_tag() != e.get_tag())
+        m[old_e.get_tag()] = e.get_tag();
+    switch (e.kind()) {
+    case expr_kind::Var: case expr_kind::Sort: case expr_kind::Constant:
+        return;
+    case expr_kind::Meta: case expr_kind::Local:
+        return collect_tags(mlocal_type(old_e), mlocal_type(e), m);
+    case expr_kind::Lambda: case expr_kind::Pi:
+        collect_tags(binding_domain(old_e), binding_domain(e), m);
+        return collect_tags(binding_body(old_e), binding_body(e), m);
+    case expr_kind::App:
+        collect_tags(app_fn(old_e), app_fn(e), m);
+        return collect_tags(app_arg(old_e), app_arg(e), m);
+    case expr_kind::Macro:
+        for (unsigned i = 0; i < macro_num_args(e); i++)
+            collect_tags(macro_arg(old_e, i), macro_arg(e, i), m);
+        return;
+    }
+}
+
+/** \brief Return a copy of \c e where the tags are replaced using \c m.
+    Cached results are shared, so we create new cells instead of updating the tags in place. */
+static expr retag(expr const & e, tag_map const & m, expr_map<expr> & cache) {
+    auto it_c = cache.find(e);
+    if (it_c != cache.end())
+        return it_c->second;
+    tag g = e.get_tag();
+    auto it = m.find(g);
+    if (it != m.end())
+        g = it->second;
+    expr r;
+    switch (e.kind()) {
+    case expr_kind::Var:      r = mk_var(var_idx(e), g); break;
+    case expr_kind::Sort:     r = mk_sort(sort_level(e), g); break;
+    case expr_kind::Constant: r = mk_constant(const_name(e), const_levels(e), g); break;
+    case expr_kind::Meta:     case expr_kind::Local:
+        lean_unreachable(); // LCOV_EXCL_LINE
+    case expr_kind::Lambda: case expr_kind::Pi:
+        r = mk_binding(e.kind(), binding_name(e), retag(binding_domain(e), m, cache),
+                       retag(binding_body(e), m, cache), binding_info(e), g);
+        break;
+    case expr_kind::App:
+        r = mk_app(retag(app_fn(e), m, cache), retag(app_arg(e), m, cache), g);
+        break;
+    case expr_kind::Macro: {
+        buffer<expr> args;
+        for (unsigned i = 0; i < macro_num_args(e); i++)
+            args.push_back(retag(macro_arg(e, i), m, cache));
+        r = mk_macro(macro_def(e), args.size(), args.data(), g);
+        break;
+    }}
+    cache.insert(mk_pair(e, r));
+    return r;
+}
+
+/** \brief Return \c r, the elaboration of the pre-term \c old_e, with the positions of the
+    structurally equal pre-term \c e. Without this step, errors in a reused result (e.g., type mismatches
+    reported by the kernel) would point to the first occurrence. */
+static expr retag(expr const & old_e, expr const & e, expr const & r) {
+    tag_map m;
+    collect_tags(old_e, e, m);
+    if (m.empty())
+        return r;
+    expr_map<expr> cache;
+    return retag(r, m, cache);
+}
+
+optional<expr> elaborator_cache::find(environment const & env, options const & o, expr const & e, bool relax) {
+    lock_guard<mutex> lock(m_mutex);
+    auto & map = m_map[relax];
+    auto it = map.find(e);
+    if (it != map.end() && env.get_id().is_descendant(it->second.m_env.get_id()) &&
+        is_eqp_scoped_exts(env, it->second.m_env) && o == it->second.m_options) {
+        m_num_hits++;
+        m_saved_weight += get_weight(e);
+        return some_expr(retag(it->first, e, it->second.m_result));
+    }
+    m_num_misses++;
+    return none_expr();
+}
+
+void elaborator_cache::insert(environment const & env, options const & o, expr const & e, bool relax, expr const & r) {
+    lean_assert(!has_metavar(r) && !has_local(r) && !has_param_univ(r));
+    lock_guard<mutex> lock(m_mutex);
+    auto & map = m_map[relax];
+    map.erase(e);
+    map.insert(mk_pair(e, entry(env, o, r)));
+}
+
+void elaborator_cache::clear() {
+    lock_guard<mutex> lock(m_mutex);
+    m_map[0].clear();
+    m_map[1].clear();
+}
+
+unsigned elaborator_cache::get_num_hits() const {
+    lock_guard<mutex> lock(m_mutex);
+    return m_num_hits;
+}
+
+unsigned elaborator_cache::get_num_misses() const {
+    lock_guard<mutex> lock(m_mutex);
+    return m_num_misses;
+}
+
+void elaborator_cache::display_stats(std::ostream & out) const {
+    lock_guard<mutex> lock(m_mutex);
+    out << "elaborator cache: " << m_num_hits << " hits, " << m_num_misses << " misses, "
+        << (m_map[0].size() + m_map[1].size()) << " entries, "
+        << "total weight of reused pre-terms: " << m_saved_weight << "\n";
+}
+}
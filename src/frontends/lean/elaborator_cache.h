@@ -0,0 +1,47 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#pragma once
+#include <iostream>
+#include "util/thread.h"
+#include "util/sexpr/options.h"
+#include "kernel/environment.h"
+#include "kernel/expr_maps.h"
+
+namespace lean {
+/**
+   \brief Cache for the elaboration of closed pre-terms that do not contain placeholders,
+   overloaded notation or tactics. It is shared by all declarations in a file.
+
+   An entry is only used when the current environment is a descendant of the
+   environment where it was created, the scoped extensions (e.g., coercions and instances)
+   were not modified (see is_eqp_scoped_exts), and the options are the same. Only results that do not contain metavariables,
+   local constants or universe parameters, and that do not produce constraints are stored.
+*/
+class elaborator_cache {
+    struct entry {
+        environment    m_env;
+        options        m_options;
+        expr           m_result;
+        entry(environment const & env, options const & o, expr const & r):m_env(env), m_options(o), m_result(r) {}
+    };
+    mutable mutex           m_mutex;
+    // we use different maps for relaxed (i.e., opaque definitions from the main module are treated
+    // as transparent) and regular elaboration.
+    expr_bi_struct_map<entry> m_map[2];
+    unsigned                m_num_hits;
+    unsigned                m_num_misses;
+    unsigned                m_saved_weight; // total weight of the pre-terms we did not have to elaborate
+public:
+    elaborator_cache();
+    optional<expr> find(environment const & env, options const & o, expr const & e, bool relax);
+    void insert(environment const & env, options const & o, expr const & e, bool relax, expr const & r);
+    void clear();
+    unsigned get_num_hits() const;
+    unsigned get_num_misses() const;
+    void display_stats(std::ostream & out) const;
+};
+}
@@ -54,12 +54,15 @@ bool get_elaborator_fail_missing_field(options const & opts) {
 // ==========================================
 
 elaborator_context::elaborator_context(environment const & env, io_state const & ios, local_decls<level> const & lls,
-                                       pos_info_provider const * pp, info_manager * info, bool check_unassigned):
-    m_env(env), m_ios(ios), m_lls(lls), m_pos_provider(pp), m_info_manager(info), m_check_unassigned(check_unassigned) {
+                                       pos_info_provider const * pp, info_manager * info, bool check_unassigned,
+                                       elaborator_cache * cache):
+    m_env(env), m_ios(ios), m_lls(lls), m_pos_provider(pp), m_info_manager(info), m_cache(cache),
+    m_check_unassigned(check_unassigned) {
     m_use_local_instances = get_elaborator_local_instances(ios.get_options());
     m_ignore_instances    = get_elaborator_ignore_instances(ios.get_options());
     m_flycheck_goals      = get_elaborator_flycheck_goals(ios.get_options());
     m_fail_missing_field  = get_elaborator_fail_missing_field(ios.get_options());
+    m_profile             = ios.get_options().get_bool("profile", false);
 }
 
 void initialize_elaborator_context() {
@@ -9,6 +9,7 @@ Author: Leonardo de Moura
 #include "library/io_state.h"
 #include "frontends/lean/local_decls.h"
 #include "frontends/lean/info_manager.h"
+#include "frontends/lean/elaborator_cache.h"
 
 namespace lean {
 name const & get_elaborator_ignore_instances_name();
@@ -19,16 +20,19 @@ class elaborator_context {
     local_decls<level>        m_lls; // local universe levels
     pos_info_provider const * m_pos_provider;
     info_manager *            m_info_manager;
+    elaborator_cache *        m_cache;
     // configuration
     bool                      m_check_unassigned;
     bool                      m_use_local_instances;
     bool                      m_ignore_instances;
     bool                      m_flycheck_goals;
     bool                      m_fail_missing_field;
+    bool                      m_profile;
     friend class elaborator;
 public:
     elaborator_context(environment const & env, io_state const & ios, local_decls<level> const & lls,
-                       pos_info_provider const * pp = nullptr, info_manager * info = nullptr, bool check_unassigned = true);
+                       pos_info_provider const * pp = nullptr, info_manager * info = nullptr, bool check_unassigned = true,
+                       elaborator_cache * cache = nullptr);
 };
 void initialize_elaborator_context();
 void finalize_elaborator_context();
@@ -12,6 +12,7 @@ Author: Leonardo de Moura
 #include "util/script_exception.h"
 #include "util/sstream.h"
 #include "util/flet.h"
+#include "util/timeit.h"
 #include "util/lean_path.h"
 #include "util/sexpr/option_declarations.h"
 #include "kernel/for_each_fn.h"
@@ -108,9 +109,10 @@ parser::parser(environment const & env, io_state const & ios,
     m_verbose(true), m_use_exceptions(use_exceptions),
     m_scanner(strm, strm_name, s ? s->m_line : 1),
     m_theorem_queue(*this, num_threads > 1 ? num_threads - 1 : 0),
-    m_snapshot_vector(sv), m_info_manager(im), m_cache(nullptr), m_index(nullptr) {
+    m_snapshot_vector(sv), m_info_manager(im), m_cache(nullptr), m_index(nullptr),
+    m_id_cache_hits(0), m_id_cache_misses(0) {
     m_profile    = ios.get_options().get_bool("profile", false);
-    if (num_threads > 1)
+    if (m_profile && num_threads > 1)
         throw exception("option --profile cannot be used when theorems are compiled in parallel");
     m_has_params = false;
     m_keep_theorem_mode = tmode;
@@ -672,16 +674,17 @@ level parser::parse_level(unsigned rbp) {
 }
 
 elaborator_context parser::mk_elaborator_context(pos_info_provider const &  pp, bool check_unassigned) {
-    return elaborator_context(m_env, m_ios, m_local_level_decls, &pp, m_info_manager, check_unassigned);
+    return elaborator_context(m_env, m_ios, m_local_level_decls, &pp, m_info_manager, check_unassigned,
+                              &m_elaborator_cache);
 }
 
 elaborator_context parser::mk_elaborator_context(environment const & env, pos_info_provider const & pp) {
-    return elaborator_context(env, m_ios, m_local_level_decls, &pp, m_info_manager, true);
+    return elaborator_context(env, m_ios, m_local_level_decls, &pp, m_info_manager, true, &m_elaborator_cache);
 }
 
 elaborator_context parser::mk_elaborator_context(environment const & env, local_level_decls const & lls,
                                                  pos_info_provider const & pp) {
-    return elaborator_context(env, m_ios, lls, &pp, m_info_manager, true);
+    return elaborator_context(env, m_ios, lls, &pp, m_info_manager, true, &m_elaborator_cache);
 }
 
 std::tuple<expr, level_param_names> parser::elaborate_relaxed(expr const & e, list<expr> const & ctx) {
@@ -1108,6 +1111,48 @@ expr parser::parse_led_notation(expr left) {
     }
 }
 
+auto parser::resolve_global_id(name const & id) -> id_resolution {
+    if (!m_id_cache_env_id || !is_eqp(*m_id_cache_env_id, m_env.get_id())) {
+        m_id_cache.clear();
+        m_id_cache_env_id = m_env.get_id();
+    }
+    if (auto it = m_id_cache.find(id)) {
+        m_id_cache_hits++;
+        return *it;
+    }
+    m_id_cache_misses++;
+    id_resolution r = resolve_global_id_core(id);
+    m_id_cache.insert(id, r);
+    return r;
+}
+
+auto parser::resolve_global_id_core(name const & id) -> id_resolution {
+    for (name const & ns : get_namespaces(m_env)) {
+        auto new_id = ns + id;
+        if (!ns.is_anonymous() && m_env.find(new_id) &&
+            (!id.is_atomic() || !is_protected(m_env, new_id)))
+            return id_resolution(to_list(new_id), false);
+    }
+
+    if (!id.is_atomic()) {
+        name new_id = remove_root_prefix(id);
+        if (m_env.find(new_id))
+            return id_resolution(to_list(new_id), false);
+    }
+
+    buffer<name> ns;
+    // globals
+    if (m_env.find(id))
+        ns.push_back(id);
+    // aliases
+    auto as = get_expr_aliases(m_env, id);
+    if (is_nil(as))
+        return id_resolution(to_list(ns.begin(), ns.end()), false);
+    for (name const & a : as)
+        ns.push_back(a);
+    return id_resolution(to_list(ns.begin(), ns.end()), true);
+}
+
 expr parser::id_to_expr(name const & id, pos_info const & p) {
     buffer<level> lvl_buffer;
     levels ls;
@@ -1131,45 +1176,16 @@ expr parser::id_to_expr(name const & id, pos_info const & p) {
         return r;
     }
 
-    for (name const & ns : get_namespaces(m_env)) {
-        auto new_id = ns + id;
-        if (!ns.is_anonymous() && m_env.find(new_id) &&
-            (!id.is_atomic() || !is_protected(m_env, new_id))) {
-            auto r = save_pos(mk_constant(new_id, ls), p);
-            save_type_info(r);
-            add_ref_index(new_id, p);
-            save_identifier_info(p, new_id);
-            return r;
-        }
-    }
-
-    if (!id.is_atomic()) {
-        name new_id = id;
-        new_id = remove_root_prefix(new_id);
-        if (m_env.find(new_id)) {
-            auto r = save_pos(mk_constant(new_id, ls), p);
-            save_type_info(r);
-            add_ref_index(new_id, p);
-            save_identifier_info(p, new_id);
-            return r;
-        }
-    }
-
     optional<expr> r;
-    // globals
-    if (m_env.find(id))
-        r = save_pos(mk_constant(id, ls), p);
-    // aliases
-    auto as = get_expr_aliases(m_env, id);
-    if (!is_nil(as)) {
+    id_resolution res = resolve_global_id(id);
+    if (res.m_overload) {
         buffer<expr> new_as;
-        if (r)
-            new_as.push_back(*r);
-        for (auto const & e : as) {
-            new_as.push_back(copy_with_new_pos(mk_constant(e, ls), p));
-        }
+        for (name const & n : res.m_names)
+            new_as.push_back(copy_with_new_pos(mk_constant(n, ls), p));
         r = save_pos(mk_choice(new_as.size(), new_as.data()), p);
         save_overload(*r);
+    } else if (res.m_names) {
+        r = save_pos(mk_constant(head(res.m_names), ls), p);
     }
     if (!r) {
         if (m_undef_id_behavior == undef_id_behavior::AssumeConstant) {
@@ -1347,6 +1363,10 @@ static bool is_tactic_type(expr const & e) {
     return is_constant(e) && const_name(e) == get_tactic_name();
 }
 
+static bool is_tactic_list_type(expr const & e) {
+    return is_constant(e) && const_name(e) == get_tactic_tactic_list_name();
+}
+
 static bool is_tactic_expr_list_type(expr const & e) {
     return is_constant(e) && const_name(e) == get_tactic_expr_list_name();
 }
@@ -1409,6 +1429,26 @@ expr parser::parse_tactic_expr_list() {
     return mk_tactic_expr_list(args, p);
 }
 
+expr parser::parse_tactic_list() {
+    auto p = pos();
+    check_token_next(get_lbracket_tk(), "invalid tactic, '[' expected");
+    buffer<expr> args;
+    while (true) {
+        args.push_back(parse_tactic());
+        if (!curr_is_token(get_comma_tk()))
+            break;
+        next();
+    }
+    check_token_next(get_rbracket_tk(), "invalid tactic, ',' or ']' expected");
+    unsigned i = args.size();
+    expr r = save_pos(mk_constant(get_tactic_tactic_list_nil_name()), p);
+    while (i > 0) {
+        i--;
+        r = mk_app({save_pos(mk_constant(get_tactic_tactic_list_cons_name()), p), args[i], r}, p);
+    }
+    return r;
+}
+
 expr parser::parse_tactic_id_list() {
     auto p = pos();
     check_token_next(get_lbracket_tk(), "invalid tactic, '[' expected");
@@ -1458,6 +1498,8 @@ expr parser::parse_tactic_nud() {
                 expr d = binding_domain(type);
                 if (is_tactic_type(d)) {
                     r = mk_app(r, parse_tactic(get_max_prec()), id_pos);
+                } else if (is_tactic_list_type(d)) {
+                    r = mk_app(r, parse_tactic_list(), id_pos);
                 } else if (is_tactic_expr_list_type(d)) {
                     r = mk_app(r, parse_tactic_expr_list(), id_pos);
                 } else if (is_tactic_opt_expr_list_type(d)) {
@@ -1615,8 +1657,17 @@ void parser::parse_imports() {
     if (get_parser_parallel_import(m_ios.get_options()))
         num_threads = m_num_threads;
     bool keep_imported_thms = (m_keep_theorem_mode == keep_theorem_mode::All);
-    m_env = import_modules(m_env, base, olean_files.size(), olean_files.data(), num_threads,
-                           keep_imported_thms, m_ios);
+    if (m_profile && !olean_files.empty()) {
+        std::ostringstream msg;
+        ::lean::display_pos(msg, get_stream_name().c_str(), 1, 0);
+        msg << " import time";
+        timeit timer(diagnostic_stream().get_stream(), msg.str().c_str());
+        m_env = import_modules(m_env, base, olean_files.size(), olean_files.data(), num_threads,
+                               keep_imported_thms, m_ios);
+    } else {
+        m_env = import_modules(m_env, base, olean_files.size(), olean_files.data(), num_threads,
+                               keep_imported_thms, m_ios);
+    }
     for (auto const & f : lua_files) {
         std::string rname = find_file(f, {".lua"});
         system_import(rname.c_str());
@@ -1701,6 +1752,11 @@ bool parser::parse_commands() {
         if (keep_new_thms())
             m_env.replace(thm);
     }
+    if (m_profile) {
+        m_elaborator_cache.display_stats(diagnostic_stream().get_stream());
+        diagnostic_stream() << "identifier resolution cache: " << m_id_cache_hits << " hits, "
+                            << m_id_cache_misses << " misses\n";
+    }
     return !m_found_errors;
 }
 
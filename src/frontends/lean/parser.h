@@ -30,6 +30,7 @@ Author: Leonardo de Moura
 #include "frontends/lean/parser_pos_provider.h"
 #include "frontends/lean/theorem_queue.h"
 #include "frontends/lean/info_manager.h"
+#include "frontends/lean/elaborator_cache.h"
 
 namespace lean {
 /** \brief Exception used to track parsing erros, it does not leak outside of this class. */
@@ -127,6 +128,8 @@ class parser {
 
     // cache support
     definition_cache *     m_cache;
+    // elaboration results for closed pre-terms, shared by all declarations in the file
+    elaborator_cache       m_elaborator_cache;
     // index support
     declaration_index *    m_index;
 
@@ -137,6 +140,25 @@ class parser {
 
     buffer<expr>           m_undef_ids;
 
+    // resolution of global identifiers (see resolve_global_id)
+    struct id_resolution {
+        list<name> m_names;    // constants denoted by the identifier
+        bool       m_overload; // true if the identifier must be elaborated as a choice expression
+        id_resolution():m_overload(false) {}
+        id_resolution(list<name> const & ns, bool o):m_names(ns), m_overload(o) {}
+    };
+    // The cache is only valid for the environment m_id_cache_env_id. Commands such as
+    // open, namespace, section and new declarations produce a new environment, and reset it.
+    optional<environment_id> m_id_cache_env_id;
+    name_map<id_resolution>  m_id_cache;
+    unsigned                 m_id_cache_hits;
+    unsigned                 m_id_cache_misses;
+
+    /** \brief Return the constants denoted by the global identifier \c id in the current environment.
+        The result is cached, and reused while the environment does not change. */
+    id_resolution resolve_global_id(name const & id);
+    id_resolution resolve_global_id_core(name const & id);
+
     // profiling
     bool                   m_profile;
 
@@ -232,6 +254,7 @@ class parser {
     expr parse_tactic_nud();
     expr mk_tactic_expr_list(buffer<expr> const & args, pos_info const & p);
     expr parse_tactic_expr_list();
+    expr parse_tactic_list();
     expr parse_tactic_opt_expr_list();
     expr parse_tactic_id_list();
     expr parse_tactic_opt_id_list();
@@ -56,6 +56,7 @@ static format * g_visible_fmt     = nullptr;
 static format * g_show_fmt        = nullptr;
 static format * g_explicit_fmt    = nullptr;
 static name   * g_tmp_prefix      = nullptr;
+LEAN_THREAD_PTR(pp_elision_table, g_elision_table);
 
 class nat_numeral_pp {
     expr m_num_type;
@@ -216,7 +217,7 @@ name pretty_fn::mk_local_name(name const & n, name const & suggested) {
         return *it;
     unsigned i = 1;
     name r = suggested;
-    while (m_purify_used_locals.contains(r)) {
+    while (m_purify_used_locals.contains(r) || m_binder_locals.contains(r)) {
         r = suggested.append_after(i);
         i++;
     }
@@ -281,6 +282,7 @@ void pretty_fn::set_options_core(options const & o) {
     m_numerals        = get_pp_numerals(o);
     m_abbreviations   = get_pp_abbreviations(o);
     m_extra_spaces    = get_pp_extra_spaces(o);
+    m_lazy            = get_pp_lazy(o);
     m_hide_full_terms = get_formatter_hide_full_terms(o);
     m_num_nat_coe     = m_numerals && !m_coercion && has_coercion_num_nat(m_env);
 }
@@ -292,7 +294,39 @@ void pretty_fn::set_options(options const & o) {
 }
 
 format pretty_fn::pp_level(level const & l) {
-    return ::lean::pp(l, m_unicode, m_indent);
+    return ::lean::pp(m_lazy ? purify(l) : l, m_unicode, m_indent);
+}
+
+/** \brief When m_lazy is true, beta reduction is applied to the subterms being displayed (see pp_beta_reduce_fn). */
+expr pretty_fn::beta_head(expr const & e) const {
+    if (!m_lazy || !m_beta)
+        return e;
+    expr r = e;
+    while (is_head_beta(r))
+        r = head_beta_reduce(r);
+    return r;
+}
+
+/** \brief Similar to binding_body_fresh at library/print.h, but when m_lazy is true,
+    it makes sure the name of the new local does not collide with the names already
+    assigned by the purification step. */
+pair<expr, expr> pretty_fn::binding_body_fresh(expr const & b) {
+    auto p = ::lean::binding_body_fresh(b, true);
+    if (!m_lazy)
+        return p;
+    name n = local_pp_name(p.second);
+    if (m_purify_used_locals.contains(n)) {
+        name s     = n;
+        unsigned i = 1;
+        while (m_purify_used_locals.contains(n) || is_used_name(binding_body(b), n)) {
+            n = s.append_after(i);
+            i++;
+        }
+        expr local = mk_local(n, binding_domain(b), binding_info(b));
+        p = mk_pair(instantiate(binding_body(b), local), local);
+    }
+    m_binder_locals.insert(n);
+    return p;
 }
 
 bool pretty_fn::is_implicit(expr const & f) {
@@ -382,7 +416,8 @@ auto pretty_fn::pp_local_ref(expr const & e) -> optional<result> {
     return optional<result>();
 }
 
-auto pretty_fn::pp_child(expr const & e, unsigned bp, bool ignore_hide) -> result {
+auto pretty_fn::pp_child(expr const & e_, unsigned bp, bool ignore_hide) -> result {
+    expr e = beta_head(e_);
     if (auto it = is_abbreviated(e))
         return pp_abbreviation(e, *it, false, bp, ignore_hide);
     if (is_app(e)) {
@@ -490,12 +525,14 @@ auto pretty_fn::pp_const(expr const & e) -> result {
 
 auto pretty_fn::pp_meta(expr const & e) -> result {
     if (m_purify_metavars)
-        return result(compose(format("?"), format(mlocal_name(e))));
+        return result(compose(format("?"), format(m_lazy ? mk_metavar_name(mlocal_name(e)) : mlocal_name(e))));
     else
         return result(compose(format("?M."), format(mlocal_name(e))));
 }
 
 auto pretty_fn::pp_local(expr const & e) -> result {
+    if (m_lazy && !m_binder_locals.contains(mlocal_name(e)))
+        return result(format(mk_local_name(mlocal_name(e), local_pp_name(e))));
     return result(format(local_pp_name(e)));
 }
 
@@ -587,7 +624,7 @@ auto pretty_fn::pp_lambda(expr const & e) -> result {
     expr b = e;
     buffer<expr> locals;
     while (is_lambda(b)) {
-        auto p = binding_body_fresh(b, true);
+        auto p = binding_body_fresh(b);
         locals.push_back(p.second);
         b = p.first;
     }
@@ -614,7 +651,7 @@ auto pretty_fn::pp_pi(expr const & e) -> result {
         expr b = e;
         buffer<expr> locals;
         while (is_pi(b) && !is_default_arrow(b)) {
-            auto p = binding_body_fresh(b, true);
+            auto p = binding_body_fresh(b);
             locals.push_back(p.second);
             b = p.first;
         }
@@ -638,7 +675,7 @@ static bool is_show(expr const & e) {
 auto pretty_fn::pp_have(expr const & e) -> result {
     expr proof   = app_arg(e);
     expr binding = get_annotation_arg(app_fn(e));
-    auto p       = binding_body_fresh(binding, true);
+    auto p       = binding_body_fresh(binding);
     expr local   = p.second;
     expr body    = p.first;
     name const & n = local_pp_name(local);
@@ -1041,7 +1078,7 @@ auto pretty_fn::pp_notation(notation_entry const & entry, buffer<optional<expr>>
                               (is_pi(b) && !a.use_lambda_abstraction()))) {
                             break;
                         }
-                        auto p = binding_body_fresh(b, true);
+                        auto p = binding_body_fresh(b);
                         if (first_scoped) {
                             locals.push_back(p.second);
                         } else {
@@ -1135,13 +1172,23 @@ static bool is_pp_atomic(expr const & e) {
     }
 }
 
-auto pretty_fn::pp(expr const & e, bool ignore_hide) -> result {
+format pretty_fn::mk_ellipsis(expr const & e) {
+    format r = m_unicode ? *g_ellipsis_n_fmt : *g_ellipsis_fmt;
+    if (m_lazy && g_elision_table) {
+        unsigned id = g_elision_table->add(pp_elision_table::entry(m_env, m_options, e, get_purify_state()));
+        r += format("#") + format(id);
+    }
+    return r;
+}
+
+auto pretty_fn::pp(expr const & e_, bool ignore_hide) -> result {
     check_system("pretty printer");
+    expr e = beta_head(e_);
     if ((m_depth >= m_max_depth ||
          m_num_steps > m_max_steps ||
          (m_hide_full_terms && !ignore_hide && !has_expr_metavar_relaxed(e))) &&
         !is_pp_atomic(e)) {
-        return result(m_unicode ? *g_ellipsis_n_fmt : *g_ellipsis_fmt);
+        return result(mk_ellipsis(e));
     }
     flet<unsigned> let_d(m_depth, m_depth+1);
     m_num_steps++;
@@ -1213,14 +1260,79 @@ class pp_beta_reduce_fn : public replace_visitor {
     }
 };
 
+pp_purify_state pretty_fn::get_purify_state() const {
+    pp_purify_state s;
+    s.m_next_meta_idx = m_next_meta_idx;
+    s.m_meta_table    = m_purify_meta_table;
+    s.m_used_metas    = m_purify_used_metas;
+    s.m_local_table   = m_purify_local_table;
+    s.m_used_locals   = m_purify_used_locals;
+    s.m_binder_locals = m_binder_locals;
+    return s;
+}
+
+void pretty_fn::set_purify_state(pp_purify_state const & s) {
+    m_next_meta_idx      = s.m_next_meta_idx;
+    m_purify_meta_table  = s.m_meta_table;
+    m_purify_used_metas  = s.m_used_metas;
+    m_purify_local_table = s.m_local_table;
+    m_purify_used_locals = s.m_used_locals;
+    m_binder_locals      = s.m_binder_locals;
+}
+
 format pretty_fn::operator()(expr const & e) {
     m_depth = 0; m_num_steps = 0;
+    if (m_lazy)
+        return pp_child(e, 0).fmt(); // beta reduction and purification are performed on demand
     if (m_beta)
         return pp_child(purify(pp_beta_reduce_fn()(e)), 0).fmt();
     else
         return pp_child(purify(e), 0).fmt();
 }
 
+format pretty_fn::expand(expr const & e, pp_purify_state const & s) {
+    set_purify_state(s);
+    m_depth = 0; m_num_steps = 0;
+    return pp_child(e, 0).fmt();
+}
+
+format pp_expand(pp_elision_table::entry const & e) {
+    pretty_fn fn(e.m_env, e.m_options.update(get_formatter_hide_full_terms_name(), false));
+    return fn.expand(e.m_expr, e.m_state);
+}
+
+unsigned pp_elision_table::add(entry const & e) {
+    unsigned id = m_next_id++;
+    m_entries.emplace_front(id, e);
+    m_id2entry[id] = m_entries.begin();
+    if (m_entries.size() > m_capacity) {
+        m_id2entry.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+    return id;
+}
+
+auto pp_elision_table::find(unsigned id) -> entry const * {
+    auto it = m_id2entry.find(id);
+    if (it == m_id2entry.end())
+        return nullptr;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return &it->second->second;
+}
+
+void pp_elision_table::clear() {
+    m_entries.clear();
+    m_id2entry.clear();
+}
+
+scoped_pp_elision_table::scoped_pp_elision_table(pp_elision_table & t):m_old(g_elision_table) {
+    g_elision_table = &t;
+}
+
+scoped_pp_elision_table::~scoped_pp_elision_table() {
+    g_elision_table = m_old;
+}
+
 formatter_factory mk_pretty_formatter_factory() {
     return [](environment const & env, options const & o) { // NOLINT
         auto fn_ptr = std::make_shared<pretty_fn>(env, o);
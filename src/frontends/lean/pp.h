@@ -7,6 +7,8 @@ Author: Leonardo de Moura
 #pragma once
 #include <utility>
 #include <limits>
+#include <list>
+#include <unordered_map>
 #include "util/pair.h"
 #include "util/name_map.h"
 #include "util/name_set.h"
@@ -19,6 +21,63 @@ Author: Leonardo de Moura
 namespace lean {
 class notation_entry;
 
+/** \brief Names assigned by the pretty printer to metavariables and local constants. */
+struct pp_purify_state {
+    unsigned            m_next_meta_idx;
+    name_map<name>      m_meta_table;
+    name_set            m_used_metas;
+    name_map<name>      m_local_table;
+    name_set            m_used_locals;
+    name_set            m_binder_locals;
+    pp_purify_state():m_next_meta_idx(1) {}
+};
+
+#ifndef LEAN_PP_ELISION_TABLE_CAPACITY
+#define LEAN_PP_ELISION_TABLE_CAPACITY 1024
+#endif
+
+/**
+   \brief Subterms elided by the pretty printer when the option pp.lazy is set.
+   Each elided subterm is displayed with an identifier that can be used to expand it later
+   (see #pp_expand).
+
+   The table keeps at most LEAN_PP_ELISION_TABLE_CAPACITY entries, the least recently used
+   entries are removed first.
+*/
+class pp_elision_table {
+public:
+    struct entry {
+        environment     m_env;
+        options         m_options;
+        expr            m_expr;
+        pp_purify_state m_state;
+        entry(environment const & env, options const & o, expr const & e, pp_purify_state const & s):
+            m_env(env), m_options(o), m_expr(e), m_state(s) {}
+    };
+private:
+    typedef std::list<pair<unsigned, entry>> entries;
+    unsigned                                         m_next_id;
+    unsigned                                         m_capacity;
+    entries                                          m_entries; // most recently used first
+    std::unordered_map<unsigned, entries::iterator>  m_id2entry;
+public:
+    pp_elision_table(unsigned capacity = LEAN_PP_ELISION_TABLE_CAPACITY):m_next_id(1), m_capacity(capacity) {}
+    unsigned add(entry const & e);
+    /** \brief Return the entry with the given identifier, or nullptr if it was removed. */
+    entry const * find(unsigned id);
+    unsigned size() const { return m_entries.size(); }
+    /** \brief Remove all entries, identifiers are not reused. */
+    void clear();
+};
+
+/** \brief Set the elision table used by pretty printers in the current thread. */
+class scoped_pp_elision_table {
+    pp_elision_table * m_old;
+public:
+    scoped_pp_elision_table(pp_elision_table & t);
+    ~scoped_pp_elision_table();
+};
+
 class pretty_fn {
 public:
     static unsigned max_bp() { return get_max_prec(); }
@@ -48,6 +107,7 @@ private:
     name_set            m_purify_used_metas;
     name_map<name>      m_purify_local_table;
     name_set            m_purify_used_locals;
+    name_set            m_binder_locals;     //!< locals created for binders when m_lazy is true
     // cached configuration
     options             m_options;
     unsigned            m_indent;
@@ -69,6 +129,7 @@ private:
     bool                m_abbreviations;
     bool                m_hide_full_terms;
     bool                m_extra_spaces;
+    bool                m_lazy;             //!< if true preprocess subterms on demand, and record elided subterms
 
     name mk_metavar_name(name const & m);
     name mk_local_name(name const & n, name const & suggested);
@@ -79,6 +140,11 @@ private:
     bool has_implicit_args(expr const & f);
     optional<name> is_aliased(name const & n) const;
     optional<name> is_abbreviated(expr const & e) const;
+    expr beta_head(expr const & e) const;
+    pair<expr, expr> binding_body_fresh(expr const & b);
+    format mk_ellipsis(expr const & e);
+    pp_purify_state get_purify_state() const;
+    void set_purify_state(pp_purify_state const & s);
 
     format pp_binder_block(buffer<name> const & names, expr const & type, binder_info const & bi);
     format pp_binders(buffer<expr> const & locals);
@@ -120,8 +186,15 @@ public:
     void set_options(options const & o);
     options const & get_options() const { return m_options; }
     format operator()(expr const & e);
+    /** \brief Pretty print an elided subterm \c e using the names assigned in \c s */
+    format expand(expr const & e, pp_purify_state const & s);
 };
 
+/** \brief Pretty print a subterm recorded in a pp_elision_table.
+    The option formatter.hide_full_terms is ignored, otherwise terms elided because of it
+    would be elided again. */
+format pp_expand(pp_elision_table::entry const & e);
+
 formatter_factory mk_pretty_formatter_factory();
 void initialize_pp();
 void finalize_pp();
@@ -317,6 +317,7 @@ static std::string * g_valid = nullptr;
 static std::string * g_sleep = nullptr;
 static std::string * g_findp = nullptr;
 static std::string * g_findg = nullptr;
+static std::string * g_expand = nullptr;
 
 static bool is_command(std::string const & cmd, std::string const & line) {
     return line.compare(0, cmd.size(), cmd) == 0;
@@ -342,6 +343,7 @@ void server::process_from(unsigned line_num) {
 
 void server::load_file(std::string const & fname, bool error_if_nofile) {
     interrupt_worker();
+    m_elided.clear();
     std::ifstream in(fname);
     if (in.bad() || in.fail()) {
         if (error_if_nofile) {
@@ -362,6 +364,7 @@ void server::load_file(std::string const & fname, bool error_if_nofile) {
 
 void server::visit_file(std::string const & fname) {
     interrupt_worker();
+    m_elided.clear();
     auto it = m_file_map.find(fname);
     if (it == m_file_map.end()) {
         bool error_if_nofile = false;
@@ -554,6 +557,16 @@ void server::show(bool valid) {
     m_out << "-- ENDSHOW" << std::endl;
 }
 
+void server::expand(unsigned id) {
+    m_out << "-- BEGINEXPAND" << std::endl;
+    if (auto e = m_elided.find(id)) {
+        m_out << mk_pair(pp_expand(*e), e->m_options) << std::endl;
+    } else {
+        m_out << "-- ERROR unknown elided term #" << id << std::endl;
+    }
+    m_out << "-- ENDEXPAND" << std::endl;
+}
+
 void server::display_decl(name const & short_name, name const & long_name, environment const & env, options const & o) {
     declaration const & d = env.get(long_name);
     io_state_stream out   = regular(env, m_ios).update_options(o);
@@ -838,6 +851,7 @@ void server::save_olean(std::string const & fname) {
 }
 
 bool server::operator()(std::istream & in) {
+    scoped_pp_elision_table scope(m_elided);
     for (std::string line; std::getline(in, line);) {
         try {
             if (is_command(*g_load, line)) {
@@ -911,6 +925,8 @@ bool server::operator()(std::istream & in) {
                 pair<unsigned, unsigned> line_col_num = get_line_col_num(line, *g_findg);
                 read_line(in, line);
                 find_goal_matches(line_col_num.first, line_col_num.second, line);
+            } else if (is_command(*g_expand, line)) {
+                expand(get_num(line, *g_expand));
             } else {
                 throw exception(sstream() << "unexpected command line: " << line);
             }
@@ -953,6 +969,7 @@ void initialize_server() {
     g_sleep = new std::string("SLEEP");
     g_findp = new std::string("FINDP");
     g_findg = new std::string("FINDG");
+    g_expand = new std::string("EXPAND");
 }
 void finalize_server() {
     delete g_auto_completion_max_results;
@@ -976,5 +993,6 @@ void finalize_server() {
     delete g_sleep;
     delete g_findp;
     delete g_findg;
+    delete g_expand;
 }
 }
@@ -12,6 +12,7 @@ Author: Leonardo de Moura
 #include "library/definition_cache.h"
 #include "frontends/lean/parser.h"
 #include "frontends/lean/info_manager.h"
+#include "frontends/lean/pp.h"
 
 namespace lean {
 /**
@@ -70,6 +71,7 @@ class server {
     snapshot                  m_empty_snapshot;
     definition_cache          m_cache;
     worker                    m_worker;
+    pp_elision_table          m_elided;
 
     void load_file(std::string const & fname, bool error_if_nofile = true);
     void save_olean(std::string const & fname);
@@ -91,6 +93,7 @@ class server {
     void interrupt_worker();
     void show_options();
     void show(bool valid);
+    void expand(unsigned id);
     void sync(std::vector<std::string> const & lines);
     void wait(optional<unsigned> ms);
     unsigned get_line_num(std::string const & line, std::string const & cmd);
@@ -87,6 +87,7 @@ struct structure_cmd_fn {
     environment                 m_env;
     name_generator              m_ngen;
     type_checker_ptr            m_tc;
+    batch_checker               m_checker; // used to check the auxiliary declarations
     name                        m_namespace;
     name                        m_name;
     pos_info                    m_name_pos;
@@ -723,7 +724,7 @@ struct structure_cmd_fn {
         declaration new_decl = mk_definition(m_env, n, rec_on_decl.get_univ_params(),
                                              rec_on_decl.get_type(), rec_on_decl.get_value(),
                                              opaque);
-        m_env = module::add(m_env, check(m_env, new_decl));
+        m_env = module::add(m_env, m_checker.check(m_env, new_decl));
         m_env = set_reducible(m_env, n, reducible_status::Reducible);
         save_def_info(n);
         add_alias(n);
@@ -818,7 +819,7 @@ struct structure_cmd_fn {
             bool opaque                    = false;
             declaration coercion_decl      = mk_definition(m_env, coercion_name, lnames, coercion_type, coercion_value,
                                                            opaque);
-            m_env = module::add(m_env, check(m_env, coercion_decl));
+            m_env = module::add(m_env, m_checker.check(m_env, coercion_decl));
             m_env = set_reducible(m_env, coercion_name, reducible_status::Reducible);
             save_def_info(coercion_name);
             add_alias(coercion_name);
@@ -860,7 +861,7 @@ struct structure_cmd_fn {
         name eta_name(m_name, "eta");
 
         declaration eta_decl     = mk_theorem(eta_name, lnames, eta_type, eta_value);
-        m_env = module::add(m_env, check(m_env, eta_decl));
+        m_env = module::add(m_env, m_checker.check(m_env, eta_decl));
         save_thm_info(eta_name);
         add_alias(eta_name);
     }
@@ -891,7 +892,7 @@ struct structure_cmd_fn {
             expr proj_over_value    = Fun(m_params, Fun(m_fields, refl));
 
             declaration proj_over_decl = mk_theorem(proj_over_name, lnames, proj_over_type, proj_over_value);
-            m_env = module::add(m_env, check(m_env, proj_over_decl));
+            m_env = module::add(m_env, m_checker.check(m_env, proj_over_decl));
             save_thm_info(proj_over_name);
             add_alias(proj_over_name);
         }
@@ -33,9 +33,16 @@ expr abstract_locals(expr const & e, unsigned n, expr const * subst) {
     lean_assert(std::all_of(subst, subst+n, [](expr const & e) { return closed(e) && is_local(e); }));
     if (!has_local(e))
         return e;
+    unsigned filter = 0;
+    for (unsigned i = 0; i < n; i++)
+        filter |= mk_mlocal_filter(mlocal_name(subst[i]));
+    if ((get_mlocal_filter(e) & filter) == 0)
+        return e;
     return replace(e, [=](expr const & m, unsigned offset) -> optional<expr> {
             if (!has_local(m))
                 return some_expr(m); // expression m does not contain local constants
+            if ((get_mlocal_filter(m) & filter) == 0)
+                return some_expr(m); // expression m does not contain the local constants in subst
             if (is_local(m)) {
                 unsigned i = n;
                 while (i > 0) {
@@ -38,6 +38,7 @@ struct dummy_converter : public converter {
     virtual optional<module_idx> get_module_idx() const { return optional<module_idx>(); }
     virtual bool is_opaque(declaration const &) const { return false; }
     virtual optional<declaration> is_delta(expr const &) const { return optional<declaration>(); }
+    virtual void set_env(environment const &) {}
     virtual bool is_stuck(expr const &, type_checker &) { return false; }
 };
 
@@ -21,6 +21,9 @@ public:
     virtual optional<module_idx> get_module_idx() const = 0;
     virtual bool is_opaque(declaration const & d) const = 0;
     virtual optional<declaration> is_delta(expr const & e) const = 0;
+    /** \brief Replace the environment used by this converter.
+        \pre \c env is a descendant of the current one. */
+    virtual void set_env(environment const & env) = 0;
 
     virtual bool is_stuck(expr const & e, type_checker & c) = 0;
     virtual pair<expr, constraint_seq> whnf(expr const & e, type_checker & c) = 0;
@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include "util/interrupt.h"
+#include "util/thread.h"
 #include "util/flet.h"
 #include "kernel/default_converter.h"
 #include "kernel/instantiate.h"
@@ -12,7 +13,26 @@ Author: Leonardo de Moura
 #include "kernel/type_checker.h"
 
 namespace lean {
+#ifndef LEAN_DEFAULT_CONVERTER_FAILURE_CACHE_CAPACITY
+#define LEAN_DEFAULT_CONVERTER_FAILURE_CACHE_CAPACITY 1024
+#endif
+
 static expr * g_dont_care = nullptr;
+static atomic<unsigned> * g_failure_cache_hits     = nullptr;
+static atomic<unsigned> * g_failure_cache_failures = nullptr;
+
+def_eq_failure_cache_stats get_def_eq_failure_cache_stats() {
+    def_eq_failure_cache_stats r;
+    r.m_num_hits     = *g_failure_cache_hits;
+    r.m_num_failures = *g_failure_cache_failures;
+    return r;
+}
+
+void display_def_eq_failure_cache_stats(std::ostream & out) {
+    def_eq_failure_cache_stats st = get_def_eq_failure_cache_stats();
+    out << "definitional equality failure cache: " << st.m_num_failures << " failures, "
+        << st.m_num_hits << " hits\n";
+}
 
 default_converter::default_converter(environment const & env, optional<module_idx> mod_idx, bool memoize):
     m_env(env), m_module_idx(mod_idx), m_memoize(memoize) {
@@ -548,9 +568,21 @@ pair<bool, constraint_seq> default_converter::is_def_eq_core(expr const & t, exp
 }
 
 pair<bool, constraint_seq> default_converter::is_def_eq(expr const & t, expr const & s) {
+    // The result of is_def_eq_core does not depend on constraints when t and s do not contain metavariables.
+    bool use_failure_cache = m_memoize && !has_metavar(t) && !has_metavar(s);
+    if (use_failure_cache && m_failure_cache && m_failure_cache->contains(mk_pair(t, s))) {
+        (*g_failure_cache_hits)++;
+        return to_bcs(false);
+    }
     auto r = is_def_eq_core(t, s);
-    if (r.first && !r.second)
+    if (r.first && !r.second) {
         m_eqv_manager.add_equiv(t, s);
+    } else if (!r.first && use_failure_cache) {
+        if (!m_failure_cache)
+            m_failure_cache.reset(new failure_cache(LEAN_DEFAULT_CONVERTER_FAILURE_CACHE_CAPACITY));
+        m_failure_cache->insert(mk_pair(t, s));
+        (*g_failure_cache_failures)++;
+    }
     return r;
 }
 
@@ -567,10 +599,14 @@ pair<expr, constraint_seq> default_converter::whnf(expr const & e, type_checker
 }
 
 void initialize_default_converter() {
-    g_dont_care = new expr(Const("dontcare"));
+    g_dont_care              = new expr(Const("dontcare"));
+    g_failure_cache_hits     = new atomic<unsigned>(0);
+    g_failure_cache_failures = new atomic<unsigned>(0);
 }
 
 void finalize_default_converter() {
     delete g_dont_care;
+    delete g_failure_cache_hits;
+    delete g_failure_cache_failures;
 }
 }
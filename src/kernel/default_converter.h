@@ -5,7 +5,10 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <memory>
+#include <iostream>
 #include "util/lbool.h"
+#include "util/lru_cache.h"
 #include "kernel/justification.h"
 #include "kernel/environment.h"
 #include "kernel/converter.h"
@@ -13,6 +16,15 @@ Author: Leonardo de Moura
 #include "kernel/equiv_manager.h"
 
 namespace lean {
+/** \brief Statistics for the caches of failed definitional equality checks (for all converters). */
+struct def_eq_failure_cache_stats {
+    unsigned m_num_hits;     // number of checks that were skipped because they were in the cache
+    unsigned m_num_failures; // number of failures that were added to the cache
+    def_eq_failure_cache_stats():m_num_hits(0), m_num_failures(0) {}
+};
+def_eq_failure_cache_stats get_def_eq_failure_cache_stats();
+void display_def_eq_failure_cache_stats(std::ostream & out);
+
 /** \breif Converter used in the kernel */
 class default_converter : public converter {
 protected:
@@ -22,6 +34,14 @@ protected:
     expr_struct_map<expr>                       m_whnf_core_cache;
     expr_struct_map<pair<expr, constraint_seq>> m_whnf_cache;
     equiv_manager                               m_eqv_manager;
+    struct expr_pair_hash {
+        unsigned operator()(pair<expr, expr> const & p) const { return hash(p.first.hash(), p.second.hash()); }
+    };
+    typedef lru_cache<pair<expr, expr>, expr_pair_hash> failure_cache;
+    // Pairs of terms without metavariables that are not definitionally equal.
+    // The cache is created on demand, and it is not shared with other converters since
+    // the result depends on the opacity configuration.
+    std::unique_ptr<failure_cache>              m_failure_cache;
 
     // The two auxiliary fields are set when the public methods whnf and is_def_eq are invoked.
     // The goal is to avoid to keep carrying them around.
@@ -79,6 +99,7 @@ public:
     virtual optional<declaration> is_delta(expr const & e) const;
     virtual bool is_opaque(declaration const & d) const;
     virtual optional<module_idx> get_module_idx() const { return m_module_idx; }
+    virtual void set_env(environment const & env) { lean_assert(env.is_descendant(m_env)); m_env = env; }
 
     virtual bool is_stuck(expr const & e, type_checker & c);
     virtual pair<expr, constraint_seq> whnf(expr const & e_prime, type_checker & c);
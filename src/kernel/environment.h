@@ -90,6 +90,10 @@ public:
 
     /** \brief Return true iff this object is a descendant of the given one. */
     bool is_descendant(environment_id const & id) const;
+    /** \brief Return true iff \c id1 and \c id2 identify the same environment (i.e., one is a copy of the other). */
+    friend bool is_eqp(environment_id const & id1, environment_id const & id2) {
+        return id1.m_ptr == id2.m_ptr && id1.m_depth == id2.m_depth;
+    }
 };
 
 /**
@@ -225,6 +229,7 @@ class name_generator;
 */
 class certified_declaration {
     friend certified_declaration check(environment const & env, declaration const & d, name_generator const & g);
+    friend class batch_checker;
     environment_id m_id;
     declaration    m_declaration;
     certified_declaration(environment_id const & id, declaration const & d):m_id(id), m_declaration(d) {}
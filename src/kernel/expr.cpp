@@ -144,7 +144,7 @@ DEF_THREAD_MEMORY_POOL(get_mlocal_allocator, sizeof(expr_mlocal));
 expr_mlocal::expr_mlocal(bool is_meta, name const & n, expr const & t, tag g):
     expr_composite(is_meta ? expr_kind::Meta : expr_kind::Local, n.hash(), is_meta || t.has_expr_metavar(), t.has_univ_metavar(),
                    !is_meta || t.has_local(), t.has_param_univ(),
-                   1, get_free_var_range(t), g),
+                   1, get_free_var_range(t), mk_mlocal_filter(n) | get_mlocal_filter(t), g),
     m_name(n),
     m_type(t) {}
 void expr_mlocal::dealloc(buffer<expr_cell*> & todelete) {
@@ -166,10 +166,12 @@ void expr_local::dealloc(buffer<expr_cell*> & todelete) {
 
 // Composite expressions
 expr_composite::expr_composite(expr_kind k, unsigned h, bool has_expr_mv, bool has_univ_mv,
-                               bool has_local, bool has_param_univ, unsigned w, unsigned fv_range, tag g):
+                               bool has_local, bool has_param_univ, unsigned w, unsigned fv_range,
+                               unsigned mlocal_filter, tag g):
     expr_cell(k, h, has_expr_mv, has_univ_mv, has_local, has_param_univ, g),
     m_weight(w),
-    m_free_var_range(fv_range) {}
+    m_free_var_range(fv_range),
+    m_mlocal_filter(mlocal_filter) {}
 
 // Expr applications
 DEF_THREAD_MEMORY_POOL(get_app_allocator, sizeof(expr_app));
@@ -181,6 +183,7 @@ expr_app::expr_app(expr const & fn, expr const & arg, tag g):
                    fn.has_param_univ()   || arg.has_param_univ(),
                    inc_weight(add_weight(get_weight(fn), get_weight(arg))),
                    std::max(get_free_var_range(fn), get_free_var_range(arg)),
+                   get_mlocal_filter(fn) | get_mlocal_filter(arg),
                    g),
     m_fn(fn), m_arg(arg) {
     m_hash = ::lean::hash(m_hash, m_weight);
@@ -213,6 +216,7 @@ expr_binding::expr_binding(expr_kind k, name const & n, expr const & t, expr con
                    t.has_param_univ()     || b.has_param_univ(),
                    inc_weight(add_weight(get_weight(t), get_weight(b))),
                    std::max(get_free_var_range(t), dec(get_free_var_range(b))),
+                   get_mlocal_filter(t) | get_mlocal_filter(b),
                    g),
     m_binder(n, t, i),
     m_body(b) {
@@ -278,6 +282,13 @@ static unsigned get_free_var_range(unsigned num, expr const * args) {
     return r;
 }
 
+static unsigned get_mlocal_filter(unsigned num, expr const * args) {
+    unsigned r = 0;
+    for (unsigned i = 0; i < num; i++)
+        r |= get_mlocal_filter(args[i]);
+    return r;
+}
+
 expr_macro::expr_macro(macro_definition const & m, unsigned num, expr const * args, tag g):
     expr_composite(expr_kind::Macro,
                    lean::hash(num, [&](unsigned i) { return args[i].hash(); }, m.hash()),
@@ -287,6 +298,7 @@ expr_macro::expr_macro(macro_definition const & m, unsigned num, expr const * ar
                    std::any_of(args, args+num, [](expr const & e) { return e.has_param_univ(); }),
                    inc_weight(add_weight(num, args)),
                    get_free_var_range(num, args),
+                   get_mlocal_filter(num, args),
                    g),
     m_definition(m),
     m_num_args(num) {
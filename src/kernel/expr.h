@@ -186,11 +186,13 @@ class expr_composite : public expr_cell {
 protected:
     unsigned m_weight;
     unsigned m_free_var_range;
+    unsigned m_mlocal_filter;
     friend unsigned get_weight(expr const & e);
     friend unsigned get_free_var_range(expr const & e);
+    friend unsigned get_mlocal_filter(expr const & e);
 public:
     expr_composite(expr_kind k, unsigned h, bool has_expr_mv, bool has_univ_mv, bool has_local,
-                   bool has_param_univ, unsigned w, unsigned fv_range, tag g);
+                   bool has_param_univ, unsigned w, unsigned fv_range, unsigned mlocal_filter, tag g);
 };
 
 /** \brief Metavariables and local constants */
@@ -555,6 +557,26 @@ inline unsigned get_free_var_range(expr const & e) {
     default:                                        return static_cast<expr_composite*>(e.raw())->m_free_var_range;
     }
 }
+/** \brief Return the bit used to represent the local constant or metavariable named \c n
+    in the filters returned by #get_mlocal_filter. */
+inline unsigned mk_mlocal_filter(name const & n) { return 1u << (n.hash() % 32); }
+/**
+   \brief Return a small Bloom filter for the names of the local constants and metavariables
+   occurring in \c e (including the ones occurring in their types).
+
+   If <tt>(get_mlocal_filter(e) & mk_mlocal_filter(n)) == 0</tt>, then \c e does not contain
+   a local constant or metavariable named \c n. The filter is computed when \c e is created.
+*/
+inline unsigned get_mlocal_filter(expr const & e) {
+    switch (e.kind()) {
+    case expr_kind::Var: case expr_kind::Constant: case expr_kind::Sort: return 0;
+    default: return static_cast<expr_composite*>(e.raw())->m_mlocal_filter;
+    }
+}
+/** \brief Return false if \c e definitely does not contain a local constant or metavariable named \c n. */
+inline bool may_contain_mlocal(expr const & e, name const & n) {
+    return (get_mlocal_filter(e) & mk_mlocal_filter(n)) != 0;
+}
 /** \brief Return true iff the given expression has free variables. */
 inline bool has_free_vars(expr const & e) { return get_free_var_range(e) > 0; }
 /** \brief Return true iff the given expression does not have free variables. */
@@ -12,12 +12,14 @@ Author: Leonardo de Moura
 #include "kernel/level.h"
 #include "kernel/declaration.h"
 #include "kernel/default_converter.h"
+#include "kernel/instantiate.h"
 
 namespace lean {
 void initialize_kernel_module() {
     initialize_level();
     initialize_expr();
     initialize_declaration();
+    initialize_instantiate();
     initialize_default_converter();
     initialize_converter();
     initialize_type_checker();
@@ -30,6 +32,7 @@ void finalize_kernel_module() {
     finalize_type_checker();
     finalize_converter();
     finalize_default_converter();
+    finalize_instantiate();
     finalize_declaration();
     finalize_expr();
     finalize_level();
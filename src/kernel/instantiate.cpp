@@ -7,6 +7,10 @@ Author: Leonardo de Moura
 #include <algorithm>
 #include <limits>
 #include <vector>
+#include <memory>
+#include "util/thread.h"
+#include "util/hash.h"
+#include "util/lru_cache.h"
 #include "kernel/free_vars.h"
 #include "kernel/replace_fn.h"
 #include "kernel/declaration.h"
@@ -16,6 +20,10 @@ Author: Leonardo de Moura
 #define LEAN_INST_UNIV_CACHE_SIZE 1023
 #endif
 
+#ifndef LEAN_INST_VALUE_SHARED_CACHE_CAPACITY
+#define LEAN_INST_VALUE_SHARED_CACHE_CAPACITY 8192
+#endif
+
 namespace lean {
 template<bool rev>
 struct instantiate_easy_fn {
@@ -204,6 +212,79 @@ expr instantiate_type_univ_params(declaration const & d, levels const & ls) {
     return r;
 }
 
+/** \brief Cache for the instantiated values of universe polymorphic definitions shared by all threads.
+
+    The thread local caches above are small and direct mapped. When the same definitions are unfolded
+    at the same universe levels in different threads, or too many definitions are unfolded by a thread,
+    the shared cache avoids instantiating their values again. Entries are keyed by (declaration, levels),
+    and declarations are compared using pointer equality. Thus, an entry can only be used by environments
+    containing the exact same declaration object. */
+class instantiate_value_shared_cache {
+    struct entry {
+        declaration m_decl;
+        levels      m_levels;
+        expr        m_value;
+        entry(declaration const & d, levels const & ls, expr const & v):m_decl(d), m_levels(ls), m_value(v) {}
+    };
+    struct entry_hash {
+        unsigned operator()(entry const & e) const {
+            unsigned h = e.m_decl.get_name().hash();
+            for (level const & l : e.m_levels)
+                h = hash(h, l.hash());
+            return h;
+        }
+    };
+    struct entry_eq {
+        bool operator()(entry const & e1, entry const & e2) const {
+            return is_eqp(e1.m_decl, e2.m_decl) && e1.m_levels == e2.m_levels;
+        }
+    };
+    mutex                                     m_mutex;
+    lru_cache<entry, entry_hash, entry_eq>    m_cache;
+    unsigned                                  m_num_hits;
+    unsigned                                  m_num_misses;
+public:
+    instantiate_value_shared_cache():
+        m_cache(LEAN_INST_VALUE_SHARED_CACHE_CAPACITY), m_num_hits(0), m_num_misses(0) {}
+
+    optional<expr> find(declaration const & d, levels const & ls) {
+        lock_guard<mutex> lock(m_mutex);
+        if (auto it = m_cache.find(entry(d, ls, expr()))) {
+            m_num_hits++;
+            return some_expr(it->m_value);
+        }
+        m_num_misses++;
+        return none_expr();
+    }
+
+    void insert(declaration const & d, levels const & ls, expr const & v) {
+        lock_guard<mutex> lock(m_mutex);
+        m_cache.insert(entry(d, ls, v));
+    }
+
+    instantiate_value_cache_stats get_stats() {
+        lock_guard<mutex> lock(m_mutex);
+        instantiate_value_cache_stats r;
+        r.m_num_hits   = m_num_hits;
+        r.m_num_misses = m_num_misses;
+        r.m_size       = m_cache.size();
+        r.m_capacity   = m_cache.capacity();
+        return r;
+    }
+};
+
+static instantiate_value_shared_cache * g_value_shared_cache = nullptr;
+
+instantiate_value_cache_stats get_instantiate_value_cache_stats() {
+    return g_value_shared_cache->get_stats();
+}
+
+void display_instantiate_value_cache_stats(std::ostream & out) {
+    instantiate_value_cache_stats st = get_instantiate_value_cache_stats();
+    out << "instantiated definition cache: " << st.m_num_hits << " hits, " << st.m_num_misses << " misses, "
+        << st.m_size << "/" << st.m_capacity << " entries\n";
+}
+
 expr instantiate_value_univ_params(declaration const & d, levels const & ls) {
     lean_assert(d.get_num_univ_params() == length(ls));
     if (is_nil(ls) || !has_param_univ(d.get_value()))
@@ -211,8 +292,21 @@ expr instantiate_value_univ_params(declaration const & d, levels const & ls) {
     instantiate_univ_cache & cache = get_value_univ_cache();
     if (auto r = cache.is_cached(d, ls))
         return *r;
+    if (auto r = g_value_shared_cache->find(d, ls)) {
+        cache.save(d, ls, *r);
+        return *r;
+    }
     expr r = instantiate_univ_params(d.get_value(), d.get_univ_params(), ls);
     cache.save(d, ls, r);
+    g_value_shared_cache->insert(d, ls, r);
     return r;
 }
+
+void initialize_instantiate() {
+    g_value_shared_cache = new instantiate_value_shared_cache();
+}
+
+void finalize_instantiate() {
+    delete g_value_shared_cache;
+}
 }
@@ -6,6 +6,7 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <functional>
+#include <iostream>
 #include "kernel/expr.h"
 
 namespace lean {
@@ -40,4 +41,19 @@ expr instantiate_type_univ_params(declaration const & d, levels const & ls);
     \pre d.get_num_univ_params() == length(ls)
 */
 expr instantiate_value_univ_params(declaration const & d, levels const & ls);
+
+/** \brief Statistics for the cache of instantiated definition values shared by all threads
+    (see instantiate_value_univ_params). */
+struct instantiate_value_cache_stats {
+    unsigned m_num_hits;
+    unsigned m_num_misses;
+    unsigned m_size;
+    unsigned m_capacity;
+    instantiate_value_cache_stats():m_num_hits(0), m_num_misses(0), m_size(0), m_capacity(0) {}
+};
+instantiate_value_cache_stats get_instantiate_value_cache_stats();
+void display_instantiate_value_cache_stats(std::ostream & out);
+
+void initialize_instantiate();
+void finalize_instantiate();
 }
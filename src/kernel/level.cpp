@@ -7,6 +7,7 @@ Author: Leonardo de Moura
 #include <utility>
 #include <algorithm>
 #include <vector>
+#include <unordered_map>
 #include "util/safe_arith.h"
 #include "util/buffer.h"
 #include "util/rc.h"
@@ -17,6 +18,14 @@ Author: Leonardo de Moura
 #include "kernel/level.h"
 #include "kernel/environment.h"
 
+#ifndef LEAN_LEVEL_NORMALIZE_CACHE_SIZE
+#define LEAN_LEVEL_NORMALIZE_CACHE_SIZE 1023
+#endif
+
+#ifndef LEAN_LEVEL_GEQ_CACHE_SIZE
+#define LEAN_LEVEL_GEQ_CACHE_SIZE 1023
+#endif
+
 namespace lean {
 level_cell const & to_cell(level const & l) {
     return *l.m_ptr;
@@ -27,8 +36,20 @@ struct level_cell {
     void dealloc();
     MK_LEAN_RC()
     level_kind m_kind;
+    bool       m_interned; // true if this object is stored in the level table
     unsigned   m_hash;
-    level_cell(level_kind k, unsigned h):m_rc(0), m_kind(k), m_hash(h) {}
+    level_cell(level_kind k, unsigned h):m_rc(0), m_kind(k), m_interned(false), m_hash(h) {}
+
+    /** \brief Increment the reference counter if it is not zero, and return true if succeeded.
+        An object whose reference counter is zero is being deleted, and must not be resurrected. */
+    bool try_inc_ref() {
+        unsigned rc = m_rc.load();
+        while (rc != 0) {
+            if (m_rc.compare_exchange_weak(rc, rc + 1))
+                return true;
+        }
+        return false;
+    }
 };
 
 struct level_composite : public level_cell {
@@ -116,7 +137,134 @@ name const & level_id(level const & l) {
     return to_param_core(l).m_id;
 }
 
+/**
+   \brief Table of hash-consed universe levels. Each distinct level is represented by a single
+   level_cell object. Thus, two levels are equal iff they are pointer equal.
+
+   A level is only stored in the table if its arguments are, and the arguments are compared using
+   pointer equality. The table is split into shards, each one protected by its own mutex.
+   The table does not keep its objects alive, an object is removed from it when its reference
+   counter reaches zero.
+
+   \remark The table is only used when Lean is compiled with LEAN_HASH_CONS_LEVELS
+   (cmake option HASH_CONS_LEVELS).
+*/
+class level_table {
+    struct key {
+        level_kind         m_kind;
+        unsigned           m_hash;
+        level_cell const * m_arg1;
+        level_cell const * m_arg2;
+        name const *       m_id;
+        key(level_kind k, unsigned h):
+            m_kind(k), m_hash(h), m_arg1(nullptr), m_arg2(nullptr), m_id(nullptr) {}
+        key(level_kind k, unsigned h, level const & a):
+            m_kind(k), m_hash(h), m_arg1(&to_cell(a)), m_arg2(nullptr), m_id(nullptr) {}
+        key(level_kind k, unsigned h, level const & a1, level const & a2):
+            m_kind(k), m_hash(h), m_arg1(&to_cell(a1)), m_arg2(&to_cell(a2)), m_id(nullptr) {}
+        key(level_kind k, unsigned h, name const & n):
+            m_kind(k), m_hash(h), m_arg1(nullptr), m_arg2(nullptr), m_id(&n) {}
+        explicit key(level_cell const * c);
+    };
+    struct key_hash { unsigned operator()(key const & k) const { return k.m_hash; } };
+    struct key_eq {
+        bool operator()(key const & k1, key const & k2) const {
+            return
+                k1.m_kind == k2.m_kind && k1.m_arg1 == k2.m_arg1 && k1.m_arg2 == k2.m_arg2 &&
+                (k1.m_id == nullptr ? k2.m_id == nullptr : k2.m_id != nullptr && *k1.m_id == *k2.m_id);
+        }
+    };
+    typedef std::unordered_map<key, level_cell *, key_hash, key_eq> map;
+    static constexpr unsigned num_shards = 64;
+    struct shard {
+        mutex m_mutex;
+        map   m_map;
+    };
+    shard m_shards[num_shards];
+    shard & get_shard(unsigned h) { return m_shards[h % num_shards]; }
+public:
+    /** \brief Return the level for the given key, or create a new one using \c mk */
+    template<typename MK>
+    level find_or_insert(key const & k, MK && mk) {
+        shard & s = get_shard(k.m_hash);
+        lock_guard<mutex> lock(s.m_mutex);
+        auto it = s.m_map.find(k);
+        if (it != s.m_map.end()) {
+            level_cell * c = it->second;
+            if (c->try_inc_ref()) {
+                level r(c);
+                c->dec_ref_core(); // r keeps c alive
+                return r;
+            }
+            // The object is being deleted by another thread.
+            // Remark: the key of the entry points to memory owned by this object.
+            s.m_map.erase(it);
+        }
+        level_cell * c = mk();
+        c->m_interned  = true;
+        // Remark: the reference counter must be incremented while we hold the lock.
+        level r(c);
+        s.m_map.insert(mk_pair(key(c), c));
+        return r;
+    }
+    template<typename MK>
+    level find_or_insert(level_kind k, unsigned h, MK && mk) {
+        return find_or_insert(key(k, h), mk);
+    }
+    template<typename MK>
+    level find_or_insert(level_kind k, unsigned h, level const & a, MK && mk) {
+        return find_or_insert(key(k, h, a), mk);
+    }
+    template<typename MK>
+    level find_or_insert(level_kind k, unsigned h, level const & a1, level const & a2, MK && mk) {
+        return find_or_insert(key(k, h, a1, a2), mk);
+    }
+    template<typename MK>
+    level find_or_insert(level_kind k, unsigned h, name const & n, MK && mk) {
+        return find_or_insert(key(k, h, n), mk);
+    }
+    /** \brief Remove \c c from the table. \pre c->get_rc() == 0 */
+    void erase(level_cell * c) {
+        lean_assert(c->m_interned);
+        key k(c);
+        shard & s = get_shard(k.m_hash);
+        lock_guard<mutex> lock(s.m_mutex);
+        auto it = s.m_map.find(k);
+        // The entry may have been replaced by a new object, see find_or_insert
+        if (it != s.m_map.end() && it->second == c)
+            s.m_map.erase(it);
+    }
+};
+
+level_table::key::key(level_cell const * c):
+    m_kind(c->m_kind), m_hash(c->m_hash), m_arg1(nullptr), m_arg2(nullptr), m_id(nullptr) {
+    switch (c->m_kind) {
+    case level_kind::Zero:
+        break;
+    case level_kind::Succ:
+        m_arg1 = &to_cell(static_cast<level_succ const *>(c)->m_l);
+        break;
+    case level_kind::Max: case level_kind::IMax:
+        m_arg1 = &to_cell(static_cast<level_max_core const *>(c)->m_lhs);
+        m_arg2 = &to_cell(static_cast<level_max_core const *>(c)->m_rhs);
+        break;
+    case level_kind::Param: case level_kind::Global: case level_kind::Meta:
+        m_id = &static_cast<level_param_core const *>(c)->m_id;
+        break;
+    }
+}
+
+static level_table * g_level_table = nullptr;
+
+/** \brief Return true if new levels with the given arguments can be hash-consed. */
+static bool use_level_table(level const & a) {
+    // Remark: levels created before initialize_level (or after finalize_level) are not hash-consed.
+    return g_level_table && to_cell(a).m_interned;
+}
+
 void level_cell::dealloc() {
+    if (m_interned && g_level_table)
+        g_level_table->erase(this);
     switch (m_kind) {
     case level_kind::Succ:
         delete static_cast<level_succ*>(this);
@@ -192,7 +340,17 @@ bool is_explicit(level const & l) {
 }
 
 level mk_succ(level const & l) {
-    return level(new level_succ(l));
+    auto mk = [&]() { return new level_succ(l); };
+    if (use_level_table(l))
+        return g_level_table->find_or_insert(level_kind::Succ, hash(hash(l), 17u), l, mk);
+    return level(mk());
+}
+
+static level mk_max_core(bool imax, level const & l1, level const & l2) {
+    auto mk = [&]() { return new level_max_core(imax, l1, l2); };
+    if (use_level_table(l1) && use_level_table(l2))
+        return g_level_table->find_or_insert(imax ? level_kind::IMax : level_kind::Max, hash(hash(l1), hash(l2)), l1, l2, mk);
+    return level(mk());
 }
 
 /** \brief Convert (succ^k l) into (l, k). If l is not a succ, then return (l, 0) */
@@ -230,7 +388,7 @@ level mk_max(level const & l1, level const & l2)  {
             lean_assert(p1.second != p2.second);
             return p1.second > p2.second ? l1 : l2;
         } else {
-            return level(new level_max_core(false, l1, l2));
+            return mk_max_core(false, l1, l2);
         }
     }
 }
@@ -245,12 +403,19 @@ level mk_imax(level const & l1, level const & l2) {
     else if (l1 == l2)
         return l1;  // imax u u = u
     else
-        return level(new level_max_core(true,  l1, l2));
+        return mk_max_core(true, l1, l2);
+}
+
+static level mk_param_core(level_kind k, name const & n) {
+    auto mk = [&]() { return new level_param_core(k, n); };
+    if (g_level_table)
+        return g_level_table->find_or_insert(k, hash(n.hash(), static_cast<unsigned>(k)), n, mk);
+    return level(mk());
 }
 
-level mk_param_univ(name const & n) { return level(new level_param_core(level_kind::Param, n)); }
-level mk_global_univ(name const & n) { return level(new level_param_core(level_kind::Global, n)); }
-level mk_meta_univ(name const & n) { return level(new level_param_core(level_kind::Meta, n)); }
+level mk_param_univ(name const & n) { return mk_param_core(level_kind::Param, n); }
+level mk_global_univ(name const & n) { return mk_param_core(level_kind::Global, n); }
+level mk_meta_univ(name const & n) { return mk_param_core(level_kind::Meta, n); }
 
 static level * g_level_zero = nullptr;
 static level * g_level_one  = nullptr;
@@ -272,6 +437,8 @@ bool operator==(level const & l1, level const & l2) {
     if (kind(l1) != kind(l2)) return false;
     if (hash(l1) != hash(l2)) return false;
     if (is_eqp(l1, l2))       return true;
+    if (to_cell(l1).m_interned && to_cell(l2).m_interned)
+        return false; // hash-consed levels are equal iff they are pointer equal
     switch (kind(l1)) {
     case level_kind::Zero:
         return true;
@@ -616,7 +783,7 @@ level mk_succ(level l, unsigned k) {
     return l;
 }
 
-level normalize(level const & l) {
+static level normalize_core(level const & l) {
     auto p = to_offset(l);
     level const & r = p.first;
     switch (kind(r)) {
@@ -683,6 +850,62 @@ level normalize(level const & l) {
     lean_unreachable(); // LCOV_EXCL_LINE
 }
 
+/** \brief Direct mapped cache for the results of normalize. */
+class level_normalize_cache {
+    std::vector<optional<pair<level, level>>> m_cache;
+public:
+    level_normalize_cache() { m_cache.resize(LEAN_LEVEL_NORMALIZE_CACHE_SIZE); }
+    optional<level> find(level const & l) const {
+        if (auto const & it = m_cache[hash(l) % LEAN_LEVEL_NORMALIZE_CACHE_SIZE]) {
+            if (is_eqp(it->first, l))
+                return some_level(it->second);
+        }
+        return none_level();
+    }
+    void insert(level const & l, level const & r) {
+        m_cache[hash(l) % LEAN_LEVEL_NORMALIZE_CACHE_SIZE] = mk_pair(l, r);
+    }
+};
+
+/** \brief Direct mapped cache for the results of is_geq. */
+class level_geq_cache {
+    struct entry {
+        level m_lhs;
+        level m_rhs;
+        bool  m_result;
+        entry(level const & l1, level const & l2, bool r):m_lhs(l1), m_rhs(l2), m_result(r) {}
+    };
+    std::vector<optional<entry>> m_cache;
+    static unsigned idx(level const & l1, level const & l2) { return hash(hash(l1), hash(l2)) % LEAN_LEVEL_GEQ_CACHE_SIZE; }
+public:
+    level_geq_cache() { m_cache.resize(LEAN_LEVEL_GEQ_CACHE_SIZE); }
+    optional<bool> find(level const & l1, level const & l2) const {
+        if (auto const & it = m_cache[idx(l1, l2)]) {
+            if (is_eqp(it->m_lhs, l1) && is_eqp(it->m_rhs, l2))
+                return optional<bool>(it->m_result);
+        }
+        return optional<bool>();
+    }
+    void insert(level const & l1, level const & l2, bool r) {
+        m_cache[idx(l1, l2)] = entry(l1, l2, r);
+    }
+};
+
+MK_THREAD_LOCAL_GET_DEF(level_normalize_cache, get_level_normalize_cache);
+MK_THREAD_LOCAL_GET_DEF(level_geq_cache, get_level_geq_cache);
+
+level normalize(level const & l) {
+    if (!is_composite(l))
+        return l;
+    // Remark: the caches compare levels using pointer equality, and keep them alive.
+    level_normalize_cache & cache = get_level_normalize_cache();
+    if (auto r = cache.find(l))
+        return *r;
+    level r = normalize_core(l);
+    cache.insert(l, r);
+    return r;
+}
+
 bool is_equivalent(level const & lhs, level const & rhs) {
     check_system("level constraints");
     return lhs == rhs || normalize(lhs) == normalize(rhs);
@@ -708,20 +931,36 @@ bool is_geq_core(level l1, level l2) {
     return false;
 }
 bool is_geq(level const & l1, level const & l2) {
-    return is_geq_core(normalize(l1), normalize(l2));
+    if (is_eqp(l1, l2) || is_zero(l2))
+        return true;
+    level_geq_cache & cache = get_level_geq_cache();
+    if (auto r = cache.find(l1, l2))
+        return *r;
+    bool r = is_geq_core(normalize(l1), normalize(l2));
+    cache.insert(l1, l2, r);
+    return r;
 }
 levels param_names_to_levels(level_param_names const & ps) {
     return map2<level>(ps, [](name const & p) { return mk_param_univ(p); });
 }
 
 void initialize_level() {
-    g_level_zero = new level(new level_cell(level_kind::Zero, 7u));
-    g_level_one  = new level(mk_succ(mk_level_zero()));
+#if defined(LEAN_HASH_CONS_LEVELS)
+    g_level_table = new level_table();
+    g_level_zero  = new level(g_level_table->find_or_insert(level_kind::Zero, 7u, []() {
+                return new level_cell(level_kind::Zero, 7u);
+            }));
+#else
+    g_level_zero  = new level(new level_cell(level_kind::Zero, 7u));
+#endif
+    g_level_one   = new level(mk_succ(mk_level_zero()));
 }
 
 void finalize_level() {
     delete g_level_one;
     delete g_level_zero;
+    delete g_level_table;
+    g_level_table = nullptr;
 }
 }
 void print(lean::level const & l) { std::cout << l << std::endl; }
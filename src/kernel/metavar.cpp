@@ -7,6 +7,7 @@ Author: Leonardo de Moura
 #include <utility>
 #include <vector>
 #include "util/interrupt.h"
+#include "util/flet.h"
 #include "kernel/metavar.h"
 #include "kernel/free_vars.h"
 #include "kernel/justification.h"
@@ -22,8 +23,26 @@ Author: Leonardo de Moura
 #define LEAN_INSTANTIATE_METAVARS_CACHE_CAPACITY 1024*8
 #endif
 
+#ifndef LEAN_SUBST_INSTANTIATE_CACHE_CAPACITY
+#define LEAN_SUBST_INSTANTIATE_CACHE_CAPACITY 1024
+#endif
+
+// Terms with a smaller weight are cheap to instantiate, and they are not stored in the instantiation cache.
+#ifndef LEAN_SUBST_INSTANTIATE_CACHE_MIN_WEIGHT
+#define LEAN_SUBST_INSTANTIATE_CACHE_MIN_WEIGHT 8
+#endif
+
 namespace lean {
-substitution::substitution() {}
+substitution::substitution():m_expr_filter(0), m_version(0), m_inst_cache_size(0), m_assignment_filters() {}
+
+int substitution::inst_key_cmp::operator()(expr const & e1, expr const & e2) const {
+    if (e1.hash() != e2.hash())
+        return e1.hash() < e2.hash() ? -1 : 1;
+    else if (is_eqp(e1, e2))
+        return 0;
+    else
+        return e1.raw() < e2.raw() ? -1 : 1;
+}
 
 bool substitution::is_expr_assigned(name const & m) const {
     return m_expr_subst.contains(m);
@@ -65,15 +84,42 @@ void substitution::assign(expr const & mvar, buffer<expr> const & locals, expr c
 }
 
 void substitution::assign(name const & m, expr const & t, justification const & j) {
+    if (m_inst_cache_size > 0 && is_expr_assigned(m))
+        clear_instantiation_cache(); // cached results may depend on the previous assignment
+    update(m, t, j);
+    m_assignment_filters[m_version % LEAN_SUBST_ASSIGNMENT_LOG_SIZE] = mk_mlocal_filter(m);
+    m_version++;
+}
+
+void substitution::update(name const & m, expr const & t, justification const & j) {
     lean_assert(closed(t));
     lean_assert(!is_metavar(t) || m != mlocal_name(t));
     m_expr_subst.insert(m, t);
+    m_expr_filter |= mk_mlocal_filter(m);
     m_occs_map.erase(m);
     if (!j.is_none())
         m_expr_jsts.insert(m, j);
 }
 
 void substitution::assign(name const & m, level const & l, justification const & j) {
+    if (m_inst_cache_size > 0 && is_level_assigned(m))
+        clear_instantiation_cache();
+    update(m, l, j);
+    m_assignment_filters[m_version % LEAN_SUBST_ASSIGNMENT_LOG_SIZE] = 0;
+    m_version++;
+}
+
+unsigned substitution::get_filter_since(unsigned v) const {
+    lean_assert(v <= m_version);
+    if (m_version - v > LEAN_SUBST_ASSIGNMENT_LOG_SIZE)
+        return m_expr_filter;
+    unsigned r = 0;
+    for (; v < m_version; v++)
+        r |= m_assignment_filters[v % LEAN_SUBST_ASSIGNMENT_LOG_SIZE];
+    return r;
+}
+
+void substitution::update(name const & m, level const & l, justification const & j) {
     m_level_subst.insert(m, l);
     if (!j.is_none())
         m_level_jsts.insert(m, j);
@@ -93,10 +139,10 @@ pair<level, justification> substitution::instantiate_metavars(level const & l, b
                     auto p2 = instantiate_metavars(p1->first, use_jst);
                     if (use_jst) {
                         justification new_jst = mk_composite1(p1->second, p2.second);
-                        assign(meta_id(l), p2.first, new_jst);
+                        update(meta_id(l), p2.first, new_jst);
                         save_jst(new_jst);
                     } else {
-                        assign(meta_id(l), p2.first);
+                        update(meta_id(l), p2.first, justification());
                     }
                     return some_level(p2.first);
                 }
@@ -118,9 +164,19 @@ protected:
     bool           m_use_jst;
     // if m_inst_local_types, then instantiate metavariables nested in the types of local constants and metavariables.
     bool           m_inst_local_types;
+    // subterms \c e such that <tt>(get_mlocal_filter(e) & m_filter) == 0</tt> do not contain assigned metavariables
+    // (when they do not contain universe metavariables).
+    unsigned       m_filter;
 
     void save_jst(justification const & j) { m_jst = mk_composite1(m_jst, j); }
 
+    /** \brief Instantiate the value \c v assigned to a metavariable. */
+    pair<expr, justification> visit_assignment(expr const & v) {
+        instantiate_metavars_fn fn(m_subst, true, false);
+        expr r = fn(v);
+        return mk_pair(r, fn.get_justification());
+    }
+
     level visit_level(level const & l) {
         auto p1 = m_subst.instantiate_metavars(l, m_use_jst);
         if (m_use_jst)
@@ -151,14 +207,14 @@ protected:
                     save_jst(p1->second);
                 return p1->first;
             } else if (m_use_jst) {
-                auto p2 = m_subst.instantiate_metavars(p1->first);
+                auto p2 = visit_assignment(p1->first);
                 justification new_jst = mk_composite1(p1->second, p2.second);
-                m_subst.assign(m_name, p2.first, new_jst);
+                m_subst.update(m_name, p2.first, new_jst);
                 save_jst(new_jst);
                 return p2.first;
             } else {
-                auto p2 = m_subst.instantiate_metavars(p1->first);
-                m_subst.assign(m_name, p2.first, mk_composite1(p1->second, p2.second));
+                auto p2 = visit_assignment(p1->first);
+                m_subst.update(m_name, p2.first, mk_composite1(p1->second, p2.second));
                 return p2.first;
             }
         } else {
@@ -177,6 +233,8 @@ protected:
                 if (m_use_jst)
                     save_jst(p1->second);
                 expr new_app = apply_beta(p1->first, args.size(), args.data());
+                // the assignment may contain metavariables that are not in m_filter
+                flet<unsigned> set(m_filter, m_subst.m_expr_filter);
                 return visit(new_app);
             }
         }
@@ -218,6 +276,8 @@ protected:
     expr visit(expr const & e) {
         if (!has_metavar(e))
             return e;
+        if (!has_univ_metavar(e) && (get_mlocal_filter(e) & m_filter) == 0)
+            return e; // e does not contain assigned metavariables
         check_system("instantiate metavars");
 
         if (auto it = m_cache->find(e))
@@ -242,24 +302,72 @@ protected:
     }
 
 public:
+    instantiate_metavars_fn(substitution & s, bool use_jst, bool inst_local_types, unsigned filter):
+        m_subst(s), m_use_jst(use_jst), m_inst_local_types(inst_local_types), m_filter(filter) {}
     instantiate_metavars_fn(substitution & s, bool use_jst, bool inst_local_types):
-        m_subst(s), m_use_jst(use_jst), m_inst_local_types(inst_local_types) {}
+        instantiate_metavars_fn(s, use_jst, inst_local_types, s.m_expr_filter) {}
     justification const & get_justification() const { return m_jst; }
     expr operator()(expr const & e) { return visit(e); }
 };
 
+void substitution::cache_instantiation(expr const & e, bool inst_local_types, inst_entry const & entry) {
+    if (get_weight(e) < LEAN_SUBST_INSTANTIATE_CACHE_MIN_WEIGHT)
+        return;
+    inst_cache & cache = m_inst_cache[inst_local_types];
+    if (!cache.contains(e)) {
+        if (m_inst_cache_size >= LEAN_SUBST_INSTANTIATE_CACHE_CAPACITY)
+            clear_instantiation_cache();
+        m_inst_cache_size++;
+    }
+    m_inst_cache[inst_local_types].insert(e, entry);
+}
+
+void substitution::clear_instantiation_cache() {
+    m_inst_cache[0].clear();
+    m_inst_cache[1].clear();
+    m_inst_cache_size = 0;
+}
+
 pair<expr, justification> substitution::instantiate_metavars_core(expr const & e, bool inst_local_types) {
-    if (!has_metavar(e)) {
+    if (!has_metavar(e))
         return mk_pair(e, justification());
-    } else {
-        instantiate_metavars_fn fn(*this, true, inst_local_types);
-        expr r = fn(e);
-        return mk_pair(r, fn.get_justification());
+    expr          start  = e;
+    justification start_jst;
+    unsigned      filter = m_expr_filter;
+    if (auto it = m_inst_cache[inst_local_types].find(e)) {
+        if (it->m_use_jst) {
+            if (it->m_version == m_version)
+                return mk_pair(it->m_result, it->m_jst);
+            // only the metavariables assigned after the entry was created must be instantiated
+            start     = it->m_result;
+            start_jst = it->m_jst;
+            filter    = get_filter_since(it->m_version);
+        }
     }
+    instantiate_metavars_fn fn(*this, true, inst_local_types, filter);
+    expr r          = fn(start);
+    justification j = mk_composite1(start_jst, fn.get_justification());
+    cache_instantiation(e, inst_local_types, inst_entry(m_version, true, r, j));
+    return mk_pair(r, j);
 }
 
 expr substitution::instantiate_metavars_wo_jst(expr const & e, bool inst_local_types) {
-    return instantiate_metavars_fn(*this, false, inst_local_types)(e);
+    if (!has_metavar(e))
+        return e;
+    expr start      = e;
+    bool keep       = false; // true if the cache contains an entry with justification for e
+    unsigned filter = m_expr_filter;
+    if (auto it = m_inst_cache[inst_local_types].find(e)) {
+        if (it->m_version == m_version)
+            return it->m_result;
+        start  = it->m_result;
+        keep   = it->m_use_jst;
+        filter = get_filter_since(it->m_version);
+    }
+    expr r = instantiate_metavars_fn(*this, false, inst_local_types, filter)(start);
+    if (!keep)
+        cache_instantiation(e, inst_local_types, inst_entry(m_version, false, r, justification()));
+    return r;
 }
 
 auto substitution::expand_metavar_app(expr const & e) -> opt_expr_jst {
@@ -334,10 +442,14 @@ name_set substitution::get_occs(name const & m, name_set & fresh) {
 bool substitution::occurs_expr(name const & m, expr const & e) {
     if (!has_expr_metavar(e))
         return false;
+    // metavariables that are not m and are not assigned can be ignored
+    unsigned filter = mk_mlocal_filter(m) | m_expr_filter;
+    if ((get_mlocal_filter(e) & filter) == 0)
+        return false;
     name_set fresh;
     bool found = false;
     for_each(e, [&](expr const & e, unsigned) {
-            if (found || !has_expr_metavar(e)) return false;
+            if (found || !has_expr_metavar(e) || (get_mlocal_filter(e) & filter) == 0) return false;
             if (is_metavar(e)) {
                 name const & n = mlocal_name(e);
                 if (is_expr_assigned(n)) {
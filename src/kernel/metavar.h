@@ -13,6 +13,10 @@ Author: Leonardo de Moura
 #include "kernel/expr.h"
 #include "kernel/justification.h"
 
+#ifndef LEAN_SUBST_ASSIGNMENT_LOG_SIZE
+#define LEAN_SUBST_ASSIGNMENT_LOG_SIZE 16
+#endif
+
 namespace lean {
 class substitution {
 public:
@@ -34,11 +38,55 @@ private:
         This mapping is built (and updated) on demand, and is used to improve the performance of #occurs_expr.
     */
     occs_map  m_occs_map;
+    /** \brief Union of the filters (see #mk_mlocal_filter) of the assigned metavariables in m_expr_subst.
+        If <tt>(get_mlocal_filter(e) & m_expr_filter) == 0</tt>, then \c e does not contain assigned metavariables.
+        \remark The filter of a term also covers its local constants, and the bits of m_expr_filter are all set
+        after a few dozen assignments. So this test only prunes a few of the subterms visited during elaboration. */
+    unsigned  m_expr_filter;
+
+    /** \brief Result of instantiating the metavariables of an expression using this substitution. */
+    struct inst_entry {
+        unsigned      m_version; // value of m_version when m_result was computed
+        bool          m_use_jst; // true iff m_jst is the justification for m_result
+        expr          m_result;
+        justification m_jst;
+        inst_entry():m_version(0), m_use_jst(false) {}
+        inst_entry(unsigned v, bool use_jst, expr const & r, justification const & j):
+            m_version(v), m_use_jst(use_jst), m_result(r), m_jst(j) {}
+    };
+    /** \brief Total order on expressions based on their hash codes and addresses. */
+    struct inst_key_cmp { int operator()(expr const & e1, expr const & e2) const; };
+    typedef rb_map<expr, inst_entry, inst_key_cmp> inst_cache;
+    /** \brief m_version is incremented whenever a new assignment is made. Entries of m_inst_cache
+        created at an older version are not discarded: since assignments are never removed, their results
+        are still correct modulo the new assignments. So, they are instantiated again, and the cost is
+        proportional to the number of new assignments occurring in them.
+        The cache is copied with the substitution, and m_inst_cache[1] is used by instantiate_all.
+    */
+    unsigned   m_version;
+    inst_cache m_inst_cache[2];
+    unsigned   m_inst_cache_size;
+    /** \brief m_assignment_filters[v % LEAN_SUBST_ASSIGNMENT_LOG_SIZE] is the filter of the metavariable assigned
+        when m_version was incremented from \c v to <tt>v+1</tt> (0 for universe metavariables). Only the filters of
+        the last LEAN_SUBST_ASSIGNMENT_LOG_SIZE assignments are available.
+        They are used to instantiate the outdated entries of m_inst_cache: the new assignments are usually few,
+        and their filters do not saturate like m_expr_filter. */
+    unsigned   m_assignment_filters[LEAN_SUBST_ASSIGNMENT_LOG_SIZE];
 
     friend class instantiate_metavars_fn;
     pair<level, justification> instantiate_metavars(level const & l, bool use_jst);
     expr instantiate_metavars_wo_jst(expr const & e, bool inst_local_types);
     pair<expr, justification> instantiate_metavars_core(expr const & e, bool inst_local_types);
+    void cache_instantiation(expr const & e, bool inst_local_types, inst_entry const & entry);
+    /** \brief Return a filter for the metavariables assigned after version \c v, i.e., if
+        <tt>(get_mlocal_filter(e) & get_filter_since(v)) == 0</tt>, then \c e does not contain metavariables
+        assigned after \c v. */
+    unsigned get_filter_since(unsigned v) const;
+    void clear_instantiation_cache();
+    /** \brief Store an assignment that is equivalent to the current one for \c m (e.g., when the
+        assigned value is instantiated), and consequently does not change m_version. */
+    void update(name const & m, expr const & t, justification const & j);
+    void update(name const & m, level const & t, justification const & j);
     bool occurs_expr_core(name const & m, expr const & e, name_set & visited) const;
     name_set get_occs(name const & m, name_set & fresh);
 
@@ -90,7 +138,7 @@ public:
     /** \brief Similar to instantiate, but also substitute metavariables occurring in the types of local constansts and metavariables */
     expr instantiate_all(expr const & e) { return instantiate_metavars_wo_jst(e, true); }
 
-    void forget_justifications() { m_expr_jsts  = jst_map(); m_level_jsts = jst_map(); }
+    void forget_justifications() { m_expr_jsts  = jst_map(); m_level_jsts = jst_map(); clear_instantiation_cache(); }
 
     template<typename F>
     void for_each_expr(F && fn) const {
@@ -431,6 +431,12 @@ type_checker::type_checker(environment const & env):
 
 type_checker::~type_checker() {}
 
+void type_checker::set_env(environment const & env) {
+    lean_assert(env.is_descendant(m_env));
+    m_env = env;
+    m_conv->set_env(env);
+}
+
 optional<expr> type_checker::is_stuck(expr const & e) {
     if (is_meta(e)) {
         return some_expr(e);
@@ -472,27 +478,39 @@ static void check_duplicated_params(environment const & env, declaration const &
     }
 }
 
-certified_declaration check(environment const & env, declaration const & d, name_generator const & g) {
+static void check_header(environment const & env, declaration const & d) {
     if (d.is_definition())
         check_no_mlocal(env, d.get_name(), d.get_value(), false);
     check_no_mlocal(env, d.get_name(), d.get_type(), true);
     check_name(env, d.get_name());
     check_duplicated_params(env, d);
+}
+
+static void check_type(type_checker & checker, declaration const & d) {
+    expr sort = checker.check(d.get_type(), d.get_univ_params()).first;
+    checker.ensure_sort(sort, d.get_type());
+}
+
+static void check_value(type_checker & checker, environment const & env, declaration const & d) {
+    expr val_type = checker.check(d.get_value(), d.get_univ_params()).first;
+    if (!checker.is_def_eq(val_type, d.get_type()).first) {
+        throw_kernel_exception(env, d.get_value(), [=](formatter const & fmt) {
+                return pp_def_type_mismatch(fmt, d.get_name(), d.get_type(), val_type);
+            });
+    }
+}
+
+certified_declaration check(environment const & env, declaration const & d, name_generator const & g) {
+    check_header(env, d);
     bool memoize = true;
     type_checker checker1(env, g, std::unique_ptr<converter>(new default_converter(env, optional<module_idx>(), memoize)));
-    expr sort = checker1.check(d.get_type(), d.get_univ_params()).first;
-    checker1.ensure_sort(sort, d.get_type());
+    check_type(checker1, d);
     if (d.is_definition()) {
         optional<module_idx> midx;
         if (d.is_opaque())
             midx = optional<module_idx>(d.get_module_idx());
         type_checker checker2(env, g, std::unique_ptr<converter>(new default_converter(env, midx, memoize)));
-        expr val_type = checker2.check(d.get_value(), d.get_univ_params()).first;
-        if (!checker2.is_def_eq(val_type, d.get_type()).first) {
-            throw_kernel_exception(env, d.get_value(), [=](formatter const & fmt) {
-                    return pp_def_type_mismatch(fmt, d.get_name(), d.get_type(), val_type);
-                });
-        }
+        check_value(checker2, env, d);
     }
     return certified_declaration(env.get_id(), d);
 }
@@ -501,6 +519,29 @@ certified_declaration check(environment const & env, declaration const & d) {
     return check(env, d, name_generator(*g_tmp_prefix));
 }
 
+batch_checker::batch_checker():m_ngen(*g_tmp_prefix) {}
+batch_checker::~batch_checker() {}
+
+certified_declaration batch_checker::check(environment const & env, declaration const & d) {
+    if (d.is_definition() && d.is_opaque()) {
+        // the value of opaque definitions must be checked using a converter for their module
+        return ::lean::check(env, d, m_ngen.mk_child());
+    }
+    check_header(env, d);
+    if (m_tc && env.is_descendant(m_tc->env()) && m_univ_params == d.get_univ_params()) {
+        m_tc->set_env(env);
+    } else {
+        bool memoize   = true;
+        m_tc.reset(new type_checker(env, m_ngen.mk_child(),
+                                    std::unique_ptr<converter>(new default_converter(env, optional<module_idx>(), memoize))));
+        m_univ_params = d.get_univ_params();
+    }
+    check_type(*m_tc, d);
+    if (d.is_definition())
+        check_value(*m_tc, env, d);
+    return certified_declaration(env.get_id(), d);
+}
+
 void initialize_type_checker() {
     g_tmp_prefix = new name(name::mk_internal_unique_name());
 }
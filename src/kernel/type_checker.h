@@ -127,6 +127,10 @@ public:
     ~type_checker();
 
     environment const & env() const { return m_env; }
+    /** \brief Replace the environment used by this type checker with \c env.
+        The cached information is preserved.
+        \pre \c env is a descendant of env() */
+    void set_env(environment const & env);
     name_generator mk_ngen() { return m_gen.mk_child(); }
     name mk_fresh_name() { return m_gen.next(); }
     /**
@@ -236,6 +240,26 @@ void check_no_metavar(environment const & env, name const & n, expr const & e, b
 certified_declaration check(environment const & env, declaration const & d, name_generator const & g);
 certified_declaration check(environment const & env, declaration const & d);
 
+/**
+   \brief Type check a sequence of related declarations (e.g., the auxiliary declarations
+   created by the \c inductive and \c structure commands) using a single type checker.
+
+   The caches of the type checker are reused by all declarations. This is sound because each
+   declaration must be checked with respect to a descendant of the environment used to check
+   the previous one, and declarations are never removed from an environment.
+   If this is not the case, or the universe level parameters of the new declaration are
+   different from the previous one, then a fresh type checker is used.
+*/
+class batch_checker {
+    name_generator                m_ngen;
+    std::unique_ptr<type_checker> m_tc;
+    level_param_names             m_univ_params;
+public:
+    batch_checker();
+    ~batch_checker();
+    certified_declaration check(environment const & env, declaration const & d);
+};
+
 /**
     \brief Create a justification for an application \c e where the expected type must be \c d_type and
     the argument type is \c a_type.
@@ -7,6 +7,7 @@ Author: Leonardo de Moura
 #include <string>
 #include "util/lbool.h"
 #include "util/sstream.h"
+#include "util/pvector.h"
 #include "kernel/instantiate.h"
 #include "library/scoped_ext.h"
 #include "library/kernel_serializer.h"
@@ -33,7 +34,7 @@ struct class_entry {
 };
 
 struct class_state {
-    typedef name_map<list<name>> class_instances;
+    typedef name_map<pvector<name>> class_instances;
     typedef name_map<unsigned>   instance_priorities;
     class_instances     m_instances;
     instance_priorities m_priorities;
@@ -54,28 +55,44 @@ struct class_state {
         return m_multiple.contains(c);
     }
 
-    list<name> insert(name const & inst, unsigned priority, list<name> const & insts) const {
-        if (!insts)
-            return to_list(inst);
-        else if (priority >= get_priority(head(insts)))
-            return list<name>(inst, insts);
-        else
-            return list<name>(head(insts), insert(inst, priority, tail(insts)));
+    /** \brief Insert \c inst in \c insts. The instances are sorted by priority, and the last one
+        is the first to be tried. So, in the common case (default priority), this is just a push_back. */
+    pvector<name> insert(name const & inst, unsigned priority, pvector<name> insts) const {
+        buffer<name> higher;
+        while (!insts.empty() && priority < get_priority(insts.back())) {
+            higher.push_back(insts.back());
+            insts.pop_back();
+        }
+        insts.push_back(inst);
+        unsigned i = higher.size();
+        while (i > 0) {
+            --i;
+            insts.push_back(higher[i]);
+        }
+        return insts;
     }
 
     void add_class(name const & c) {
         auto it = m_instances.find(c);
         if (!it)
-            m_instances.insert(c, list<name>());
+            m_instances.insert(c, pvector<name>());
     }
 
     void add_instance(name const & c, name const & i, unsigned p) {
         auto it = m_instances.find(c);
         if (!it) {
-            m_instances.insert(c, to_list(i));
+            pvector<name> insts;
+            insts.push_back(i);
+            m_instances.insert(c, insts);
         } else {
-            auto lst = filter(*it, [&](name const & i1) { return i1 != i; });
-            m_instances.insert(c, insert(i, p, lst));
+            pvector<name> insts = *it;
+            if (is_instance(i)) {
+                // instance is being redeclared
+                pvector<name> new_insts;
+                insts.for_each([&](name const & i1) { if (i1 != i) new_insts.push_back(i1); });
+                insts = new_insts;
+            }
+            m_instances.insert(c, insert(i, p, insts));
         }
         m_priorities.insert(i, p);
     }
@@ -177,7 +194,7 @@ environment add_class(environment const & env, name const & n, bool persistent)
 
 void get_classes(environment const & env, buffer<name> & classes) {
     class_state const & s = class_ext::get_state(env);
-    s.m_instances.for_each([&](name const & c, list<name> const &) {
+    s.m_instances.for_each([&](name const & c, pvector<name> const &) {
             classes.push_back(c);
         });
 }
@@ -223,9 +240,12 @@ bool is_instance(environment const & env, name const & i) {
     return s.is_instance(i);
 }
 
-list<name> get_class_instances(environment const & env, name const & c) {
+pvector<name> get_class_instances(environment const & env, name const & c) {
     class_state const & s = class_ext::get_state(env);
-    return ptr_to_list(s.m_instances.find(c));
+    if (auto it = s.m_instances.find(c))
+        return *it;
+    else
+        return pvector<name>();
 }
 
 /** \brief If the constant \c e is a class, return its name */
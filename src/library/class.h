@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include "util/pvector.h"
 
 namespace lean {
 /** \brief Add a new 'class' to the environment (if it is not already declared) */
@@ -17,8 +18,9 @@ environment add_instance(environment const & env, name const & n, unsigned prior
 bool is_class(environment const & env, name const & c);
 /** \brief Return true iff \c i was declared with \c add_instance. */
 bool is_instance(environment const & env, name const & i);
-/** \brief Return the instances of the given class. */
-list<name> get_class_instances(environment const & env, name const & c);
+/** \brief Return the instances of the given class.
+    They are sorted by priority, and the last one is the first to be tried. */
+pvector<name> get_class_instances(environment const & env, name const & c);
 /** \brief Return the classes in the given environment. */
 void get_classes(environment const & env, buffer<name> & classes);
 name get_class_name(environment const & env, expr const & e);
@@ -6,6 +6,7 @@ Author: Leonardo de Moura
 */
 #include <utility>
 #include <string>
+#include <algorithm>
 #include "util/rb_map.h"
 #include "util/sstream.h"
 #include "kernel/instantiate.h"
@@ -55,8 +56,15 @@ struct coercion_info {
         m_fun(f), m_fun_type(f_type), m_level_params(ls), m_num_args(num), m_to(cls) {}
 };
 
+/** \brief Coercions from a given class indexed by the target class. The most recent coercions occur first. */
+typedef rb_map<coercion_class, list<coercion_info>, coercion_class_cmp_fn> coercion_to_map;
+
 struct coercion_state {
+    // m_coercion_info contains all coercions from a given class, the most recent ones first.
     name_map<list<coercion_info>>                             m_coercion_info;
+    // m_from_to is indexed by (from-class, to-class).
+    // It is used to retrieve the coercions C >-> D without traversing all coercions from C.
+    name_map<coercion_to_map>                                 m_from_to;
     // m_from and m_to contain "direct" coercions
     typedef std::tuple<coercion_class, expr, expr>            from_data;
     name_map<list<from_data>>                                 m_from; // map user-class -> list of (class, coercion-fun)
@@ -65,15 +73,23 @@ struct coercion_state {
 
     template<typename F>
     void for_each_info(name const & from, coercion_class const & to, F && f) {
-        auto it = m_coercion_info.find(from);
-        lean_assert(it);
-        for (coercion_info info : *it) {
-            if (info.m_to == to) {
-                f(info);
-            }
+        auto it1 = m_from_to.find(from);
+        lean_assert(it1);
+        auto it2 = it1->find(to);
+        lean_assert(it2);
+        for (coercion_info info : *it2) {
+            f(info);
         }
     }
 
+    /** \brief Return all coercions from \c C, the most recent ones first. */
+    list<coercion_info> get_infos(name const & C) const {
+        if (auto it = m_coercion_info.find(C))
+            return *it;
+        else
+            return list<coercion_info>();
+    }
+
     void update_from_to(type_checker & tc, name const & C, coercion_class const & D,
                         expr const & f, expr const & f_type, io_state const & ios) {
         auto it1 = m_from.find(C);
@@ -252,18 +268,37 @@ struct add_coercion_fn {
 
     void add_coercion_core(name const & C, expr const & f, expr const & f_type,
                            level_param_names const & ls, unsigned num_args, coercion_class const & cls) {
-        auto it = m_state.m_coercion_info.find(C);
-        if (!it) {
-            list<coercion_info> infos(coercion_info(f, f_type, ls, num_args, cls));
-            m_state.m_coercion_info.insert(C, infos);
+        coercion_info new_info(f, f_type, ls, num_args, cls);
+        // coercions C >-> cls replaced by the new one
+        buffer<coercion_info> replaced;
+        coercion_to_map to_map;
+        if (auto it = m_state.m_from_to.find(C))
+            to_map = *it;
+        if (auto it = to_map.find(cls)) {
+            list<coercion_info> infos = filter(*it, [&](coercion_info const & info) {
+                    if (m_tc.is_def_eq(info.m_fun_type, f_type).first) {
+                        replaced.push_back(info);
+                        return false;
+                    }
+                    return true;
+                });
+            to_map.insert(cls, cons(new_info, infos));
         } else {
-            list<coercion_info> infos = *it;
+            to_map.insert(cls, list<coercion_info>(new_info));
+        }
+        m_state.m_from_to.insert(C, to_map);
+        list<coercion_info> infos;
+        if (auto it = m_state.m_coercion_info.find(C))
+            infos = *it;
+        if (!replaced.empty()) {
+            // both stores contain copies of the same coercion_info objects, so pointer equality is used
             infos = filter(infos, [&](coercion_info const & info) {
-                    return info.m_to != cls || !m_tc.is_def_eq(info.m_fun_type, f_type).first;
+                    return !std::any_of(replaced.begin(), replaced.end(), [&](coercion_info const & r) {
+                            return is_eqp(info.m_fun, r.m_fun) && is_eqp(info.m_fun_type, r.m_fun_type) && info.m_to == r.m_to;
+                        });
                 });
-            infos = cons(coercion_info(f, f_type, ls, num_args, cls), infos);
-            m_state.m_coercion_info.insert(C, infos);
         }
+        m_state.m_coercion_info.insert(C, cons(new_info, infos));
         if (is_constant(f))
             m_state.m_coercions.insert(const_name(f), mk_pair(C, num_args));
     }
@@ -443,10 +478,11 @@ bool has_coercions_from(environment const & env, expr const & C) {
     auto it = ext.m_coercion_info.find(const_name(C_fn));
     if (!it)
         return false;
-    list<coercion_info> const & cs = *it;
+    // check the most recent coercion from C
+    coercion_info const & info = head(*it);
     return
-        head(cs).m_num_args == get_app_num_args(C) &&
-        length(head(cs).m_level_params) == length(const_levels(C_fn));
+        info.m_num_args == get_app_num_args(C) &&
+        length(info.m_level_params) == length(const_levels(C_fn));
 }
 
 list<expr> get_coercions(environment const & env, expr const & C, coercion_class const & D) {
@@ -455,12 +491,16 @@ list<expr> get_coercions(environment const & env, expr const & C, coercion_class
     if (!is_constant(C_fn))
         return list<expr>();
     coercion_state const & ext = coercion_ext::get_state(env);
-    auto it = ext.m_coercion_info.find(const_name(C_fn));
+    auto it1 = ext.m_from_to.find(const_name(C_fn));
+    if (!it1)
+        return list<expr>();
+    auto it = it1->find(D);
     if (!it)
         return list<expr>();
     buffer<expr> r;
     for (coercion_info const & info : *it) {
-        if (info.m_to == D && info.m_num_args == args.size() && length(info.m_level_params) == length(const_levels(C_fn))) {
+        lean_assert(info.m_to == D);
+        if (info.m_num_args == args.size() && length(info.m_level_params) == length(const_levels(C_fn))) {
             expr f = instantiate_univ_params(info.m_fun, info.m_level_params, const_levels(C_fn));
             r.push_back(apply_beta(f, args.size(), args.data()));
         }
@@ -472,6 +512,39 @@ list<expr> get_coercions(environment const & env, expr const & C, name const & D
     return get_coercions(env, C, coercion_class::mk_user(D));
 }
 
+optional<expr> get_coercion(environment const & env, expr const & C, coercion_class const & D) {
+    buffer<expr> args;
+    expr const & C_fn = get_app_rev_args(C, args);
+    if (!is_constant(C_fn))
+        return none_expr();
+    coercion_state const & ext = coercion_ext::get_state(env);
+    auto it1 = ext.m_from_to.find(const_name(C_fn));
+    if (!it1)
+        return none_expr();
+    auto it = it1->find(D);
+    if (!it)
+        return none_expr();
+    for (coercion_info const & info : *it) {
+        if (info.m_num_args == args.size() && length(info.m_level_params) == length(const_levels(C_fn))) {
+            expr f = instantiate_univ_params(info.m_fun, info.m_level_params, const_levels(C_fn));
+            return some_expr(apply_beta(f, args.size(), args.data()));
+        }
+    }
+    return none_expr();
+}
+
+optional<expr> get_coercion(environment const & env, expr const & C, name const & D) {
+    return get_coercion(env, C, coercion_class::mk_user(D));
+}
+
+optional<expr> get_coercion_to_sort(environment const & env, expr const & C) {
+    return get_coercion(env, C, coercion_class::mk_sort());
+}
+
+optional<expr> get_coercion_to_fun(environment const & env, expr const & C) {
+    return get_coercion(env, C, coercion_class::mk_fun());
+}
+
 list<expr> get_coercions_to_sort(environment const & env, expr const & C) {
     return get_coercions(env, C, coercion_class::mk_sort());
 }
@@ -486,11 +559,8 @@ bool get_coercions_from(environment const & env, expr const & C, buffer<std::tup
     if (!is_constant(C_fn))
         return false;
     coercion_state const & ext = coercion_ext::get_state(env);
-    auto it = ext.m_coercion_info.find(const_name(C_fn));
-    if (!it)
-        return false;
     bool r = false;
-    for (coercion_info const & info : *it) {
+    for (coercion_info const & info : ext.get_infos(const_name(C_fn))) {
         if (info.m_num_args == args.size() &&
             length(info.m_level_params) == length(const_levels(C_fn))) {
             expr f = instantiate_univ_params(info.m_fun, info.m_level_params, const_levels(C_fn));
@@ -81,6 +81,13 @@ bool has_coercions_to_fun(environment const & env);
 list<expr> get_coercions(environment const & env, expr const & C, name const & D);
 list<expr> get_coercions_to_sort(environment const & env, expr const & C);
 list<expr> get_coercions_to_fun(environment const & env, expr const & C);
+/**
+   \brief Return the most recent coercion (if it exists) from (C_name.{l1 lk} t_1 ... t_n) to the class named D.
+   It is the coercion that occurs first in the result of get_coercions.
+*/
+optional<expr> get_coercion(environment const & env, expr const & C, name const & D);
+optional<expr> get_coercion_to_sort(environment const & env, expr const & C);
+optional<expr> get_coercion_to_fun(environment const & env, expr const & C);
 /**
    \brief Return all coercions C >-> D for the type C of the form (C_name.{l1 ... lk} t_1 ... t_n)
    The result is a tuple (class D, coercion, coercion type), and is stored in the result buffer \c result.
@@ -89,6 +89,7 @@ name const * g_tactic_identifier = nullptr;
 name const * g_tactic_identifier_list = nullptr;
 name const * g_tactic_opt_identifier_list = nullptr;
 name const * g_tactic_fail = nullptr;
+name const * g_tactic_first_success_par = nullptr;
 name const * g_tactic_fixpoint = nullptr;
 name const * g_tactic_focus_at = nullptr;
 name const * g_tactic_generalize = nullptr;
@@ -109,6 +110,9 @@ name const * g_tactic_rexact = nullptr;
 name const * g_tactic_rotate_left = nullptr;
 name const * g_tactic_rotate_right = nullptr;
 name const * g_tactic_state = nullptr;
+name const * g_tactic_tactic_list = nullptr;
+name const * g_tactic_tactic_list_cons = nullptr;
+name const * g_tactic_tactic_list_nil = nullptr;
 name const * g_tactic_trace = nullptr;
 name const * g_tactic_try_for = nullptr;
 name const * g_tactic_whnf = nullptr;
@@ -208,6 +212,7 @@ void initialize_constants() {
     g_tactic_identifier_list = new name{"tactic", "identifier_list"};
     g_tactic_opt_identifier_list = new name{"tactic", "opt_identifier_list"};
     g_tactic_fail = new name{"tactic", "fail"};
+    g_tactic_first_success_par = new name{"tactic", "first_success_par"};
     g_tactic_fixpoint = new name{"tactic", "fixpoint"};
     g_tactic_focus_at = new name{"tactic", "focus_at"};
     g_tactic_generalize = new name{"tactic", "generalize"};
@@ -228,6 +233,9 @@ void initialize_constants() {
     g_tactic_rotate_left = new name{"tactic", "rotate_left"};
     g_tactic_rotate_right = new name{"tactic", "rotate_right"};
     g_tactic_state = new name{"tactic", "state"};
+    g_tactic_tactic_list = new name{"tactic", "tactic_list"};
+    g_tactic_tactic_list_cons = new name{"tactic", "tactic_list", "cons"};
+    g_tactic_tactic_list_nil = new name{"tactic", "tactic_list", "nil"};
     g_tactic_trace = new name{"tactic", "trace"};
     g_tactic_try_for = new name{"tactic", "try_for"};
     g_tactic_whnf = new name{"tactic", "whnf"};
@@ -328,6 +336,7 @@ void finalize_constants() {
     delete g_tactic_identifier_list;
     delete g_tactic_opt_identifier_list;
     delete g_tactic_fail;
+    delete g_tactic_first_success_par;
     delete g_tactic_fixpoint;
     delete g_tactic_focus_at;
     delete g_tactic_generalize;
@@ -348,6 +357,9 @@ void finalize_constants() {
     delete g_tactic_rotate_left;
     delete g_tactic_rotate_right;
     delete g_tactic_state;
+    delete g_tactic_tactic_list;
+    delete g_tactic_tactic_list_cons;
+    delete g_tactic_tactic_list_nil;
     delete g_tactic_trace;
     delete g_tactic_try_for;
     delete g_tactic_whnf;
@@ -447,6 +459,7 @@ name const & get_tactic_identifier_name() { return *g_tactic_identifier; }
 name const & get_tactic_identifier_list_name() { return *g_tactic_identifier_list; }
 name const & get_tactic_opt_identifier_list_name() { return *g_tactic_opt_identifier_list; }
 name const & get_tactic_fail_name() { return *g_tactic_fail; }
+name const & get_tactic_first_success_par_name() { return *g_tactic_first_success_par; }
 name const & get_tactic_fixpoint_name() { return *g_tactic_fixpoint; }
 name const & get_tactic_focus_at_name() { return *g_tactic_focus_at; }
 name const & get_tactic_generalize_name() { return *g_tactic_generalize; }
@@ -467,6 +480,9 @@ name const & get_tactic_rexact_name() { return *g_tactic_rexact; }
 name const & get_tactic_rotate_left_name() { return *g_tactic_rotate_left; }
 name const & get_tactic_rotate_right_name() { return *g_tactic_rotate_right; }
 name const & get_tactic_state_name() { return *g_tactic_state; }
+name const & get_tactic_tactic_list_name() { return *g_tactic_tactic_list; }
+name const & get_tactic_tactic_list_cons_name() { return *g_tactic_tactic_list_cons; }
+name const & get_tactic_tactic_list_nil_name() { return *g_tactic_tactic_list_nil; }
 name const & get_tactic_trace_name() { return *g_tactic_trace; }
 name const & get_tactic_try_for_name() { return *g_tactic_try_for; }
 name const & get_tactic_whnf_name() { return *g_tactic_whnf; }
@@ -91,6 +91,7 @@ name const & get_tactic_identifier_name();
 name const & get_tactic_identifier_list_name();
 name const & get_tactic_opt_identifier_list_name();
 name const & get_tactic_fail_name();
+name const & get_tactic_first_success_par_name();
 name const & get_tactic_fixpoint_name();
 name const & get_tactic_focus_at_name();
 name const & get_tactic_generalize_name();
@@ -111,6 +112,9 @@ name const & get_tactic_rexact_name();
 name const & get_tactic_rotate_left_name();
 name const & get_tactic_rotate_right_name();
 name const & get_tactic_state_name();
+name const & get_tactic_tactic_list_name();
+name const & get_tactic_tactic_list_cons_name();
+name const & get_tactic_tactic_list_nil_name();
 name const & get_tactic_trace_name();
 name const & get_tactic_try_for_name();
 name const & get_tactic_whnf_name();
@@ -15,6 +15,7 @@ Author: Leonardo de Moura
 #include "kernel/error_msgs.h"
 #include "kernel/for_each_fn.h"
 #include "kernel/find_fn.h"
+#include "kernel/expr_maps.h"
 #include "library/generic_exception.h"
 #include "library/kernel_serializer.h"
 #include "library/io_state_stream.h"
@@ -33,6 +34,7 @@ static name * g_no_equation_name               = nullptr;
 static name * g_decreasing_name                = nullptr;
 static name * g_inaccessible_name              = nullptr;
 static name * g_equations_result_name          = nullptr;
+static name * g_subproblem_name                = nullptr;
 static std::string * g_equations_opcode        = nullptr;
 static std::string * g_equation_opcode         = nullptr;
 static std::string * g_no_equation_opcode      = nullptr;
@@ -229,6 +231,7 @@ void initialize_equations() {
     g_no_equation_name        = new name("no_equation");
     g_decreasing_name         = new name("decreasing");
     g_inaccessible_name       = new name("innaccessible");
+    g_subproblem_name         = new name("subproblem");
     g_equations_result_name   = new name("equations_result");
     g_equation                = new macro_definition(new equation_macro_cell());
     g_no_equation             = new macro_definition(new no_equation_macro_cell());
@@ -294,6 +297,7 @@ void finalize_equations() {
     delete g_no_equation_name;
     delete g_decreasing_name;
     delete g_inaccessible_name;
+    delete g_subproblem_name;
 }
 
 class equation_compiler_fn {
@@ -438,6 +442,12 @@ class equation_compiler_fn {
         }
     };
 
+    // Cache for compile_core. The key is the program with the local constants in its
+    // context abstracted. So, subproblems that are identical modulo the names of
+    // these local constants (e.g., the ones produced for different branches of the case tree)
+    // are compiled only once. The value is the compiled term with the same local constants abstracted.
+    expr_bi_struct_map<expr> m_cache;
+
     // Auxiliary fields for producing error messages
     buffer<program>  m_init_prgs;
     unsigned         m_prg_idx; // current program index being compiled
@@ -1006,38 +1016,70 @@ class equation_compiler_fn {
             });
     }
 
+    // Return the key for \c p in m_cache
+    expr mk_cache_key(program const & p, buffer<expr> const & ctx) const {
+        expr S = mk_constant(*g_subproblem_name);
+        buffer<expr> stack;
+        for (optional<name> const & n : p.m_var_stack)
+            stack.push_back(n ? p.get_var(*n) : S);
+        buffer<expr> eqns;
+        for (eqn const & e : p.m_eqns) {
+            buffer<expr> local_ctx, pats;
+            to_buffer(e.m_local_context, local_ctx);
+            to_buffer(e.m_patterns, pats);
+            eqns.push_back(Pi(local_ctx, mk_app(mk_app(S, pats), e.m_rhs)));
+        }
+        return Pi(ctx, mk_app({S, p.m_fn, p.m_type, mk_app(S, stack), mk_app(S, eqns)}));
+    }
+
     expr compile_core(program const & p) {
+        if (!p.m_var_stack)
+            return compile_leaf(p);
+        buffer<expr> ctx;
+        to_buffer(p.m_context, ctx);
+        expr key = mk_cache_key(p, ctx);
+        auto it  = m_cache.find(key);
+        if (it != m_cache.end())
+            return instantiate_rev(it->second, ctx.size(), ctx.data());
+        expr r   = compile_step(p);
+        m_cache.insert(mk_pair(key, abstract_locals(r, ctx.size(), ctx.data())));
+        return r;
+    }
+
+    expr compile_step(program const & p) {
         lean_assert(check_program(p));
         // out() << "compile_core step\n";
         // display(p);
         // out() << "------------------\n";
-        if (p.m_var_stack) {
-            if (!head(p.m_var_stack)) {
-                return compile_skip(p);
-            } else if (is_no_equation_constructor_transition(p)) {
-                return compile_no_equations(p);
-            } else if (is_variable_transition(p)) {
-                return compile_variable(p);
-            } else if (is_constructor_transition(p)) {
-                return compile_constructor(p);
-            } else if (is_complete_transition(p)) {
-                return compile_complete(p);
-            } else {
-                // In some equations the next pattern is an inaccessible term,
-                // and in others it is a constructor.
-                throw_error(sstream() << "invalid recursive equations for '" << local_pp_name(p.m_fn)
-                            << "', inconsistent use of inaccessible term annotation, "
-                            << "in some equations a pattern is a constructor, and in another it is an inaccessible term");
-            }
+        lean_assert(p.m_var_stack);
+        if (!head(p.m_var_stack)) {
+            return compile_skip(p);
+        } else if (is_no_equation_constructor_transition(p)) {
+            return compile_no_equations(p);
+        } else if (is_variable_transition(p)) {
+            return compile_variable(p);
+        } else if (is_constructor_transition(p)) {
+            return compile_constructor(p);
+        } else if (is_complete_transition(p)) {
+            return compile_complete(p);
         } else {
-            if (p.m_eqns) {
-                // variable stack is empty
-                expr r = head(p.m_eqns).m_rhs;
-                lean_assert(is_def_eq(infer_type(r), p.m_type));
-                return r;
-            } else {
-                throw_non_exhaustive();
-            }
+            // In some equations the next pattern is an inaccessible term,
+            // and in others it is a constructor.
+            throw_error(sstream() << "invalid recursive equations for '" << local_pp_name(p.m_fn)
+                        << "', inconsistent use of inaccessible term annotation, "
+                        << "in some equations a pattern is a constructor, and in another it is an inaccessible term");
+        }
+    }
+
+    // variable stack is empty
+    expr compile_leaf(program const & p) {
+        lean_assert(check_program(p));
+        if (p.m_eqns) {
+            expr r = head(p.m_eqns).m_rhs;
+            lean_assert(is_def_eq(infer_type(r), p.m_type));
+            return r;
+        } else {
+            throw_non_exhaustive();
         }
     }
 
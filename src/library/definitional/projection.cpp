@@ -105,6 +105,7 @@ environment mk_projections(environment const & env, name const & n, buffer<name>
     buffer<expr> projs; // projections generated so far
     unsigned i = 0;
     environment new_env = env;
+    batch_checker checker; // all projections share the same universe level parameters
     for (name const & proj_name : proj_names) {
         if (!is_pi(intro_type))
             throw exception(sstream() << "generating projection '" << proj_name << "', '"
@@ -133,7 +134,7 @@ environment mk_projections(environment const & env, name const & n, buffer<name>
         bool use_conv_opt = false;
         declaration new_d = mk_definition(env, proj_name, lvl_params, proj_type, proj_val,
                                           opaque, rec_decl.get_module_idx(), use_conv_opt);
-        new_env = module::add(new_env, check(new_env, new_d));
+        new_env = module::add(new_env, checker.check(new_env, new_d));
         new_env = set_reducible(new_env, proj_name, reducible_status::Reducible);
         new_env = add_unfold_c_hint(new_env, proj_name, nparams);
         new_env = save_projection_info(new_env, proj_name, inductive::intro_rule_name(intro), nparams, i, inst_implicit);
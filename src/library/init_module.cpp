@@ -36,6 +36,7 @@ Author: Leonardo de Moura
 #include "library/projection.h"
 #include "library/normalize.h"
 #include "library/abbreviation.h"
+#include "library/vm.h"
 
 namespace lean {
 void initialize_library_module() {
@@ -71,9 +72,11 @@ void initialize_library_module() {
     initialize_projection();
     initialize_normalize();
     initialize_abbreviation();
+    initialize_vm();
 }
 
 void finalize_library_module() {
+    finalize_vm();
     finalize_abbreviation();
     finalize_normalize();
     finalize_projection();
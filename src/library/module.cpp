@@ -12,6 +12,7 @@ Author: Leonardo de Moura
 #include <fstream>
 #include <algorithm>
 #include <sys/stat.h>
+#include <memory>
 #include "util/hash.h"
 #include "util/thread.h"
 #include "util/lean_path.h"
@@ -19,7 +20,9 @@ Author: Leonardo de Moura
 #include "util/buffer.h"
 #include "util/interrupt.h"
 #include "util/name_map.h"
+#include "util/sexpr/option_declarations.h"
 #include "kernel/type_checker.h"
+#include "kernel/for_each_fn.h"
 #include "kernel/quotient/quotient.h"
 #include "kernel/hits/hits.h"
 #include "library/module.h"
@@ -32,7 +35,23 @@ Author: Leonardo de Moura
 #define LEAN_ASYNCH_IMPORT_THEOREM false
 #endif
 
+#ifndef LEAN_DEFAULT_IMPORT_PARALLEL_CHECK
+#define LEAN_DEFAULT_IMPORT_PARALLEL_CHECK false
+#endif
+
+// Maximum number of declarations (per thread) that can be checked in parallel
+// before their results are added to the environment.
+#ifndef LEAN_IMPORT_PENDING_DECLS_PER_THREAD
+#define LEAN_IMPORT_PENDING_DECLS_PER_THREAD 8
+#endif
+
 namespace lean {
+static name * g_import_parallel_check = nullptr;
+
+bool get_import_parallel_check(options const & opts) {
+    return opts.get_bool(*g_import_parallel_check, LEAN_DEFAULT_IMPORT_PARALLEL_CHECK);
+}
+
 corrupted_file_exception::corrupted_file_exception(std::string const & fname):
     exception(sstream() << "failed to import '" << fname << "', file is corrupted, please regenerate the file from sources") {
 }
@@ -263,6 +282,7 @@ struct import_modules_fn {
     shared_environment             m_senv;
     unsigned                       m_num_threads;
     bool                           m_keep_proofs;
+    bool                           m_parallel_check; // check the declarations of a module in parallel
     io_state                       m_ios;
     mutex                          m_asynch_mutex;
     condition_variable             m_asynch_cv;
@@ -287,7 +307,8 @@ struct import_modules_fn {
     name_set                  m_imported; // contains all imported files, even ones from previous calls
 
     import_modules_fn(environment const & env, unsigned num_threads, bool keep_proofs, io_state const & ios):
-        m_senv(env), m_num_threads(num_threads), m_keep_proofs(keep_proofs), m_ios(ios),
+        m_senv(env), m_num_threads(num_threads), m_keep_proofs(keep_proofs),
+        m_parallel_check(get_import_parallel_check(ios.get_options())), m_ios(ios),
         m_next_module_idx(1), m_import_counter(0), m_all_modules_imported(false) {
         module_ext const & ext = get_extension(env);
         m_imported = ext.m_imported;
@@ -379,16 +400,129 @@ struct import_modules_fn {
         add_asynch_task([=](shared_environment &) { import_module(r); });
     }
 
-    declaration theorem2axiom(declaration const & decl) {
+    static declaration theorem2axiom(declaration const & decl) {
         lean_assert(decl.is_theorem());
         return mk_axiom(decl.get_name(), decl.get_univ_params(), decl.get_type());
     }
 
-    void import_decl(deserializer & d, module_idx midx) {
+    /** \brief Kernel check of an imported declaration. It is performed by a worker thread,
+        or by the thread importing the module if none of the workers has started it yet. */
+    class decl_check_task {
+        enum class state { Pending, Running, Done };
+        environment                            m_env;
+        declaration                            m_decl;
+        bool                                   m_to_axiom; // check theorem, but produce an axiom
+        mutex                                  m_mutex;
+        condition_variable                     m_cv;
+        state                                  m_state;
+        std::unique_ptr<certified_declaration> m_result;
+        std::unique_ptr<throwable>             m_ex;
+    public:
+        decl_check_task(environment const & env, declaration const & d, bool to_axiom):
+            m_env(env), m_decl(d), m_to_axiom(to_axiom), m_state(state::Pending) {}
+
+        name const & get_name() const { return m_decl.get_name(); }
+
+        /** \brief Run the check if nobody else has started it. */
+        void try_run() {
+            {
+                lock_guard<mutex> l(m_mutex);
+                if (m_state != state::Pending)
+                    return;
+                m_state = state::Running;
+            }
+            try {
+                if (m_to_axiom) {
+                    check(m_env, m_decl);
+                    m_result.reset(new certified_declaration(check(m_env, theorem2axiom(m_decl))));
+                } else {
+                    m_result.reset(new certified_declaration(check(m_env, m_decl)));
+                }
+            } catch (throwable & ex) {
+                m_ex.reset(ex.clone());
+            }
+            {
+                lock_guard<mutex> l(m_mutex);
+                m_state = state::Done;
+            }
+            m_cv.notify_all();
+        }
+
+        certified_declaration const & get_result() {
+            try_run();
+            unique_lock<mutex> lk(m_mutex);
+            while (m_state != state::Done)
+                m_cv.wait(lk);
+            if (m_ex)
+                m_ex->rethrow();
+            return *m_result;
+        }
+    };
+    typedef std::shared_ptr<decl_check_task> decl_check_task_ptr;
+
+    /** \brief Declarations of the module being imported that are being checked in parallel.
+        They are added to the shared environment in module order. */
+    struct pending_decls {
+        std::vector<decl_check_task_ptr> m_tasks;
+        name_set                         m_names;
+    };
+
+    /** \brief Add the first \c n pending declarations to the shared environment. */
+    void commit_pending_decls(pending_decls & p, unsigned n) {
+        lean_assert(n <= p.m_tasks.size());
+        for (unsigned i = 0; i < n; i++)
+            m_senv.add(p.m_tasks[i]->get_result());
+        p.m_tasks.erase(p.m_tasks.begin(), p.m_tasks.begin() + n);
+        p.m_names = name_set();
+        for (decl_check_task_ptr const & t : p.m_tasks)
+            p.m_names.insert(t->get_name());
+    }
+
+    void commit_pending_decls(pending_decls & p) {
+        commit_pending_decls(p, p.m_tasks.size());
+    }
+
+    /** \brief Return the number of pending declarations that must be committed before \c d is checked,
+        i.e., 1 + the position of the last pending declaration used by \c d, or 0 if \c d does not use them. */
+    static unsigned get_num_required_pending(declaration const & d, pending_decls const & p) {
+        if (p.m_names.empty())
+            return 0;
+        name_set used;
+        auto collect = [&](expr const & e) {
+            for_each(e, [&](expr const & c, unsigned) {
+                    if (is_constant(c) && p.m_names.contains(const_name(c)))
+                        used.insert(const_name(c));
+                    return true;
+                });
+        };
+        collect(d.get_type());
+        if (d.is_definition())
+            collect(d.get_value());
+        unsigned i = p.m_tasks.size();
+        while (i > 0 && !used.contains(p.m_tasks[i-1]->get_name()))
+            --i;
+        return i;
+    }
+
+    /** \brief Add the pending declarations used by \c d to the shared environment.
+        Return true if some declaration was added. */
+    bool commit_required_pending_decls(declaration const & d, pending_decls & p) {
+        if (unsigned n = get_num_required_pending(d, p)) {
+            commit_pending_decls(p, n);
+            return true;
+        }
+        return false;
+    }
+
+    void import_decl(deserializer & d, module_idx midx, pending_decls & pending) {
         declaration decl = read_declaration(d, midx);
         lean_assert(!decl.is_definition() || decl.get_module_idx() == midx);
+        // The pending declarations used by decl must be in the environment used to unfold its macros and to check it.
+        commit_required_pending_decls(decl, pending);
         environment env  = m_senv.env();
         decl = unfold_untrusted_macros(env, decl);
+        if (commit_required_pending_decls(decl, pending))
+            env = m_senv.env(); // the unfolded macros use pending declarations
         if (decl.get_name() == get_sorry_name() && has_sorry(env))
             return;
         if (env.trust_lvl() > LEAN_BELIEVER_TRUST_LEVEL) {
@@ -406,6 +540,16 @@ struct import_modules_fn {
                     if (m_keep_proofs)
                         m_senv.replace(c);
                 });
+        } else if (m_parallel_check && m_num_threads > 1) {
+            // The declaration is checked by a worker thread with respect to an environment containing its
+            // dependencies, and the thread importing the module continues reading the next declarations.
+            // The pending declarations after the last one it uses remain pending.
+            auto t = std::make_shared<decl_check_task>(env, decl, !m_keep_proofs && decl.is_theorem());
+            pending.m_tasks.push_back(t);
+            pending.m_names.insert(decl.get_name());
+            add_asynch_task([=](shared_environment &) { t->try_run(); });
+            if (pending.m_tasks.size() >= LEAN_IMPORT_PENDING_DECLS_PER_THREAD * m_num_threads)
+                commit_pending_decls(pending);
         } else {
             if (!m_keep_proofs && decl.is_theorem()) {
                 // check theorem, but add an axiom
@@ -418,6 +562,13 @@ struct import_modules_fn {
         }
     }
 
+    /** \brief Return true if objects with key \c k are added to the kernel environment, and may
+        depend on the declarations being checked. The other objects (global universes and extension
+        entries) do not require them, and the pending declarations are not committed before them. */
+    static bool is_kernel_object(std::string const & k) {
+        return k == *g_inductive || k == *g_quotient || k == *g_hits;
+    }
+
     void import_universe(deserializer & d) {
         name const l = read_name(d);
         m_senv.update([=](environment const & env) { return env.add_universe(l); });
@@ -435,14 +586,19 @@ struct import_modules_fn {
                 lock_guard<mutex> lk(m_delayed_mutex);
                 m_delayed_tasks.push_back(std::make_tuple(r->m_module_idx, obj_counter, f));
             });
+        pending_decls pending;
         while (true) {
             check_interrupted();
             std::string k;
             d >> k;
+            if (k == *g_decl_key) {
+                import_decl(d, r->m_module_idx, pending);
+                obj_counter++;
+                continue;
+            }
             if (k == g_olean_end_file) {
+                commit_pending_decls(pending);
                 break;
-            } else if (k == *g_decl_key) {
-                import_decl(d, r->m_module_idx);
             } else if (k == *g_glvl_key) {
                 import_universe(d);
             } else {
@@ -450,6 +606,8 @@ struct import_modules_fn {
                 auto it = readers.find(k);
                 if (it == readers.end())
                     throw exception(sstream() << "file '" << r->m_fname << "' has been corrupted, unknown object");
+                if (is_kernel_object(k))
+                    commit_pending_decls(pending);
                 it->second(d, r->m_module_idx, m_senv, add_asynch_update, add_delayed_update);
             }
             obj_counter++;
@@ -592,6 +750,10 @@ void initialize_module() {
     g_inductive      = new std::string("ind");
     g_quotient       = new std::string("quot");
     g_hits           = new std::string("hits");
+    g_import_parallel_check = new name{"import", "parallel_check"};
+    register_bool_option(*g_import_parallel_check, LEAN_DEFAULT_IMPORT_PARALLEL_CHECK,
+                         "(import) when imported modules are type checked using multiple threads, "
+                         "also check the declarations of each module in parallel");
     register_module_object_reader(*g_inductive, module::inductive_reader);
     register_module_object_reader(*g_quotient, module::quotient_reader);
     register_module_object_reader(*g_hits, module::hits_reader);
@@ -605,5 +767,6 @@ void finalize_module() {
     delete g_glvl_key;
     delete g_object_readers;
     delete g_ext;
+    delete g_import_parallel_check;
 }
 }
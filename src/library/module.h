@@ -31,6 +31,9 @@ public:
     optional<unsigned> const & get_k() const { return m_relative; }
 };
 
+/** \brief Return the value of the option <tt>import.parallel_check</tt>. */
+bool get_import_parallel_check(options const & opts);
+
 /** \brief Return an environment based on \c env, where all modules in \c modules are imported.
     Modules included directly or indirectly by them are also imported.
     The environment \c env is usually an empty environment.
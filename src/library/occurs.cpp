@@ -5,10 +5,26 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include "kernel/find_fn.h"
+#include "kernel/for_each_fn.h"
 #include "library/occurs.h"
 
 namespace lean {
 bool occurs(expr const & n, expr const & m) {
+    if (is_mlocal(n)) {
+        // skip the subterms that cannot contain \c n
+        unsigned filter = mk_mlocal_filter(mlocal_name(n));
+        bool found      = false;
+        for_each(m, [&](expr const & e, unsigned) {
+                if (found || (get_mlocal_filter(e) & filter) == 0)
+                    return false;
+                if (n == e) {
+                    found = true;
+                    return false;
+                }
+                return true;
+            });
+        return found;
+    }
     return static_cast<bool>(find(m, [&](expr const & e, unsigned) { return n == e; }));
 }
 
@@ -21,6 +21,20 @@ void register_scoped_ext(name const & c, using_namespace_fn use, export_namespac
     get_exts().emplace_back(c, use, ex, push, pop);
 }
 
+static std::vector<unsigned> * g_scoped_ext_ids = nullptr;
+
+void register_scoped_ext_id(unsigned id) {
+    g_scoped_ext_ids->push_back(id);
+}
+
+bool is_eqp_scoped_exts(environment const & env1, environment const & env2) {
+    for (unsigned id : *g_scoped_ext_ids) {
+        if (&env1.get_extension(id) != &env2.get_extension(id))
+            return false;
+    }
+    return true;
+}
+
 struct scope_mng_ext : public environment_extension {
     name_set         m_namespace_set; // all namespaces registered in the system
     list<name>       m_namespaces;    // stack of namespaces/sections
@@ -247,6 +261,7 @@ void open_scoped_ext(lua_State * L) {
 
 void initialize_scoped_ext() {
     g_exts = new scoped_exts();
+    g_scoped_ext_ids = new std::vector<unsigned>();
     g_ext  = new scope_mng_ext_reg();
     g_new_namespace_key = new std::string("nspace");
     register_module_object_reader(*g_new_namespace_key, namespace_reader);
@@ -255,6 +270,7 @@ void initialize_scoped_ext() {
 void finalize_scoped_ext() {
     delete g_new_namespace_key;
     delete g_exts;
+    delete g_scoped_ext_ids;
     delete g_ext;
 }
 }
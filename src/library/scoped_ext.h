@@ -23,6 +23,14 @@ typedef environment (*push_scope_fn)(environment const &, io_state const &, scop
 typedef environment (*pop_scope_fn)(environment const &, io_state const &, scope_kind);
 
 void register_scoped_ext(name const & n, using_namespace_fn use, export_namespace_fn ex, push_scope_fn push, pop_scope_fn pop);
+/** \brief Register the environment extension identifier of a scoped extension created using the scoped_ext template. */
+void register_scoped_ext_id(unsigned id);
+/** \brief Return true if the scoped extensions created using the scoped_ext template (e.g., coercions, instances,
+    reducibility annotations) are the same objects in \c env1 and \c env2.
+
+    \remark Closing a scope removes the entries added in it, but the resulting environment is still a
+    descendant of the one where they were added. */
+bool is_eqp_scoped_exts(environment const & env1, environment const & env2);
 /** \brief Use objects defined in the namespace \c n.
     If \c metaclasses is not empty, then only objects in the given "metaclasses" \c c are considered. */
 environment using_namespace(environment const & env, io_state const & ios, name const & n, buffer<name> const & metaclasses);
@@ -192,6 +200,7 @@ public:
             register_scoped_ext(get_class_name(), using_namespace_fn, export_namespace_fn, push_fn, pop_fn);
             register_module_object_reader(get_serialization_key(), reader);
             m_ext_id = environment::register_extension(std::make_shared<scoped_ext>());
+            register_scoped_ext_id(m_ext_id);
         }
     };
 
@@ -165,18 +165,20 @@ struct class_instance_elaborator : public choice_iterator {
     // This information is retrieved from the local context
     list<expr>              m_local_instances;
     // global declaration names that are class instances.
-    // This information is retrieved using #get_class_instances.
-    list<name>              m_instances;
+    // This information is retrieved using #get_class_instances,
+    // and the instances are tried from the last to the first one.
+    pvector<name>           m_instances;
+    unsigned                m_next_instance;
     justification           m_jst;
     unsigned                m_depth;
     bool                    m_displayed_trace_header;
 
     class_instance_elaborator(std::shared_ptr<class_instance_context> const & C, local_context const & ctx,
                               expr const & meta, expr const & meta_type,
-                              list<expr> const & local_insts, list<name> const & instances,
+                              list<expr> const & local_insts, pvector<name> const & instances,
                               justification const & j, unsigned depth):
         choice_iterator(), m_C(C), m_ctx(ctx), m_meta(meta), m_meta_type(meta_type),
-        m_local_instances(local_insts), m_instances(instances), m_jst(j), m_depth(depth) {
+        m_local_instances(local_insts), m_instances(instances), m_next_instance(instances.size()), m_jst(j), m_depth(depth) {
         if (m_depth > m_C->get_max_depth()) {
             throw_class_exception("maximum class-instance resolution depth has been reached "
                                   "(the limit can be increased by setting option 'class.instance_max_depth') "
@@ -284,9 +286,9 @@ struct class_instance_elaborator : public choice_iterator {
             if (auto r = try_instance(inst, mlocal_type(inst)))
                 return r;
         }
-        while (!empty(m_instances)) {
-            name inst   = head(m_instances);
-            m_instances = tail(m_instances);
+        while (m_next_instance > 0) {
+            m_next_instance--;
+            name inst = m_instances[m_next_instance];
             if (auto cs = try_instance(inst))
                 return cs;
         }
@@ -304,8 +306,8 @@ constraint mk_class_instance_cnstr(std::shared_ptr<class_instance_context> const
             list<expr> local_insts;
             if (C->use_local_instances())
                 local_insts = get_local_instances(C->tc(), ctx_lst, cls_name);
-            list<name>  insts = get_class_instances(env, cls_name);
-            if (empty(local_insts) && empty(insts))
+            pvector<name> insts = get_class_instances(env, cls_name);
+            if (empty(local_insts) && insts.empty())
                 return lazy_list<constraints>(); // nothing to be done
             // we are always strict with placeholders associated with classes
             return choose(std::make_shared<class_instance_elaborator>(C, ctx, meta, meta_type, local_insts, insts, j, depth));
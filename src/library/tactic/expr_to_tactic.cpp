@@ -384,6 +384,26 @@ void initialize_expr_to_tactic() {
     register_num_tac(get_tactic_rotate_left_name(), [](unsigned k) { return rotate_left(k); });
     register_num_tac(get_tactic_rotate_right_name(), [](unsigned k) { return rotate_right(k); });
 
+    register_tac(get_tactic_first_success_par_name(),
+                 [](type_checker & tc, elaborate_fn const & fn, expr const & e, pos_info_provider const * p) {
+                     buffer<expr> args;
+                     get_app_args(e, args);
+                     if (args.size() != 1)
+                         throw expr_to_tactic_exception(e, "invalid first_success_par tactic, it must have one argument");
+                     buffer<tactic> tacs;
+                     expr l = tc.whnf(args[0]).first;
+                     while (!is_constant(l) || const_name(l) != get_tactic_tactic_list_nil_name()) {
+                         buffer<expr> cargs;
+                         expr const & c = get_app_args(l, cargs);
+                         if (!is_constant(c) || const_name(c) != get_tactic_tactic_list_cons_name() || cargs.size() != 2)
+                             throw expr_to_tactic_exception(e, "invalid first_success_par tactic, "
+                                                            "argument must be a list of tactics");
+                         tacs.push_back(expr_to_tactic(tc, fn, cargs[0], p));
+                         l = tc.whnf(cargs[1]).first;
+                     }
+                     return first_success_par(tacs.size(), tacs.data());
+                 });
+
     register_tac(get_tactic_fixpoint_name(),
                  [](type_checker & tc, elaborate_fn const & fn, expr const & e, pos_info_provider const *) {
                      if (!is_constant(app_fn(e)))
@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include "library/tactic/goal.h"
+#include "library/tactic/tactic.h"
 #include "library/tactic/proof_state.h"
 #include "library/tactic/expr_to_tactic.h"
 #include "library/tactic/apply_tactic.h"
@@ -28,6 +29,7 @@ namespace lean {
 void initialize_tactic_module() {
     initialize_goal();
     initialize_proof_state();
+    initialize_tactic();
     initialize_expr_to_tactic();
     initialize_apply_tactic();
     initialize_rename_tactic();
@@ -65,6 +67,7 @@ void finalize_tactic_module() {
     finalize_rename_tactic();
     finalize_apply_tactic();
     finalize_expr_to_tactic();
+    finalize_tactic();
     finalize_proof_state();
     finalize_goal();
 }
@@ -15,6 +15,7 @@ Author: Leonardo de Moura
 #include "kernel/abstract.h"
 #include "kernel/replace_fn.h"
 #include "kernel/for_each_fn.h"
+#include "kernel/expr_maps.h"
 #include "kernel/default_converter.h"
 #include "kernel/inductive/inductive.h"
 #include "library/normalize.h"
@@ -47,6 +48,10 @@ Author: Leonardo de Moura
 #define LEAN_DEFAULT_REWRITER_TRACE true
 #endif
 
+#ifndef LEAN_REWRITER_HEAD_FILTER_CACHE_CAPACITY
+#define LEAN_REWRITER_HEAD_FILTER_CACHE_CAPACITY 100000
+#endif
+
 namespace lean {
 static name * g_rewriter_max_iterations = nullptr;
 static name * g_rewriter_syntactic      = nullptr;
@@ -546,6 +551,12 @@ class rewrite_fn {
     buffer<optional<level>> m_lsubst; // auxiliary buffer for pattern matching
     buffer<optional<expr>>  m_esubst; // auxiliary buffer for pattern matching
 
+    name_map<bool>          m_rigid_consts; // cache for is_rigid_head
+    /** \brief Cache for get_head_filter. Rewriting a target only creates new subterms on the path to the
+        rewritten occurrences, so the entries for the other subterms are reused by the following steps.
+        It is cleared when it has more than LEAN_REWRITER_HEAD_FILTER_CACHE_CAPACITY entries. */
+    expr_map<uint64>        m_head_filters;
+
     [[ noreturn ]] void throw_rewrite_exception(char const * msg) {
         throw_generic_exception(msg, m_expr_loc);
     }
@@ -1126,6 +1137,112 @@ class rewrite_fn {
         return unify_result();
     }
 
+    // Return true if the matcher cannot reduce an application whose head symbol is \c f.
+    // That is, \c f is a local constant, metavariable, sort, Pi, a definition that is not unfolded by
+    // m_matcher_tc, an inductive datatype or a constructor. The normalizer extensions only reduce applications
+    // of eliminators (e.g., recursors and quot.lift), and eliminators are not rigid.
+    // A pattern whose head symbol is rigid can only match terms with the same head symbol or a flexible one.
+    bool is_rigid_head(expr const & f) {
+        switch (f.kind()) {
+        case expr_kind::Local: case expr_kind::Meta: case expr_kind::Sort: case expr_kind::Pi:
+            return true;
+        case expr_kind::Constant: {
+            name const & n = const_name(f);
+            if (auto it = m_rigid_consts.find(n))
+                return *it;
+            bool r = false;
+            if (auto d = m_env.find(n)) {
+                if (d->is_definition())
+                    r = m_matcher_tc->is_opaque(f);
+                else
+                    r = inductive::is_intro_rule(m_env, n) || inductive::is_inductive_decl(m_env, n);
+            }
+            m_rigid_consts.insert(n, r);
+            return r;
+        }
+        default:
+            return false;
+        }
+    }
+
+    static constexpr uint64 flexible_bit = 1ull << 63;
+
+    // Return the bit used to represent the closed subterms with head symbol \c f in the filters produced by get_head_filter.
+    uint64 get_head_bit(expr const & f) {
+        if (!is_rigid_head(f))
+            return flexible_bit;
+        else if (is_constant(f))
+            return 1ull << (const_name(f).hash() % 63);
+        else
+            return 0; // only constants are used as the head symbol of indexed patterns
+    }
+
+    // Return a small Bloom filter for the head symbols of the closed subterms of \c e (including \c e and the
+    // types of local constants). The bit flexible_bit is set iff one of them has a flexible head symbol.
+    uint64 get_head_filter(expr const & e) {
+        uint64 r = closed(e) ? get_head_bit(get_app_fn(e)) : 0;
+        switch (e.kind()) {
+        case expr_kind::Var: case expr_kind::Constant: case expr_kind::Sort:
+            return r;
+        default:
+            break;
+        }
+        auto it = m_head_filters.find(e);
+        if (it != m_head_filters.end())
+            return it->second;
+        check_system("rewrite tactic");
+        switch (e.kind()) {
+        case expr_kind::Var: case expr_kind::Constant: case expr_kind::Sort:
+            lean_unreachable(); // LCOV_EXCL_LINE
+        case expr_kind::Meta: case expr_kind::Local:
+            r |= get_head_filter(mlocal_type(e));
+            break;
+        case expr_kind::Macro:
+            for (unsigned i = 0; i < macro_num_args(e); i++)
+                r |= get_head_filter(macro_arg(e, i));
+            break;
+        case expr_kind::App:
+            r |= get_head_filter(app_fn(e));
+            r |= get_head_filter(app_arg(e));
+            break;
+        case expr_kind::Lambda: case expr_kind::Pi:
+            r |= get_head_filter(binding_domain(e));
+            r |= get_head_filter(binding_body(e));
+            break;
+        }
+        m_head_filters.insert(mk_pair(e, r));
+        return r;
+    }
+
+    // Store in \c r the closed subterms of \c e that may match \c pattern, in the order they are visited by for_each.
+    // When the head symbol of \c pattern is a rigid constant, only the subterms with the same head symbol or a
+    // flexible one may match, and the subterms that do not contain them (see get_head_filter) are skipped.
+    void get_candidates(expr const & e, expr const & pattern, buffer<expr> & r) {
+        expr const & p_fn = get_app_fn(pattern);
+        if (!is_constant(p_fn) || !is_rigid_head(p_fn)) {
+            // any closed subterm may match
+            for_each(e, [&](expr const & t, unsigned) {
+                    if (closed(t))
+                        r.push_back(t);
+                    return true;
+                });
+            return;
+        }
+        if (m_head_filters.size() > LEAN_REWRITER_HEAD_FILTER_CACHE_CAPACITY)
+            m_head_filters.clear();
+        uint64 filter = get_head_bit(p_fn) | flexible_bit;
+        for_each(e, [&](expr const & t, unsigned) {
+                if ((get_head_filter(t) & filter) == 0)
+                    return false;
+                if (closed(t)) {
+                    expr const & f = get_app_fn(t);
+                    if (!is_rigid_head(f) || (is_constant(f) && const_name(f) == const_name(p_fn)))
+                        r.push_back(t);
+                }
+                return true;
+            });
+    }
+
     // Search for \c pattern in \c e. If \c t is a match, then try to unify the type of the rule
     // in the rewrite step \c orig_elem with \c t.
     // When successful, this method returns the target \c t, the fully elaborated rule \c r,
@@ -1134,26 +1251,20 @@ class rewrite_fn {
     // \remark is_goal == true if \c e is the type of a goal. Otherwise, it is assumed to be the type
     // of a hypothesis. This flag affects the equality proof built by this method.
     find_result find_target(expr const & e, expr const & pattern, expr const & orig_elem, bool is_goal) {
-        find_result result;
-        for_each(e, [&](expr const & t, unsigned) {
-                if (result)
-                    return false; // stop search
-                if (closed(t)) {
-                    lean_assert(std::all_of(m_esubst.begin(), m_esubst.end(), [&](optional<expr> const & e) { return !e; }));
-                    bool assigned = false;
-                    bool r = match(pattern, t, m_lsubst, m_esubst, nullptr, nullptr, &m_mplugin, &assigned);
-                    if (assigned)
-                        reset_subst();
-                    if (r) {
-                        if (auto p = unify_target(t, orig_elem, is_goal)) {
-                            result = std::make_tuple(t, p->second, p->first);
-                            return false;
-                        }
-                    }
-                }
-                return true;
-            });
-        return result;
+        buffer<expr> candidates;
+        get_candidates(e, pattern, candidates);
+        for (expr const & t : candidates) {
+            lean_assert(std::all_of(m_esubst.begin(), m_esubst.end(), [&](optional<expr> const & e) { return !e; }));
+            bool assigned = false;
+            bool r = match(pattern, t, m_lsubst, m_esubst, nullptr, nullptr, &m_mplugin, &assigned);
+            if (assigned)
+                reset_subst();
+            if (r) {
+                if (auto p = unify_target(t, orig_elem, is_goal))
+                    return find_result(std::make_tuple(t, p->second, p->first));
+            }
+        }
+        return find_result();
     }
 
     bool move_after(expr const & hyp, expr_struct_set const & hyps) {
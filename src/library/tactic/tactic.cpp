@@ -5,13 +5,18 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <utility>
+#include <algorithm>
 #include <chrono>
 #include <string>
+#include <vector>
 #include "util/luaref.h"
 #include "util/sstream.h"
 #include "util/interrupt.h"
 #include "util/lazy_list_fn.h"
 #include "util/list_fn.h"
+#include "util/name_set.h"
+#include "util/thread_pool.h"
+#include "util/sexpr/option_declarations.h"
 #include "kernel/instantiate.h"
 #include "kernel/type_checker.h"
 #include "kernel/for_each_fn.h"
@@ -20,7 +25,21 @@ Author: Leonardo de Moura
 #include "library/tactic/tactic.h"
 #include "library/io_state_stream.h"
 
+#ifndef LEAN_DEFAULT_TACTIC_PAR_GOALS
+#define LEAN_DEFAULT_TACTIC_PAR_GOALS 0
+#endif
+
 namespace lean {
+static name * g_tactic_par_goals = nullptr;
+static atomic<unsigned> * g_par_all_goals_merged    = nullptr;
+static atomic<unsigned> * g_par_all_goals_dependent = nullptr;
+static atomic<unsigned> * g_par_all_goals_conflicts = nullptr;
+static atomic<unsigned> * g_par_all_goals_failures  = nullptr;
+
+unsigned get_tactic_par_goals(options const & opts) {
+    return opts.get_unsigned(*g_tactic_par_goals, LEAN_DEFAULT_TACTIC_PAR_GOALS);
+}
+
 /** \brief Throw an exception is \c v contains local constants, \c e is only used for position information. */
 void check_has_no_local(expr const & v, expr const & e, char const * tac_name) {
     if (has_local(v)) {
@@ -181,6 +200,17 @@ tactic par(tactic const & t1, tactic const & t2, unsigned check_ms) {
         });
 }
 
+tactic first_success_par(unsigned num, tactic const * ts, unsigned check_ms) {
+    std::vector<tactic> tacs(ts, ts + num);
+    return tactic([=](environment const & env, io_state const & ios, proof_state const & _s) -> proof_state_seq {
+            proof_state s = _s.update_report_failure(false);
+            std::vector<proof_state_seq> seqs;
+            for (tactic const & t : tacs)
+                seqs.push_back(t(env, ios, s));
+            return first_success_par(seqs, check_ms);
+        });
+}
+
 tactic repeat(tactic const & t) {
     return tactic([=](environment const & env, io_state const & ios, proof_state const & _s1) -> proof_state_seq {
             proof_state s1 = _s1.update_report_failure(false);
@@ -289,18 +319,199 @@ tactic focus(tactic const & t, unsigned i) {
         });
 }
 
+static proof_state_seq all_goals_core(tactic const & t, environment const & env, io_state const & ios, proof_state const & s) {
+    tactic r   = id_tactic();
+    unsigned i = length(s.get_goals());
+    while (i > 0) {
+        --i;
+        r = then(r, focus(t, i));
+    }
+    return r(env, ios, s);
+}
+
+/** \brief Return true iff the goals in \c s do not share metavariables (after instantiation). */
+static bool independent_goals(proof_state const & s) {
+    substitution subst = s.get_subst();
+    name_set     mvars;
+    for (goal const & g : s.get_goals()) {
+        goal new_g = g.instantiate(subst);
+        if (has_univ_metavar(new_g.get_meta()) || has_univ_metavar(new_g.get_type()))
+            return false;
+        name_set g_mvars;
+        bool shared = false;
+        auto collect = [&](expr const & e, unsigned) {
+            if (shared || !has_expr_metavar(e))
+                return false;
+            if (is_metavar(e)) {
+                if (mvars.contains(mlocal_name(e)))
+                    shared = true;
+                g_mvars.insert(mlocal_name(e));
+            }
+            return true;
+        };
+        for_each(new_g.get_meta(), collect);
+        for_each(new_g.get_type(), collect);
+        if (shared)
+            return false;
+        g_mvars.for_each([&](name const & n) { mvars.insert(n); });
+    }
+    return true;
+}
+
+/**
+    \brief Apply \c t to each goal of \c s using \c num_threads threads (the current one and threads
+    of the shared thread pool), and merge the first solution produced for each one of them.
+    The goals must be independent.
+
+    If \c t throws an exception or produces no solution for some goal, then the sequential execution
+    fails in the same way, since the goals are independent. The exception is rethrown, and \c failed is
+    set to true when there is no solution. The goals are considered in the order used by the sequential
+    execution, i.e., from the last to the first one. If the current thread is interrupted, then the
+    workers are interrupted too, and the remaining goals are not solved.
+
+    Return none if the solutions cannot be merged, i.e., they assign the same metavariable or postpone constraints.
+*/
+static optional<proof_state> par_all_goals(tactic const & t, environment const & env, io_state const & ios,
+                                           proof_state const & s, unsigned num_threads, bool & failed) {
+    typedef std::unique_ptr<throwable> exception_ptr;
+    buffer<goal> gs;
+    to_buffer(s.get_goals(), gs);
+    name_generator ngen = s.get_ngen();
+    std::vector<proof_state> states;
+    for (goal const & g : gs)
+        states.push_back(proof_state(s, goals(g), ngen.mk_child()));
+    std::vector<optional<proof_state>> results(gs.size());
+    std::vector<exception_ptr>         errors(gs.size());
+    atomic<unsigned>                   next(0);
+    auto solve = [&]() {
+        while (true) {
+            unsigned i = next++;
+            if (i >= gs.size() || interrupt_requested())
+                return;
+            try {
+                if (auto r = t(env, ios, states[i]).pull())
+                    results[i] = r->first;
+            } catch (interrupted &) {
+                // the other goals are not solved
+                throw;
+            } catch (throwable & ex) {
+                errors[i].reset(ex.clone());
+            }
+        }
+    };
+#if defined(LEAN_MULTI_THREAD)
+    {
+        unsigned num_workers = std::min(num_threads, gs.size()) - 1;
+        // the destructor of group interrupts the workers if the current thread is interrupted
+        task_group group;
+        for (unsigned k = 0; k < num_workers; k++) {
+            group.add([&]() {
+                    scoped_expr_caching scope(false);
+                    solve();
+                });
+        }
+        solve();
+        check_interrupted();
+        group.wait([&]() {
+                for (unsigned k = 0; k < num_workers; k++) {
+                    if (!group.done(k))
+                        return false;
+                }
+                return true;
+            });
+    }
+#else
+    solve();
+#endif
+    unsigned i = gs.size();
+    while (i > 0) {
+        --i;
+        if (errors[i])
+            errors[i]->rethrow();
+        if (!results[i]) {
+            failed = true;
+            return none_proof_state();
+        }
+    }
+    substitution const & subst = s.get_subst();
+    substitution new_subst     = subst;
+    buffer<goal> new_gs;
+    bool ok = true;
+    for (optional<proof_state> const & r : results) {
+        if (!is_eqp(r->get_postponed(), s.get_postponed()))
+            return none_proof_state();
+        r->get_subst().for_each_expr([&](name const & n, expr const & v, justification const & j) {
+                if (!subst.is_expr_assigned(n)) {
+                    if (new_subst.is_expr_assigned(n))
+                        ok = false;
+                    else
+                        new_subst.assign(n, v, j);
+                }
+            });
+        r->get_subst().for_each_level([&](name const & n, level const & l, justification const & j) {
+                if (!subst.is_level_assigned(n)) {
+                    if (new_subst.is_level_assigned(n))
+                        ok = false;
+                    else
+                        new_subst.assign(n, l, j);
+                }
+            });
+        if (!ok)
+            return none_proof_state();
+        for (goal const & g : r->get_goals())
+            new_gs.push_back(g);
+    }
+    return some(proof_state(s, to_list(new_gs.begin(), new_gs.end()), new_subst, ngen));
+}
+
 tactic all_goals(tactic const & t) {
     return tactic([=](environment const & env, io_state const & ios, proof_state const & s) -> proof_state_seq {
-            tactic r   = id_tactic();
-            unsigned i = length(s.get_goals());
-            while (i > 0) {
-                --i;
-                r = then(r, focus(t, i));
-            }
-            return r(env, ios, s);
+            unsigned num_threads = get_tactic_par_goals(ios.get_options());
+            if (num_threads == 0 || length(s.get_goals()) < 2)
+                return all_goals_core(t, env, ios, s);
+            return mk_proof_state_seq([=]() {
+                    if (!independent_goals(s)) {
+                        (*g_par_all_goals_dependent)++;
+                    } else {
+                        bool failed = false;
+                        if (auto new_s = par_all_goals(t, env, ios, s, num_threads, failed)) {
+                            (*g_par_all_goals_merged)++;
+                            // The remaining solutions are produced by the sequential execution (without its first one).
+                            // Remark: this solves all goals again, see all_goals in tactic.h.
+                            proof_state_seq seq = all_goals_core(t, env, ios, s);
+                            proof_state_seq tail = mk_proof_state_seq([=]() {
+                                    if (auto p = seq.pull())
+                                        return p->second.pull();
+                                    return proof_state_seq::maybe_pair();
+                                });
+                            return some(mk_pair(*new_s, tail));
+                        }
+                        if (failed) {
+                            (*g_par_all_goals_failures)++;
+                            return proof_state_seq::maybe_pair();
+                        }
+                        (*g_par_all_goals_conflicts)++;
+                    }
+                    return all_goals_core(t, env, ios, s).pull();
+                });
         });
 }
 
+par_all_goals_stats get_par_all_goals_stats() {
+    par_all_goals_stats r;
+    r.m_num_merged    = *g_par_all_goals_merged;
+    r.m_num_dependent = *g_par_all_goals_dependent;
+    r.m_num_conflicts = *g_par_all_goals_conflicts;
+    r.m_num_failures  = *g_par_all_goals_failures;
+    return r;
+}
+
+void display_par_all_goals_stats(std::ostream & out) {
+    par_all_goals_stats st = get_par_all_goals_stats();
+    out << "parallel all_goals: " << st.m_num_merged << " merged, " << st.m_num_dependent << " dependent, "
+        << st.m_num_conflicts << " conflicts, " << st.m_num_failures << " failures\n";
+}
+
 DECL_UDATA(proof_state_seq)
 static const struct luaL_Reg proof_state_seq_m[] = {
     {"__gc",            proof_state_seq_gc}, // never throws
@@ -444,6 +655,26 @@ static const struct luaL_Reg tactic_m[] = {
     {0, 0}
 };
 
+void initialize_tactic() {
+    g_tactic_par_goals = new name{"tactic", "par_goals"};
+    g_par_all_goals_merged    = new atomic<unsigned>(0);
+    g_par_all_goals_dependent = new atomic<unsigned>(0);
+    g_par_all_goals_conflicts = new atomic<unsigned>(0);
+    g_par_all_goals_failures  = new atomic<unsigned>(0);
+    register_unsigned_option(*g_tactic_par_goals, LEAN_DEFAULT_TACTIC_PAR_GOALS,
+                             "(tactic) number of threads used by all_goals to solve goals that do not share metavariables "
+                             "(0 means the goals are solved sequentially), remark: backtracking into all_goals "
+                             "solves all goals again sequentially");
+}
+
+void finalize_tactic() {
+    delete g_tactic_par_goals;
+    delete g_par_all_goals_merged;
+    delete g_par_all_goals_dependent;
+    delete g_par_all_goals_conflicts;
+    delete g_par_all_goals_failures;
+}
+
 void open_tactic(lua_State * L) {
     luaL_newmetatable(L, proof_state_seq_mt);
     lua_pushvalue(L, -1);
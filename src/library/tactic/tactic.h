@@ -6,10 +6,12 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <algorithm>
+#include <iostream>
 #include <utility>
 #include <memory>
 #include <string>
 #include "util/lazy_list.h"
+#include "util/interrupt.h"
 #include "library/io_state.h"
 #include "library/generic_exception.h"
 #include "library/tactic/proof_state.h"
@@ -69,14 +71,13 @@ tactic using_params(tactic const & t, options const & opts);
 /**
    \brief Return a tactic that tries the tactic \c t for at most \c ms milliseconds.
    If the tactic does not terminate in \c ms milliseconds, then the empty
-   sequence is returned.
+   sequence is returned. In particular, <tt>try_for t 0</tt> always returns the empty sequence.
 
-   \remark the tactic \c t is executed in a separate execution thread.
+   \remark the tactic \c t is executed by a thread of the shared thread pool.
 
-   \remark \c check_ms is how often the main thread checks whether the child
-   thread finished.
+   \remark \c check_ms is how often the main thread checks its interrupt flag.
 */
-tactic try_for(tactic const & t, unsigned ms, unsigned check_ms = 1);
+tactic try_for(tactic const & t, unsigned ms, unsigned check_ms = g_small_sleep);
 /**
    \brief Execute both tactics and and combines their results.
    The results produced by tactic \c t1 are listed before the ones
@@ -102,11 +103,20 @@ tactic interleave(tactic const & t1, tactic const & t2);
    the elements in the output sequence is not deterministic.
    It depends on how fast \c t1 and \c t2 produce their output.
 
-   \remark \c check_ms is how often the main thread checks whether the children
-   threads finished.
+   \remark \c check_ms is how often the main thread checks its interrupt flag.
 */
 tactic par(tactic const & t1, tactic const & t2, unsigned check_ms);
-inline tactic par(tactic const & t1, tactic const & t2) { return par(t1, t2, 1); }
+inline tactic par(tactic const & t1, tactic const & t2) { return par(t1, t2, g_small_sleep); }
+/**
+   \brief Return a tactic that executes the tactics \c ts in parallel, and produces the
+   results of the first one that succeeds. The other tactics are interrupted.
+   If all of them fail, then the empty sequence is returned.
+*/
+tactic first_success_par(unsigned num, tactic const * ts, unsigned check_ms = g_small_sleep);
+inline tactic first_success_par(tactic const & t1, tactic const & t2) {
+    tactic ts[2] = {t1, t2};
+    return first_success_par(2, ts);
+}
 /**
    \brief Return a tactic that keeps applying \c t until it fails.
 */
@@ -149,10 +159,42 @@ tactic focus(tactic const & t, unsigned i);
 inline tactic focus(tactic const & t) { return focus(t, 0); }
 /** \brief Return a tactic that applies beta-reduction. */
 tactic beta_tactic();
-/** \brief Apply \c t to all goals in the proof state */
+/** \brief Return the value of the option <tt>tactic.par_goals</tt>. */
+unsigned get_tactic_par_goals(options const & opts);
+/**
+   \brief Apply \c t to all goals in the proof state.
+
+   If the option <tt>tactic.par_goals</tt> is not zero, and the goals do not share metavariables,
+   then the first solution for each goal is computed in parallel, and the results are merged.
+   The other solutions are produced by the sequential execution. The sequential execution is also
+   used when the solutions cannot be merged, but not when \c t fails for some goal.
+
+   \remark When a merged solution is rejected (e.g., a later tactic fails and backtracks into
+   all_goals), the sequential execution starts from scratch and its first solution is skipped.
+   So, all goals are solved again sequentially, and backtracking costs more than the sequential
+   execution alone. Moreover, the solutions produced after the first one assume that the first
+   solution of the sequential execution is the merged one.
+*/
 tactic all_goals(tactic const & t);
 
+/**
+   \brief Number of times (for all threads) all_goals merged the solutions computed in parallel,
+   used the sequential execution because the goals share metavariables or the solutions could not be merged,
+   and failed without using the sequential execution.
+*/
+struct par_all_goals_stats {
+    unsigned m_num_merged;
+    unsigned m_num_dependent;
+    unsigned m_num_conflicts;
+    unsigned m_num_failures;
+    par_all_goals_stats():m_num_merged(0), m_num_dependent(0), m_num_conflicts(0), m_num_failures(0) {}
+};
+par_all_goals_stats get_par_all_goals_stats();
+void display_par_all_goals_stats(std::ostream & out);
+
 UDATA_DEFS_CORE(proof_state_seq)
 UDATA_DEFS_CORE(tactic);
 void open_tactic(lua_State * L);
+void initialize_tactic();
+void finalize_tactic();
 }
@@ -156,11 +156,14 @@ enum class occurs_check_status { Ok, Maybe, FailCircular, FailLocal };
 occurs_check_status occurs_context_check(substitution & s, expr const & e, expr const & m, buffer<expr> const & locals, expr & bad_local) {
     expr root = e;
     occurs_check_status r = occurs_check_status::Ok;
+    unsigned locals_filter = 0;
+    for (expr const & local : locals)
+        locals_filter |= mk_mlocal_filter(mlocal_name(local));
     for_each(e, [&](expr const & e, unsigned) {
             if (r == occurs_check_status::FailLocal || r == occurs_check_status::FailCircular) {
                 return false;
             } else if (is_local(e)) {
-                if (!contains_local(e, locals)) {
+                if ((mk_mlocal_filter(mlocal_name(e)) & locals_filter) == 0 || !contains_local(e, locals)) {
                     // right-hand-side contains variable that is not in the scope
                     // of metavariable.
                     bad_local = e;
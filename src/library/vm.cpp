@@ -0,0 +1,735 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#include <vector>
+#include <memory>
+#include <functional>
+#include "util/interrupt.h"
+#include "util/thread.h"
+#include "util/name_map.h"
+#include "util/name_set.h"
+#include "util/name_generator.h"
+#include "util/numerics/mpz.h"
+#include "util/sexpr/option_declarations.h"
+#include "kernel/type_checker.h"
+#include "kernel/instantiate.h"
+#include "kernel/inductive/inductive.h"
+#include "kernel/quotient/quotient.h"
+#include "library/constants.h"
+#include "library/annotation.h"
+#include "library/num.h"
+#include "library/normalize.h"
+#include "library/unfold_macros.h"
+#include "library/vm.h"
+
+#ifndef LEAN_DEFAULT_EVAL_VM
+#define LEAN_DEFAULT_EVAL_VM true
+#endif
+
+namespace lean {
+static name * g_eval_vm       = nullptr;
+static name * g_quotient_mk   = nullptr;
+static name * g_quotient_lift = nullptr;
+static atomic<unsigned> * g_vm_eval_successes = nullptr;
+static atomic<unsigned> * g_vm_eval_failures  = nullptr;
+
+bool get_eval_vm(options const & opts) {
+    return opts.get_bool(*g_eval_vm, LEAN_DEFAULT_EVAL_VM);
+}
+
+/** \brief Exception used to abort the bytecode evaluator. */
+class vm_exception : public exception {
+public:
+    vm_exception(char const * msg):exception(msg) {}
+};
+
+enum class vm_value_kind { Neutral, Num, Constructor, Closure, Thunk };
+
+struct vm_value_cell;
+typedef std::shared_ptr<vm_value_cell> vm_value;
+typedef std::vector<vm_value>          vm_values;
+
+/** \brief Runtime value. Types and proofs are erased, i.e., they are represented by a neutral value. */
+struct vm_value_cell {
+    vm_value_kind m_kind;
+    vm_value_cell(vm_value_kind k):m_kind(k) {}
+    virtual ~vm_value_cell() {}
+};
+
+/** \brief Machine integer representation for the values of \c nat, \c pos_num and \c num. */
+struct vm_num : public vm_value_cell {
+    mpz m_val;
+    vm_num(mpz const & v):vm_value_cell(vm_value_kind::Num), m_val(v) {}
+};
+
+/** \brief Constructor application, the parameters of the inductive datatype are not stored. */
+struct vm_constructor : public vm_value_cell {
+    unsigned  m_cidx;
+    vm_values m_fields;
+    vm_constructor(unsigned cidx, vm_values const & fields):
+        vm_value_cell(vm_value_kind::Constructor), m_cidx(cidx), m_fields(fields) {}
+};
+
+enum class vm_opcode { Var, Neutral, Global, Closure, Apply };
+
+/** \brief Bytecode instruction. The meaning of \c m_idx depends on the opcode:
+    - Var:     position of the variable in the environment
+    - Global:  index in the table of global constants
+    - Closure: index in the table of functions
+    - Apply:   number of arguments on the top of the stack */
+struct vm_instr {
+    vm_opcode m_op;
+    unsigned  m_idx;
+    vm_instr(vm_opcode op, unsigned idx = 0):m_op(op), m_idx(idx) {}
+};
+
+typedef std::function<vm_value(vm_values const &)> vm_builtin;
+
+/** \brief Function of the given arity. The body is either bytecode, or a builtin
+    implementing constructors, recursors and quotient operations. */
+struct vm_function {
+    unsigned              m_arity;
+    std::vector<vm_instr> m_code;
+    vm_builtin            m_builtin;
+    vm_function(unsigned arity):m_arity(arity) {}
+    vm_function(unsigned arity, vm_builtin const & fn):m_arity(arity), m_builtin(fn) {}
+};
+typedef std::shared_ptr<vm_function> vm_function_ptr;
+
+/** \brief Function together with the captured environment and the arguments received so far. */
+struct vm_closure : public vm_value_cell {
+    vm_function_ptr m_fn;
+    vm_values       m_env;
+    vm_values       m_args;
+    vm_closure(vm_function_ptr const & fn, vm_values const & env, vm_values const & args):
+        vm_value_cell(vm_value_kind::Closure), m_fn(fn), m_env(env), m_args(args) {}
+};
+
+/** \brief Suspended computation. We use them for global constants and for the recursive results
+    passed to minor premises. The latter avoids an exponential blowup when a recursor is used
+    to implement pattern matching (e.g., \c cases_on and \c brec_on). */
+struct vm_thunk : public vm_value_cell {
+    std::function<vm_value()> m_code;
+    vm_value                  m_result;
+    vm_thunk(std::function<vm_value()> const & code):vm_value_cell(vm_value_kind::Thunk), m_code(code) {}
+};
+
+enum class vm_native { None, Nat, PosNum, Num };
+
+struct vm_field_info {
+    bool               m_rec;    // true if it is a recursive argument
+    unsigned           m_nargs;  // number of arguments of a recursive argument of the form (Pi (x : A), C ...)
+    name               m_type;   // inductive datatype of a recursive argument
+    optional<unsigned> m_index;  // position of the field in the indices of the resulting type (e.g., x in acc.intro)
+    // for each index of the type of a recursive argument, the position of the argument of the recursive argument
+    // it is equal to, if any (e.g., y in the recursive argument (Pi y, R y x -> acc R y) of acc.intro)
+    std::vector<optional<unsigned>> m_rec_indices;
+    vm_field_info():m_rec(false), m_nargs(0) {}
+};
+
+struct vm_intro_info {
+    name                       m_name;
+    std::vector<vm_field_info> m_fields;
+};
+
+struct vm_inductive_info {
+    name                       m_name;
+    unsigned                   m_nparams;
+    unsigned                   m_ntype_formers;
+    unsigned                   m_nminors;
+    unsigned                   m_nindices;
+    unsigned                   m_minor_offset; // position of the first minor premise for this datatype
+    std::vector<vm_intro_info> m_intros;
+    vm_native                  m_native;
+};
+typedef std::shared_ptr<vm_inductive_info> vm_inductive_info_ptr;
+
+static unsigned get_cidx(vm_inductive_info const & info, name const & c) {
+    for (unsigned i = 0; i < info.m_intros.size(); i++) {
+        if (info.m_intros[i].m_name == c)
+            return i;
+    }
+    lean_unreachable();
+}
+
+static bool has_intro(vm_inductive_info const & info, name const & c, unsigned nfields) {
+    for (vm_intro_info const & ir : info.m_intros) {
+        if (ir.m_name == c)
+            return ir.m_fields.size() == nfields;
+    }
+    return false;
+}
+
+static bool is_rec_field(vm_inductive_info const & info, name const & c) {
+    vm_intro_info const & ir = info.m_intros[get_cidx(info, c)];
+    return ir.m_fields[0].m_rec && ir.m_fields[0].m_nargs == 0;
+}
+
+class vm_machine {
+    environment                       m_env;
+    type_checker                      m_tc;
+    name_generator                    m_ngen;
+    vm_value                          m_neutral;
+    std::vector<vm_function_ptr>      m_functions;
+    vm_values                         m_globals;
+    name_map<unsigned>                m_global_idx;
+    name_map<vm_inductive_info_ptr>   m_inductive_info;
+
+    [[ noreturn ]] void throw_vm_exception() {
+        throw vm_exception("bytecode evaluator failed");
+    }
+
+    vm_value mk_num(mpz const & v) {
+        return std::make_shared<vm_num>(v);
+    }
+
+    vm_value mk_builtin(unsigned arity, vm_builtin const & fn) {
+        return std::make_shared<vm_closure>(std::make_shared<vm_function>(arity, fn), vm_values(), vm_values());
+    }
+
+    vm_value mk_thunk(std::function<vm_value()> const & fn) {
+        return std::make_shared<vm_thunk>(fn);
+    }
+
+    vm_value force(vm_value v) {
+        while (v->m_kind == vm_value_kind::Thunk) {
+            vm_thunk * t = static_cast<vm_thunk*>(v.get());
+            if (!t->m_result) {
+                t->m_result = t->m_code();
+                t->m_code   = nullptr;
+            }
+            v = t->m_result;
+        }
+        return v;
+    }
+
+    mpz const & get_num(vm_value const & v) {
+        if (v->m_kind != vm_value_kind::Num)
+            throw_vm_exception();
+        return static_cast<vm_num const *>(v.get())->m_val;
+    }
+
+    /** \brief Collect information about the inductive datatypes that were declared simultaneously with \c n. */
+    void init_inductive_info(name const & n) {
+        auto decls = inductive::is_inductive_decl(m_env, n);
+        if (!decls)
+            throw_vm_exception();
+        unsigned nparams       = std::get<1>(*decls);
+        unsigned ntype_formers = *inductive::get_num_type_formers(m_env, n);
+        unsigned nminors       = *inductive::get_num_minor_premises(m_env, n);
+        name_set group;
+        for (inductive::inductive_decl const & d : std::get<2>(*decls))
+            group.insert(inductive::inductive_decl_name(d));
+        unsigned offset = 0;
+        for (inductive::inductive_decl const & d : std::get<2>(*decls)) {
+            auto info             = std::make_shared<vm_inductive_info>();
+            info->m_name          = inductive::inductive_decl_name(d);
+            info->m_nparams       = nparams;
+            info->m_ntype_formers = ntype_formers;
+            info->m_nminors       = nminors;
+            info->m_nindices      = *inductive::get_num_indices(m_env, info->m_name);
+            info->m_minor_offset  = offset;
+            info->m_native        = vm_native::None;
+            for (inductive::intro_rule const & r : inductive::inductive_decl_intros(d)) {
+                vm_intro_info ir;
+                ir.m_name = inductive::intro_rule_name(r);
+                expr t    = inductive::intro_rule_type(r);
+                for (unsigned i = 0; i < nparams; i++)
+                    t = binding_body(t);
+                while (is_pi(t)) {
+                    vm_field_info f;
+                    expr dom = binding_domain(t);
+                    while (is_pi(dom)) {
+                        dom = binding_body(dom);
+                        f.m_nargs++;
+                    }
+                    expr const & h = get_app_fn(dom);
+                    if (is_constant(h) && group.contains(const_name(h))) {
+                        f.m_rec  = true;
+                        f.m_type = const_name(h);
+                        buffer<expr> idxs;
+                        get_app_args(dom, idxs);
+                        for (unsigned j = nparams; j < idxs.size(); j++) {
+                            if (is_var(idxs[j]) && var_idx(idxs[j]) < f.m_nargs)
+                                f.m_rec_indices.push_back(optional<unsigned>(f.m_nargs - var_idx(idxs[j]) - 1));
+                            else
+                                f.m_rec_indices.push_back(optional<unsigned>());
+                        }
+                    }
+                    ir.m_fields.push_back(f);
+                    t = binding_body(t);
+                }
+                buffer<expr> idxs;
+                get_app_args(t, idxs);
+                unsigned nfields = ir.m_fields.size();
+                for (unsigned j = nparams; j < idxs.size(); j++) {
+                    if (is_var(idxs[j]) && var_idx(idxs[j]) < nfields)
+                        ir.m_fields[nfields - var_idx(idxs[j]) - 1].m_index = j - nparams;
+                }
+                info->m_intros.push_back(ir);
+            }
+            offset += info->m_intros.size();
+            m_inductive_info.insert(info->m_name, info);
+        }
+        init_native(n);
+    }
+
+    /** \brief Use machine integers for \c nat, \c pos_num and \c num if they have the expected shape. */
+    void init_native(name const & n) {
+        vm_inductive_info & info = **m_inductive_info.find(n);
+        if (info.m_nparams != 0 || info.m_nindices != 0 || info.m_ntype_formers != 1)
+            return;
+        if (n == get_nat_name()) {
+            if (info.m_intros.size() == 2 && has_intro(info, get_nat_zero_name(), 0) &&
+                has_intro(info, get_nat_succ_name(), 1) && is_rec_field(info, get_nat_succ_name()))
+                info.m_native = vm_native::Nat;
+        } else if (n == get_pos_num_name()) {
+            if (info.m_intros.size() == 3 && has_intro(info, get_pos_num_one_name(), 0) &&
+                has_intro(info, get_pos_num_bit0_name(), 1) && is_rec_field(info, get_pos_num_bit0_name()) &&
+                has_intro(info, get_pos_num_bit1_name(), 1) && is_rec_field(info, get_pos_num_bit1_name()))
+                info.m_native = vm_native::PosNum;
+        } else if (n == get_num_name()) {
+            if (info.m_intros.size() == 2 && has_intro(info, get_num_zero_name(), 0) &&
+                has_intro(info, get_num_pos_name(), 1) &&
+                has_num_decls(m_env) && get_info(get_pos_num_name()).m_native == vm_native::PosNum)
+                info.m_native = vm_native::Num;
+        }
+    }
+
+    vm_inductive_info_ptr get_info_ptr(name const & n) {
+        if (!m_inductive_info.contains(n))
+            init_inductive_info(n);
+        return *m_inductive_info.find(n);
+    }
+
+    vm_inductive_info const & get_info(name const & n) {
+        return *get_info_ptr(n);
+    }
+
+    vm_value mk_intro(name const & I, name const & c) {
+        vm_inductive_info const & info = get_info(I);
+        unsigned cidx = get_cidx(info, c);
+        switch (info.m_native) {
+        case vm_native::Nat:
+            if (c == get_nat_zero_name())
+                return mk_num(mpz(0));
+            return mk_builtin(1, [=](vm_values const & args) { return mk_num(get_num(force(args[0])) + 1); });
+        case vm_native::PosNum:
+            if (c == get_pos_num_one_name())
+                return mk_num(mpz(1));
+            else if (c == get_pos_num_bit0_name())
+                return mk_builtin(1, [=](vm_values const & args) {
+                        vm_value a = force(args[0]);
+                        mpz const & v = get_num(a);
+                        return mk_num(v + v);
+                    });
+            else
+                return mk_builtin(1, [=](vm_values const & args) {
+                        vm_value a = force(args[0]);
+                        mpz const & v = get_num(a);
+                        return mk_num(v + v + 1);
+                    });
+        case vm_native::Num:
+            if (c == get_num_zero_name())
+                return mk_num(mpz(0));
+            return mk_builtin(1, [=](vm_values const & args) { return force(args[0]); });
+        case vm_native::None:
+            break;
+        }
+        unsigned nparams = info.m_nparams;
+        unsigned arity   = nparams + info.m_intros[cidx].m_fields.size();
+        if (arity == 0)
+            return std::make_shared<vm_constructor>(cidx, vm_values());
+        return mk_builtin(arity, [=](vm_values const & args) {
+                return std::make_shared<vm_constructor>(cidx, vm_values(args.begin() + nparams, args.end()));
+            });
+    }
+
+    /** \brief Return the value passed to the minor premise for the recursive argument \c field. */
+    vm_value mk_rec_result(vm_values const & args, unsigned nprefix, vm_field_info const & f, vm_value const & field) {
+        vm_values prefix(args.begin(), args.begin() + nprefix);
+        vm_value rec      = m_globals[get_global(inductive::get_elim_name(f.m_type))];
+        unsigned nindices = get_info(f.m_type).m_nindices;
+        vm_value neutral  = m_neutral;
+        if (f.m_nargs == 0) {
+            return mk_thunk([=]() {
+                    vm_values rargs(prefix);
+                    rargs.resize(rargs.size() + nindices, neutral);
+                    rargs.push_back(field);
+                    return apply(rec, rargs);
+                });
+        } else {
+            std::vector<optional<unsigned>> rec_indices = f.m_rec_indices;
+            return mk_builtin(f.m_nargs, [=](vm_values const & ys) {
+                    vm_values rargs(prefix);
+                    for (unsigned j = 0; j < nindices; j++)
+                        rargs.push_back(j < rec_indices.size() && rec_indices[j] ? ys[*rec_indices[j]] : neutral);
+                    rargs.push_back(apply(field, ys));
+                    return apply(rec, rargs);
+                });
+        }
+    }
+
+    vm_value eval_rec(vm_inductive_info const & info, vm_values const & args) {
+        vm_value major = force(args.back());
+        unsigned cidx = 0;
+        vm_values fields;
+        if (major->m_kind == vm_value_kind::Num && info.m_native != vm_native::None) {
+            mpz const & n = get_num(major);
+            switch (info.m_native) {
+            case vm_native::Nat:
+                if (n.is_zero()) {
+                    cidx = get_cidx(info, get_nat_zero_name());
+                } else {
+                    cidx = get_cidx(info, get_nat_succ_name());
+                    fields.push_back(mk_num(n - 1));
+                }
+                break;
+            case vm_native::PosNum:
+                if (n == 1) {
+                    cidx = get_cidx(info, get_pos_num_one_name());
+                } else {
+                    cidx = get_cidx(info, n % mpz(2) == 1 ? get_pos_num_bit1_name() : get_pos_num_bit0_name());
+                    fields.push_back(mk_num(n / 2));
+                }
+                break;
+            case vm_native::Num:
+                if (n.is_zero()) {
+                    cidx = get_cidx(info, get_num_zero_name());
+                } else {
+                    cidx = get_cidx(info, get_num_pos_name());
+                    fields.push_back(major);
+                }
+                break;
+            case vm_native::None:
+                lean_unreachable();
+            }
+        } else if (major->m_kind == vm_value_kind::Constructor) {
+            vm_constructor const & c = static_cast<vm_constructor const &>(*major);
+            cidx   = c.m_cidx;
+            fields = c.m_fields;
+        } else if (major->m_kind == vm_value_kind::Neutral && info.m_intros.size() == 1) {
+            // The major premise is a proof of a proposition with a single constructor (e.g., eq, acc).
+            // A field that is also an index of the resulting type (e.g., x in acc.intro) is the corresponding
+            // index argument of the recursor. The other fields are neutral, the evaluator fails if one of them
+            // is not a proof and the minor premise inspects it.
+            cidx = 0;
+            unsigned indices_pos = info.m_nparams + info.m_ntype_formers + info.m_nminors;
+            for (vm_field_info const & f : info.m_intros[0].m_fields)
+                fields.push_back(f.m_index ? args[indices_pos + *f.m_index] : m_neutral);
+        } else {
+            throw_vm_exception();
+        }
+        unsigned nprefix = info.m_nparams + info.m_ntype_formers + info.m_nminors;
+        vm_value minor   = args[info.m_nparams + info.m_ntype_formers + info.m_minor_offset + cidx];
+        vm_intro_info const & ir = info.m_intros[cidx];
+        vm_values margs(fields);
+        for (unsigned i = 0; i < fields.size(); i++) {
+            if (ir.m_fields[i].m_rec)
+                margs.push_back(mk_rec_result(args, nprefix, ir.m_fields[i], fields[i]));
+        }
+        return apply(minor, margs);
+    }
+
+    vm_value mk_elim(name const & I) {
+        vm_inductive_info_ptr info = get_info_ptr(I);
+        unsigned arity = info->m_nparams + info->m_ntype_formers + info->m_nminors + info->m_nindices + 1;
+        return mk_builtin(arity, [=](vm_values const & args) { return eval_rec(*info, args); });
+    }
+
+    vm_value eval_global(name const & n) {
+        if (auto I = inductive::is_intro_rule(m_env, n))
+            return mk_intro(*I, n);
+        if (auto I = inductive::is_elim_rule(m_env, n))
+            return mk_elim(*I);
+        if (is_quotient_decl(m_env, n)) {
+            // quot.mk A s a is represented by a, and quot.lift A s B f H q reduces to f q
+            if (n == *g_quotient_mk)
+                return mk_builtin(3, [=](vm_values const & args) { return args[2]; });
+            else if (n == *g_quotient_lift)
+                return mk_builtin(6, [=](vm_values const & args) { return apply(args[3], vm_values({args[5]})); });
+            throw_vm_exception();
+        }
+        declaration d = m_env.get(n);
+        if (!d.is_definition() || m_tc.is_opaque(d))
+            throw_vm_exception();
+        buffer<expr> locals;
+        std::vector<vm_instr> code;
+        compile(unfold_untrusted_macros(m_env, d.get_value()), locals, code);
+        return run(code, vm_values());
+    }
+
+    unsigned get_global(name const & n) {
+        if (auto idx = m_global_idx.find(n))
+            return *idx;
+        unsigned idx = m_globals.size();
+        m_globals.push_back(mk_thunk([=]() { return eval_global(n); }));
+        m_global_idx.insert(n, idx);
+        return idx;
+    }
+
+    /** \brief Return true if \c e is a type or a proof. */
+    bool is_irrelevant(expr const & e) {
+        expr t = m_tc.whnf(m_tc.infer(e).first).first;
+        return is_sort(t) || m_tc.is_prop(t).first;
+    }
+
+    unsigned get_local_idx(buffer<expr> const & locals, expr const & e) {
+        unsigned i = locals.size();
+        while (i > 0) {
+            --i;
+            if (mlocal_name(locals[i]) == mlocal_name(e))
+                return i;
+        }
+        throw_vm_exception();
+    }
+
+    unsigned compile_lambda(expr e, buffer<expr> & locals) {
+        unsigned old_sz = locals.size();
+        while (is_lambda(e)) {
+            expr d = instantiate_rev(binding_domain(e), locals.size() - old_sz, locals.data() + old_sz);
+            locals.push_back(mk_local(m_ngen.next(), binding_name(e), d, binding_info(e)));
+            e = binding_body(e);
+        }
+        e = instantiate_rev(e, locals.size() - old_sz, locals.data() + old_sz);
+        auto fn = std::make_shared<vm_function>(locals.size() - old_sz);
+        compile(e, locals, fn->m_code);
+        locals.shrink(old_sz);
+        m_functions.push_back(fn);
+        return m_functions.size() - 1;
+    }
+
+    void compile_core(expr const & e, buffer<expr> & locals, std::vector<vm_instr> & code) {
+        switch (e.kind()) {
+        case expr_kind::Var: case expr_kind::Meta:
+            throw_vm_exception();
+        case expr_kind::Macro:
+            // Annotations (e.g., have-expressions, typed-expressions) do not change the value of their argument.
+            if (is_annotation(e)) {
+                compile_core(get_nested_annotation_arg(e), locals, code);
+            } else if (auto new_e = m_tc.expand_macro(e)) {
+                compile(*new_e, locals, code);
+            } else {
+                throw_vm_exception();
+            }
+            return;
+        case expr_kind::Sort: case expr_kind::Pi:
+            code.emplace_back(vm_opcode::Neutral);
+            return;
+        case expr_kind::Local:
+            code.emplace_back(vm_opcode::Var, get_local_idx(locals, e));
+            return;
+        case expr_kind::Constant:
+            code.emplace_back(vm_opcode::Global, get_global(const_name(e)));
+            return;
+        case expr_kind::Lambda:
+            code.emplace_back(vm_opcode::Closure, compile_lambda(e, locals));
+            return;
+        case expr_kind::App: {
+            buffer<expr> args;
+            expr const & fn = get_app_args(e, args);
+            compile_core(fn, locals, code);
+            for (expr const & a : args)
+                compile(a, locals, code);
+            code.emplace_back(vm_opcode::Apply, args.size());
+            return;
+        }}
+        lean_unreachable();
+    }
+
+    void compile(expr const & e, buffer<expr> & locals, std::vector<vm_instr> & code) {
+        check_system("bytecode compiler");
+        if (!is_local(e) && is_irrelevant(e))
+            code.emplace_back(vm_opcode::Neutral);
+        else
+            compile_core(e, locals, code);
+    }
+
+    vm_value call(vm_function const & fn, vm_values const & env) {
+        if (fn.m_builtin)
+            return fn.m_builtin(env);
+        else
+            return run(fn.m_code, env);
+    }
+
+    vm_value apply(vm_value f, vm_values args) {
+        if (args.empty())
+            return f; // e.g., minor premise of a constructor without fields
+        while (true) {
+            check_system("bytecode evaluator");
+            f = force(f);
+            if (f->m_kind == vm_value_kind::Neutral)
+                return f;
+            if (f->m_kind != vm_value_kind::Closure)
+                throw_vm_exception();
+            vm_closure const & c = static_cast<vm_closure const &>(*f);
+            unsigned arity = c.m_fn->m_arity;
+            vm_values all(c.m_args);
+            all.insert(all.end(), args.begin(), args.end());
+            if (all.size() < arity)
+                return std::make_shared<vm_closure>(c.m_fn, c.m_env, all);
+            vm_values env(c.m_env);
+            env.insert(env.end(), all.begin(), all.begin() + arity);
+            vm_value r = call(*c.m_fn, env);
+            if (all.size() == arity)
+                return r;
+            args.assign(all.begin() + arity, all.end());
+            f = r;
+        }
+    }
+
+    vm_value run(std::vector<vm_instr> const & code, vm_values const & env) {
+        vm_values stack;
+        for (vm_instr const & i : code) {
+            switch (i.m_op) {
+            case vm_opcode::Var:
+                stack.push_back(env[i.m_idx]);
+                break;
+            case vm_opcode::Neutral:
+                stack.push_back(m_neutral);
+                break;
+            case vm_opcode::Global:
+                stack.push_back(m_globals[i.m_idx]);
+                break;
+            case vm_opcode::Closure:
+                stack.push_back(std::make_shared<vm_closure>(m_functions[i.m_idx], env, vm_values()));
+                break;
+            case vm_opcode::Apply: {
+                vm_values args(stack.end() - i.m_idx, stack.end());
+                stack.resize(stack.size() - i.m_idx);
+                vm_value fn = stack.back();
+                stack.pop_back();
+                stack.push_back(apply(fn, args));
+                break;
+            }}
+        }
+        lean_assert(stack.size() == 1);
+        return stack.back();
+    }
+
+    /** \brief Convert the value \c v of type \c type back into a term. */
+    expr read_back(vm_value v, expr const & type) {
+        check_system("bytecode evaluator");
+        v = force(v);
+        buffer<expr> args;
+        expr t = m_tc.whnf(type).first;
+        expr const & I = get_app_args(t, args);
+        if (!is_constant(I) || !inductive::is_inductive_decl(m_env, const_name(I)))
+            throw_vm_exception();
+        vm_inductive_info const & info = get_info(const_name(I));
+        if (v->m_kind == vm_value_kind::Num) {
+            mpz const & n = get_num(v);
+            switch (info.m_native) {
+            case vm_native::Nat: {
+                expr succ = mk_constant(get_nat_succ_name());
+                expr r    = mk_constant(get_nat_zero_name());
+                for (mpz i(0); i < n; i += 1) {
+                    check_system("bytecode evaluator");
+                    r = mk_app(succ, r);
+                }
+                return r;
+            }
+            case vm_native::PosNum:
+                return app_arg(from_num(n));
+            case vm_native::Num:
+                return from_num(n);
+            case vm_native::None:
+                break;
+            }
+            throw_vm_exception();
+        }
+        if (v->m_kind != vm_value_kind::Constructor)
+            throw_vm_exception();
+        vm_constructor const & c = static_cast<vm_constructor const &>(*v);
+        name const & c_name = info.m_intros[c.m_cidx].m_name;
+        levels const & ls   = const_levels(I);
+        expr r              = mk_constant(c_name, ls);
+        expr c_type         = instantiate_type_univ_params(m_env.get(c_name), ls);
+        for (unsigned i = 0; i < info.m_nparams; i++) {
+            expr p = normalize(m_tc, args[i]);
+            r      = mk_app(r, p);
+            c_type = instantiate(binding_body(c_type), p);
+        }
+        for (vm_value const & f : c.m_fields) {
+            if (!is_pi(c_type))
+                c_type = m_tc.whnf(c_type).first;
+            expr a = read_back(f, binding_domain(c_type));
+            r      = mk_app(r, a);
+            c_type = instantiate(binding_body(c_type), a);
+        }
+        return r;
+    }
+
+public:
+    vm_machine(environment const & env):
+        m_env(env), m_tc(env),
+        m_neutral(std::make_shared<vm_value_cell>(vm_value_kind::Neutral)) {}
+
+    expr operator()(expr const & e) {
+        expr type = m_tc.infer(e).first;
+        expr const & I = get_app_fn(m_tc.whnf(type).first);
+        if (!is_constant(I) || !inductive::is_inductive_decl(m_env, const_name(I)))
+            throw_vm_exception();
+        buffer<expr> locals;
+        std::vector<vm_instr> code;
+        compile(unfold_untrusted_macros(m_env, e), locals, code);
+        return read_back(run(code, vm_values()), type);
+    }
+};
+
+static optional<expr> vm_eval_core(environment const & env, expr const & e) {
+    if (!closed(e) || has_local(e) || has_metavar(e))
+        return none_expr();
+    try {
+        return some_expr(vm_machine(env)(e));
+    } catch (exception &) {
+        return none_expr();
+    } catch (stack_space_exception &) {
+        return none_expr();
+    }
+}
+
+optional<expr> vm_eval(environment const & env, expr const & e) {
+    optional<expr> r = vm_eval_core(env, e);
+    if (r)
+        (*g_vm_eval_successes)++;
+    else
+        (*g_vm_eval_failures)++;
+    return r;
+}
+
+vm_eval_stats get_vm_eval_stats() {
+    vm_eval_stats r;
+    r.m_num_successes = *g_vm_eval_successes;
+    r.m_num_failures  = *g_vm_eval_failures;
+    return r;
+}
+
+void display_vm_eval_stats(std::ostream & out) {
+    vm_eval_stats st = get_vm_eval_stats();
+    out << "bytecode evaluator: " << st.m_num_successes << " successes, "
+        << st.m_num_failures << " failures\n";
+}
+
+void initialize_vm() {
+    g_eval_vm       = new name{"eval", "vm"};
+    g_quotient_mk   = new name{"quot", "mk"};
+    g_quotient_lift = new name{"quot", "lift"};
+    g_vm_eval_successes = new atomic<unsigned>(0);
+    g_vm_eval_failures  = new atomic<unsigned>(0);
+    register_bool_option(*g_eval_vm, LEAN_DEFAULT_EVAL_VM,
+                         "(eval) use the bytecode evaluator in the 'eval' command, "
+                         "and fall back to the normalizer when it fails");
+}
+
+void finalize_vm() {
+    delete g_eval_vm;
+    delete g_quotient_mk;
+    delete g_quotient_lift;
+    delete g_vm_eval_successes;
+    delete g_vm_eval_failures;
+}
+}
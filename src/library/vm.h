@@ -0,0 +1,40 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#pragma once
+#include <iostream>
+#include "util/sexpr/options.h"
+#include "kernel/environment.h"
+
+namespace lean {
+/** \brief Return true if the \c eval command should try the bytecode evaluator before \c normalize. */
+bool get_eval_vm(options const & opts);
+
+/** \brief Evaluate the closed term \c e using a bytecode compiler and a stack machine.
+
+    Definitions are compiled on demand (after unfolding untrusted macros) into a small bytecode
+    where types and proofs are erased, and the values of \c nat, \c pos_num and \c num are
+    represented by machine integers. The result is converted back into a term using the type of \c e,
+    and it coincides with the normal form of \c e.
+
+    Return none if \c e is not closed, its value is not a first-order datum (e.g., it is a function or
+    contains proofs), or the evaluation gets stuck (e.g., at an axiom or opaque definition).
+    In this case, the caller should fall back to \c normalize.
+*/
+optional<expr> vm_eval(environment const & env, expr const & e);
+
+/** \brief Number of terms evaluated by vm_eval (for all threads), and number of terms it returned none for. */
+struct vm_eval_stats {
+    unsigned m_num_successes;
+    unsigned m_num_failures;
+    vm_eval_stats():m_num_successes(0), m_num_failures(0) {}
+};
+vm_eval_stats get_vm_eval_stats();
+void display_vm_eval_stats(std::ostream & out);
+
+void initialize_vm();
+void finalize_vm();
+}
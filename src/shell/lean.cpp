@@ -25,6 +25,8 @@ Author: Leonardo de Moura
 #include "kernel/environment.h"
 #include "kernel/kernel_exception.h"
 #include "kernel/formatter.h"
+#include "kernel/default_converter.h"
+#include "kernel/instantiate.h"
 #include "library/standard_kernel.h"
 #include "library/hott_kernel.h"
 #include "library/module.h"
@@ -32,6 +34,8 @@ Author: Leonardo de Moura
 #include "library/io_state_stream.h"
 #include "library/definition_cache.h"
 #include "library/declaration_index.h"
+#include "library/vm.h"
+#include "library/tactic/tactic.h"
 #include "library/error_handling/error_handling.h"
 #include "frontends/lean/parser.h"
 #include "frontends/lean/pp.h"
@@ -485,6 +489,8 @@ int main(int argc, char ** argv) {
     script_state S = lean::get_thread_script_state();
     set_environment set1(S, env);
     set_io_state    set2(S, ios);
+    if (num_threads > 1)
+        lean::prewarm_thread_script_states(num_threads - 1);
     definition_cache   cache;
     definition_cache * cache_ptr = nullptr;
     if (use_cache) {
@@ -574,6 +580,13 @@ int main(int argc, char ** argv) {
             std::ofstream out(output, std::ofstream::binary);
             export_module(out, env);
         }
+        if (ios.get_options().get_bool("profile", false)) {
+            lean::display_thread_script_state_stats(std::cout);
+            lean::display_def_eq_failure_cache_stats(std::cout);
+            lean::display_instantiate_value_cache_stats(std::cout);
+            lean::display_vm_eval_stats(std::cout);
+            lean::display_par_all_goals_stats(std::cout);
+        }
         return ok ? 0 : 1;
     } catch (lean::throwable & ex) {
         lean::display_error(diagnostic(env, ios), nullptr, ex);
@@ -0,0 +1,314 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "util/test.h"
+#include "util/rb_map.h"
+#include "util/lazy_list_fn.h"
+#include "util/init_module.h"
+#include "util/sexpr/init_module.h"
+#include "kernel/environment.h"
+#include "kernel/type_checker.h"
+#include "kernel/abstract.h"
+#include "kernel/instantiate.h"
+#include "kernel/replace_fn.h"
+#include "kernel/init_module.h"
+#include "library/max_sharing.h"
+#include "library/kernel_serializer.h"
+#include "library/init_module.h"
+using namespace lean;
+
+/**
+   \brief Micro-benchmarks for the kernel and the basic data structures.
+
+   Each benchmark is executed LEAN_BENCH_REPETITIONS times, and we report the minimum and median
+   running times of the repetitions. The inputs are deterministic, and the number of iterations
+   is fixed, so the results of different commits can be compared.
+
+   Usage: kernel_bench [-o file] [-f filter]
+
+   The results are written (one JSON object per line) to the standard output, or to the given file.
+   If a filter is provided, then only the benchmarks whose name contains it are executed.
+*/
+#ifndef LEAN_BENCH_REPETITIONS
+#define LEAN_BENCH_REPETITIONS 5
+#endif
+
+// Results are accumulated here to prevent the compiler from removing the benchmarked code.
+static unsigned g_sink = 0;
+
+class bench_runner {
+    std::ostream & m_out;
+    char const *   m_filter;
+public:
+    bench_runner(std::ostream & out, char const * filter):m_out(out), m_filter(filter) {}
+
+    /** \brief Execute \c f \c iterations times, and report its running time. */
+    template<typename F>
+    void run(char const * name, unsigned iterations, F && f) {
+        if (m_filter && !strstr(name, m_filter))
+            return;
+        std::vector<double> times;
+        for (unsigned r = 0; r < LEAN_BENCH_REPETITIONS; r++) {
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned i = 0; i < iterations; i++)
+                f(i);
+            auto end   = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+        }
+        std::sort(times.begin(), times.end());
+        m_out << "{\"name\": \"" << name << "\", \"iterations\": " << iterations
+              << ", \"repetitions\": " << LEAN_BENCH_REPETITIONS
+              << ", \"min_ns\": " << static_cast<unsigned long long>(times.front())
+              << ", \"median_ns\": " << static_cast<unsigned long long>(times[times.size() / 2]) << "}" << std::endl;
+    }
+};
+
+static environment add_decl(environment const & env, declaration const & d) {
+    return env.add(check(env, d, name_generator("bench")));
+}
+
+/** \brief Return a complete binary tree of applications of height \c h, the leaves are \c x and \c a. */
+static expr mk_tree(expr const & f, expr const & x, expr const & a, unsigned h) {
+    if (h == 0)
+        return x;
+    return mk_app(f, mk_tree(f, x, a, h - 1), h % 2 == 0 ? a : mk_tree(f, a, x, h - 1));
+}
+
+/** \brief Similar to mk_tree, but the subterms are not shared. */
+static expr mk_unshared_tree(unsigned h) {
+    if (h == 0)
+        return mk_constant("a");
+    return mk_app(mk_constant("f"), mk_unshared_tree(h - 1), mk_unshared_tree(h - 1));
+}
+
+static void bench_expr(bench_runner & b) {
+    expr f = Const("f");
+    expr a = Const("a");
+    b.run("expr/mk_app", 100000, [&](unsigned i) {
+            expr e = mk_app(f, mk_var(i % 16), a);
+            g_sink += e.hash();
+        });
+    b.run("expr/max_sharing", 20, [&](unsigned) {
+            expr e = max_sharing_fn()(mk_unshared_tree(12));
+            g_sink += get_weight(e);
+        });
+    expr x    = mk_var(0);
+    expr body = mk_tree(f, x, a, 14);
+    b.run("expr/instantiate", 200, [&](unsigned i) {
+            expr e = instantiate(body, mk_var(i));
+            g_sink += e.hash();
+        });
+    expr t    = mk_tree(f, a, Const("b"), 14);
+    b.run("expr/replace", 200, [&](unsigned i) {
+            expr c = mk_var(i);
+            expr e = replace(t, [&](expr const & s, unsigned) {
+                    if (is_constant(s) && const_name(s) == "a")
+                        return some_expr(c);
+                    return none_expr();
+                });
+            g_sink += e.hash();
+        });
+}
+
+/** \brief Creation, comparison, normalization and is_geq for universe levels.
+    The levels are built from a small set of parameters, so structurally equal levels are created repeatedly. */
+static void bench_level(bench_runner & b) {
+    std::vector<level> ps;
+    for (unsigned i = 0; i < 64; i++)
+        ps.push_back(mk_param_univ(name("u", i)));
+    auto mk_level = [&](unsigned i) {
+        return mk_succ(mk_max(mk_succ(ps[i % 64]), mk_imax(ps[(i * 7) % 64], mk_succ(ps[(i * 13) % 64]))));
+    };
+    b.run("level/mk", 100000, [&](unsigned i) {
+            g_sink += hash(mk_level(i));
+        });
+    b.run("level/eq", 100000, [&](unsigned i) {
+            g_sink += mk_level(i) == mk_level(i + 64);
+        });
+    b.run("level/normalize", 100000, [&](unsigned i) {
+            g_sink += hash(normalize(mk_level(i)));
+        });
+    b.run("level/is_geq", 100000, [&](unsigned i) {
+            g_sink += is_geq(mk_succ(mk_level(i)), mk_max(mk_level(i), ps[(i * 7) % 64]));
+        });
+}
+
+/** \brief Environment containing the definitions
+      f_0     := fun (A : Type) (x : A), x
+      f_{k+1} := fun (A : Type) (x : A), f_k A (f_k A x)
+    and copies g_k of them. Unfolding f_k A x produces 2^k nested applications. */
+static environment mk_bench_env(unsigned n) {
+    environment env;
+    expr A = Local("A", mk_Type());
+    expr x = Local("x", A);
+    for (char const * p : {"f", "g"}) {
+        env = add_decl(env, mk_definition(name(p, 0u), level_param_names(), Pi(A, A >> A), Fun({A, x}, x)));
+        for (unsigned k = 0; k < n; k++) {
+            expr fk = mk_constant(name(p, k));
+            env = add_decl(env, mk_definition(name(p, k+1), level_param_names(), Pi(A, A >> A),
+                                              Fun({A, x}, mk_app(fk, A, mk_app(fk, A, x)))));
+        }
+    }
+    return env;
+}
+
+static void bench_type_checker(bench_runner & b) {
+    unsigned n      = 10;
+    environment env = mk_bench_env(n);
+    expr A  = Local("A", mk_Type());
+    expr a  = Local("a", A);
+    expr fn = mk_app(mk_constant(name("f", n)), A, a);
+    expr gn = mk_app(mk_constant(name("g", n)), A, a);
+    b.run("type_checker/whnf", 20, [&](unsigned) {
+            type_checker tc(env);
+            g_sink += tc.whnf(fn).first.hash();
+        });
+    b.run("type_checker/is_def_eq", 20, [&](unsigned) {
+            type_checker tc(env);
+            g_sink += tc.is_def_eq(fn, gn).first;
+        });
+    expr t  = a;
+    for (unsigned i = 0; i < 1000; i++)
+        t = mk_app(mk_constant(name("f", i % n)), A, t);
+    b.run("type_checker/infer_type", 100, [&](unsigned) {
+            type_checker tc(env);
+            g_sink += tc.infer(t).first.hash();
+        });
+    b.run("type_checker/check", 100, [&](unsigned) {
+            type_checker tc(env);
+            g_sink += tc.check(t).first.hash();
+        });
+}
+
+static void bench_environment(bench_runner & b) {
+    unsigned n = 10000;
+    environment env;
+    for (unsigned i = 0; i < n; i++)
+        env = add_decl(env, mk_axiom(name("c", i), level_param_names(), mk_Prop()));
+    b.run("environment/find", 10, [&](unsigned) {
+            for (unsigned i = 0; i < n; i++)
+                g_sink += static_cast<bool>(env.find(name("c", i)));
+        });
+    b.run("environment/add", 10, [&](unsigned i) {
+            environment new_env = env;
+            for (unsigned j = 0; j < 1000; j++)
+                new_env = add_decl(new_env, mk_axiom(name(name("d", i), j), level_param_names(), mk_Prop()));
+            g_sink += static_cast<bool>(new_env.find(name(name("d", i), 0u)));
+        });
+}
+
+static void bench_serializer(bench_runner & b) {
+    environment env = mk_bench_env(10);
+    std::vector<declaration> decls;
+    env.for_each_declaration([&](declaration const & d) { decls.push_back(d); });
+    expr t = mk_tree(Const("f"), Const("a"), Const("b"), 14);
+    auto write = [&]() {
+        std::ostringstream out;
+        serializer s(out);
+        s << t;
+        for (declaration const & d : decls)
+            s << d;
+        return out.str();
+    };
+    b.run("serializer/write", 100, [&](unsigned) {
+            g_sink += write().size();
+        });
+    std::string data = write();
+    b.run("serializer/read", 100, [&](unsigned) {
+            std::istringstream in(data);
+            deserializer d(in);
+            g_sink += read_expr(d).hash();
+            for (unsigned i = 0; i < decls.size(); i++)
+                g_sink += read_declaration(d, 0).get_num_univ_params();
+        });
+}
+
+static void bench_rb_map(bench_runner & b) {
+    typedef rb_map<unsigned, unsigned, unsigned_cmp> map;
+    unsigned n = 10000;
+    map m;
+    b.run("rb_map/insert", 20, [&](unsigned) {
+            map new_m;
+            for (unsigned i = 0; i < n; i++)
+                new_m.insert((i * 7919) % n, i);
+            g_sink += new_m.size();
+        });
+    for (unsigned i = 0; i < n; i++)
+        m.insert(i, i);
+    b.run("rb_map/find", 20, [&](unsigned) {
+            for (unsigned i = 0; i < n; i++)
+                g_sink += *m.find((i * 7919) % n);
+        });
+    b.run("rb_map/erase", 20, [&](unsigned) {
+            map new_m = m;
+            for (unsigned i = 0; i < n; i++)
+                new_m.erase((i * 7919) % n);
+            g_sink += new_m.size();
+        });
+}
+
+/** \brief Latency of the parallel combinators for short-running alternatives. */
+static void bench_lazy_list_par(bench_runner & b) {
+    lazy_list<unsigned> l1(1u);
+    lazy_list<unsigned> l2(2u);
+    b.run("lazy_list/par", 1000, [&](unsigned) {
+            g_sink += par(l1, l2).pull()->first;
+        });
+    b.run("lazy_list/timeout", 1000, [&](unsigned) {
+            g_sink += timeout(l1, 10000).pull()->first;
+        });
+    std::vector<lazy_list<unsigned>> ls({lazy_list<unsigned>(), l1, l2, lazy_list<unsigned>()});
+    b.run("lazy_list/first_success_par", 1000, [&](unsigned) {
+            g_sink += first_success_par(ls).pull()->first;
+        });
+}
+
+int main(int argc, char ** argv) {
+    char const * output = nullptr;
+    char const * filter = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [-o file] [-f filter]" << std::endl;
+            return 1;
+        }
+    }
+    save_stack_info();
+    initialize_util_module();
+    initialize_sexpr_module();
+    initialize_kernel_module();
+    initialize_library_module();
+    {
+        std::ofstream file;
+        if (output)
+            file.open(output);
+        bench_runner b(output ? file : std::cout, filter);
+        bench_expr(b);
+        bench_level(b);
+        bench_type_checker(b);
+        bench_environment(b);
+        bench_serializer(b);
+        bench_rb_map(b);
+        bench_lazy_list_par(b);
+    }
+    std::cerr << "checksum: " << g_sink << std::endl;
+    finalize_library_module();
+    finalize_kernel_module();
+    finalize_sexpr_module();
+    finalize_util_module();
+    return 0;
+}
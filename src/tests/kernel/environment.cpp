@@ -12,6 +12,7 @@ Author: Leonardo de Moura
 #include "util/sexpr/init_module.h"
 #include "kernel/environment.h"
 #include "kernel/type_checker.h"
+#include "kernel/default_converter.h"
 #include "kernel/abstract.h"
 #include "kernel/kernel_exception.h"
 #include "kernel/init_module.h"
@@ -173,6 +174,66 @@ static void tst4() {
     }
 }
 
+static void tst5() {
+    environment env;
+    batch_checker checker;
+    expr Type = mk_Type();
+    expr A    = Local("A", Type);
+    expr x    = Local("x", A);
+    env = env.add(checker.check(env, mk_definition("id", level_param_names(), Pi(A, A >> A), Fun({A, x}, x))));
+    expr id   = Const("id");
+    // the new declaration uses id, the type checker environment must be updated
+    env = env.add(checker.check(env, mk_definition("id2", level_param_names(), Pi(A, A >> A),
+                                                   Fun({A, x}, mk_app(id, A, mk_app(id, A, x))))));
+    lean_assert(env.find("id2"));
+    try {
+        env.add(checker.check(env, mk_definition("id3", level_param_names(), Pi(A, A >> A), Fun({A, x}, A))));
+        lean_unreachable();
+    } catch (kernel_exception & ex) {
+        std::cout << "expected error: " << ex.pp(mk_formatter(ex.get_environment())) << "\n";
+    }
+    // declaration with different universe level parameters
+    level l    = mk_param_univ("l");
+    expr B     = Local("B", mk_sort(l));
+    expr y     = Local("y", B);
+    env = env.add(checker.check(env, mk_definition("idl", to_list(name("l")), Pi(B, B >> B), Fun({B, y}, y))));
+    try {
+        // l is not a universe level parameter of the new declaration
+        env.add(checker.check(env, mk_definition("idl2", level_param_names(), Pi(B, B >> B), Fun({B, y}, y))));
+        lean_unreachable();
+    } catch (kernel_exception & ex) {
+        std::cout << "expected error: " << ex.pp(mk_formatter(ex.get_environment())) << "\n";
+    }
+    // environment that is not a descendant of the previous one
+    environment env2;
+    env2 = env2.add(checker.check(env2, mk_definition("id", level_param_names(), Pi(A, A >> A), Fun({A, x}, x))));
+    lean_assert(env2.find("id"));
+    lean_assert(!env2.find("id2"));
+}
+
+static void tst6() {
+    environment env;
+    expr Type = mk_Type();
+    expr A    = Local("A", Type);
+    expr x    = Local("x", A);
+    env = add_decl(env, mk_definition("id", level_param_names(), Pi(A, A >> A), Fun({A, x}, x)));
+    env = add_decl(env, mk_definition("k", level_param_names(), Pi(A, A >> (A >> A)), Fun({A, x}, Fun(Local("y", A), x))));
+    expr id = Const("id");
+    expr k  = Const("k");
+    expr y  = Local("y", A);
+    type_checker tc(env);
+    expr t = mk_app(id, A, x);
+    expr s = mk_app(k, A, y, x);
+    unsigned old_hits = get_def_eq_failure_cache_stats().m_num_hits;
+    lean_assert(!tc.is_def_eq(t, s).first);
+    // the second check is answered by the failure cache
+    lean_assert(!tc.is_def_eq(t, s).first);
+    lean_assert(tc.is_def_eq(t, mk_app(k, A, x, y)).first);
+    unsigned new_hits = get_def_eq_failure_cache_stats().m_num_hits;
+    std::cout << "failure cache hits: " << new_hits - old_hits << "\n";
+    lean_assert(new_hits > old_hits);
+}
+
 namespace lean {
 class environment_id_tester {
 public:
@@ -259,6 +320,8 @@ int main() {
     tst2();
     tst3();
     tst4();
+    tst5();
+    tst6();
     environment_id_tester::tst1();
     environment_id_tester::tst2();
     finalize_library_module();
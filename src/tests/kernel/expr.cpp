@@ -374,6 +374,55 @@ static void tst18() {
     lean_assert(!has_local(mk_app(f, a0, a0, a0, a0)));
 }
 
+static void tst19() {
+    expr f    = Const("f");
+    expr Type = mk_Type();
+    expr A    = Local("A", Type);
+    expr m    = mk_metavar("m", A);
+    buffer<expr> ls;
+    for (unsigned i = 0; i < 100; i++)
+        ls.push_back(Local(name("x", i), A));
+    lean_assert(get_mlocal_filter(f) == 0);
+    lean_assert(get_mlocal_filter(Var(0)) == 0);
+    lean_assert(get_mlocal_filter(Type) == 0);
+    lean_assert(may_contain_mlocal(A, "A"));
+    // the filter of local constants and metavariables includes the ones in their types
+    lean_assert(may_contain_mlocal(m, "m"));
+    lean_assert(may_contain_mlocal(m, "A"));
+    lean_assert(may_contain_mlocal(ls[10], "A"));
+    expr t = mk_app(f, m, ls[3], ls[7]);
+    lean_assert(may_contain_mlocal(t, "m"));
+    lean_assert(may_contain_mlocal(t, name("x", 3)));
+    lean_assert(may_contain_mlocal(t, name("x", 7)));
+    lean_assert(get_mlocal_filter(t) == (get_mlocal_filter(m) | get_mlocal_filter(ls[3]) | get_mlocal_filter(ls[7])));
+    expr b = Fun(ls[3], t);
+    // the filter of a binder is the union of the filters of its domain and body
+    lean_assert(get_mlocal_filter(b) == (get_mlocal_filter(A) | get_mlocal_filter(binding_body(b))));
+    lean_assert(get_mlocal_filter(binding_body(b)) == (get_mlocal_filter(m) | get_mlocal_filter(ls[7])));
+    lean_assert((get_mlocal_filter(b) & ~get_mlocal_filter(t)) == 0);
+    lean_assert(has_local(b) && has_local(binding_body(b)));
+    // abstracted local constants are not in the filter
+    expr y = Local("y", Type);
+    expr c = Fun(y, mk_app(f, y, y));
+    lean_assert(!has_local(c));
+    lean_assert(get_mlocal_filter(c) == 0);
+    lean_assert(!may_contain_mlocal(c, "y"));
+    // there are no false negatives
+    for (expr const & l : ls) {
+        lean_assert(may_contain_mlocal(mk_app(f, l), mlocal_name(l)));
+        lean_assert(may_contain_mlocal(Pi(A, mk_app(f, l)), mlocal_name(l)));
+    }
+    // the filter is a conservative approximation, a few names must not be in the filter of t
+    unsigned num_absent = 0;
+    for (expr const & l : ls) {
+        if (!may_contain_mlocal(t, mlocal_name(l))) {
+            num_absent++;
+            lean_assert(is_eqp(abstract_local(t, mlocal_name(l)), t));
+        }
+    }
+    lean_assert(num_absent > 0);
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -400,6 +449,7 @@ int main() {
     tst16();
     tst17();
     tst18();
+    tst19();
     std::cout << "sizeof(expr):            " << sizeof(expr) << "\n";
     std::cout << "sizeof(expr_cell):       " << sizeof(expr_cell) << "\n";
     std::cout << "sizeof(expr_app):        " << sizeof(expr_app) << "\n";
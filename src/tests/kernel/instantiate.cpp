@@ -5,10 +5,12 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include "util/test.h"
+#include "util/thread.h"
 #include "util/init_module.h"
 #include "util/sexpr/init_module.h"
 #include "kernel/abstract.h"
 #include "kernel/instantiate.h"
+#include "kernel/declaration.h"
 #include "kernel/init_module.h"
 #include "library/init_module.h"
 using namespace lean;
@@ -35,12 +37,36 @@ static void tst1() {
     lean_assert(beta_reduce(F3) == mk_app(f, a, a));
 }
 
+static void tst2() {
+    level u  = mk_param_univ("u");
+    level l1 = mk_succ(mk_level_zero());
+    declaration d1 = mk_definition("T", to_list(name("u")), mk_sort(mk_succ(u)), mk_sort(u));
+    expr v1 = instantiate_value_univ_params(d1, to_list(l1));
+    lean_assert_eq(v1, mk_sort(l1));
+    lean_assert(is_eqp(instantiate_value_univ_params(d1, to_list(l1)), v1));
+    // a different declaration with the same name must not reuse the cached value
+    declaration d2 = mk_definition("T", to_list(name("u")), mk_sort(mk_succ(mk_succ(u))), mk_sort(mk_succ(u)));
+    expr v2 = instantiate_value_univ_params(d2, to_list(l1));
+    lean_assert_eq(v2, mk_sort(mk_succ(l1)));
+    std::cout << v1 << " " << v2 << "\n";
+#if defined(LEAN_MULTI_THREAD)
+    // other threads reuse the value instantiated by the main thread
+    unsigned old_hits = get_instantiate_value_cache_stats().m_num_hits;
+    thread t([&]() { lean_assert(is_eqp(instantiate_value_univ_params(d1, to_list(l1)), v1)); });
+    t.join();
+    unsigned new_hits = get_instantiate_value_cache_stats().m_num_hits;
+    std::cout << "shared cache hits: " << new_hits - old_hits << "\n";
+    lean_assert(new_hits == old_hits + 1);
+#endif
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
     initialize_sexpr_module();
     initialize_kernel_module();
     tst1();
+    tst2();
     finalize_kernel_module();
     finalize_sexpr_module();
     finalize_util_module();
@@ -5,7 +5,9 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <locale>
+#include <vector>
 #include "util/test.h"
+#include "util/thread.h"
 #include "util/exception.h"
 #include "util/init_module.h"
 #include "util/sexpr/init_module.h"
@@ -65,6 +67,47 @@ static void tst2() {
     lean_assert(!is_equivalent(zero, p2));
 }
 
+static void tst3() {
+    level u  = mk_param_univ("u");
+    level v  = mk_param_univ("v");
+    level l1 = mk_max(mk_succ(u), v);
+    level l2 = mk_max(mk_succ(mk_param_univ("u")), mk_param_univ("v"));
+    lean_assert(l1 == l2);
+#if defined(LEAN_HASH_CONS_LEVELS)
+    // levels are hash-consed
+    lean_assert(is_eqp(l1, l2));
+    lean_assert(!is_eqp(mk_imax(u, v), mk_max(u, v)));
+    lean_assert(is_eqp(mk_succ(mk_level_zero()), mk_level_one()));
+#endif
+    level l3 = mk_max(v, mk_succ(u));
+    lean_assert(l1 != l3);
+    lean_assert(is_equivalent(l1, l3));
+    lean_assert(normalize(l1) == normalize(l3));
+    lean_assert(is_geq(mk_succ(l1), l3));
+    lean_assert(!is_geq(u, l3));
+    lean_assert(!is_geq(u, l3)); // served by the is_geq cache
+#if defined(LEAN_MULTI_THREAD)
+    // levels created concurrently by different threads
+    constexpr unsigned num_threads = 8;
+    constexpr unsigned num_levels  = 10000;
+    std::vector<thread> threads;
+    for (unsigned i = 0; i < num_threads; i++) {
+        threads.push_back(thread([=]() {
+                    for (unsigned j = 0; j < num_levels; j++) {
+                        level w1 = mk_succ(mk_max(mk_param_univ(name("w", j % 100)), mk_param_univ("u")));
+                        level w2 = mk_succ(mk_max(mk_param_univ(name("w", j % 100)), u));
+                        lean_assert(w1 == w2);
+#if defined(LEAN_HASH_CONS_LEVELS)
+                        lean_assert(is_eqp(w1, w2));
+#endif
+                    }
+                }));
+    }
+    for (thread & t : threads)
+        t.join();
+#endif
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -73,6 +116,7 @@ int main() {
     initialize_library_module();
     tst1();
     tst2();
+    tst3();
     finalize_library_module();
     finalize_kernel_module();
     finalize_sexpr_module();
@@ -155,6 +155,84 @@ static void tst4() {
     lean_assert(s.instantiate_metavars(t).first == mk_app(f, Prop, T2, a, m3));
 }
 
+static void tst5() {
+    expr Prop = mk_Prop();
+    expr m1  = mk_metavar("m1", Prop);
+    expr m2  = mk_metavar("m2", Prop);
+    expr m3  = mk_metavar("m3", Prop);
+    expr A   = mk_metavar("A", mk_Type());
+    expr x   = Local("x", A);
+    expr f   = Const("f");
+    expr a   = Const("a");
+    expr b   = Const("b");
+    expr t   = mk_app(f, m1, mk_app(f, m2, x));
+    substitution s;
+    s.assign(m1, mk_app(f, m2), mk_assumption_justification(0));
+    auto r1 = s.instantiate_metavars(t);
+    lean_assert_eq(r1.first, mk_app(f, mk_app(f, m2), mk_app(f, m2, x)));
+    // same substitution version, the cached result is reused
+    lean_assert(is_eqp(s.instantiate_metavars(t).first, r1.first));
+    lean_assert(is_eqp(s.instantiate(t), r1.first));
+    // branches of the same substitution
+    substitution s1 = s;
+    substitution s2 = s;
+    s1.assign(m2, a, mk_assumption_justification(1));
+    s2.assign(m2, b, mk_assumption_justification(2));
+    auto r2 = s1.instantiate_metavars(t);
+    lean_assert_eq(r2.first, mk_app(f, mk_app(f, a), mk_app(f, a, x)));
+    lean_assert_eq(s2.instantiate(t), mk_app(f, mk_app(f, b), mk_app(f, b, x)));
+    buffer<unsigned> ids;
+    collect_assumptions(r2.second, ids);
+    lean_assert(std::find(ids.begin(), ids.end(), 0) != ids.end());
+    lean_assert(std::find(ids.begin(), ids.end(), 1) != ids.end());
+    lean_assert(std::find(ids.begin(), ids.end(), 2) == ids.end());
+    // instantiate_all also instantiates the types of local constants
+    lean_assert_eq(s1.instantiate(t), r2.first);
+    s1.assign(A, Prop);
+    lean_assert(s1.instantiate(t) == r2.first);
+    lean_assert_eq(mlocal_type(app_arg(app_arg(s1.instantiate_all(t)))), Prop);
+    lean_assert_eq(mlocal_type(app_arg(app_arg(s.instantiate_all(t)))), A);
+    // the original substitution is not affected
+    lean_assert_eq(s.instantiate(t), r1.first);
+    s.assign(m2, m3);
+    lean_assert_eq(s.instantiate(t), mk_app(f, mk_app(f, m3), mk_app(f, m3, x)));
+}
+
+static void tst6() {
+    expr Prop = mk_Prop();
+    expr f    = Const("f");
+    expr a    = Const("a");
+    expr b    = Const("b");
+    expr x    = Local("x", Prop);
+    buffer<expr> ms;
+    for (unsigned i = 0; i < 100; i++)
+        ms.push_back(mk_metavar(name("m", i), Prop));
+    expr t = mk_app(f, mk_app(ms[0], x), mk_app(f, ms[1], ms[2]), mk_app(f, ms[3], ms[4]), ms[5]);
+    substitution s;
+    s.assign(ms[10], a);
+    s.assign(ms[11], mk_app(f, ms[10]));
+    // most metavariables are assigned before the cached result is created
+    for (unsigned i = 20; i < 90; i++)
+        s.assign(ms[i], b);
+    lean_assert_eq(s.instantiate(t), t);
+    // assignments containing metavariables assigned before the cached result was created
+    s.assign(ms[0], Fun(x, mk_app(f, ms[10], x)));
+    s.assign(ms[1], ms[11]);
+    lean_assert_eq(s.instantiate(t), mk_app(f, mk_app(f, a, x), mk_app(f, mk_app(f, a), ms[2]), mk_app(f, ms[3], ms[4]), ms[5]));
+    lean_assert_eq(s.instantiate_metavars(t).first, s.instantiate(t));
+    // many assignments after the cached result was created
+    substitution s2 = s;
+    for (unsigned i = 90; i < 100; i++)
+        s2.assign(ms[i], a);
+    s2.assign(ms[2], ms[95]);
+    for (unsigned i = 20; i < 30; i++)
+        s2.assign(mk_meta_univ(name("u", i)), mk_level_zero());
+    s2.assign(ms[5], b);
+    lean_assert_eq(s2.instantiate(t), mk_app(f, mk_app(f, a, x), mk_app(f, mk_app(f, a), a), mk_app(f, ms[3], ms[4]), b));
+    lean_assert_eq(s2.instantiate_metavars(t).first, s2.instantiate(t));
+    lean_assert_eq(s.instantiate(t), mk_app(f, mk_app(f, a, x), mk_app(f, mk_app(f, a), ms[2]), mk_app(f, ms[3], ms[4]), ms[5]));
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -166,6 +244,8 @@ int main() {
     tst2();
     tst3();
     tst4();
+    tst5();
+    tst6();
     finalize_library_module();
     finalize_kernel_module();
     finalize_sexpr_module();
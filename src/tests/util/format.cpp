@@ -126,6 +126,30 @@ static void tst6() {
     std::cout << flatten(r) << "\n";
 }
 
+static void tst7() {
+    // flat widths are cached when documents are created
+    format r = paren(format("foo") + line() + format(name{"bla", "boo"}) + nest(2, line() + format(10)));
+    lean_assert_eq(r.flat_width(), 16u);
+    lean_assert(is_name(format(name{"bla", "boo"})));
+    lean_assert(!is_name(format("bla")));
+    std::ostringstream s1, s2;
+    pretty(s1, 30, r);
+    pretty(s2, 10, r);
+    lean_assert_eq(s1.str(), "(foo bla.boo 10)");
+    lean_assert_eq(s2.str(), "(foo\n bla.boo\n   10)");
+}
+
+static void tst8() {
+    // deep documents must not exhaust the stack when they are rendered or deleted
+    format r;
+    for (unsigned i = 0; i < 100000; i++)
+        r += group(format("a") + line());
+    lean_assert_eq(r.flat_width(), 200000u);
+    std::ostringstream s;
+    pretty(s, 80, r);
+    lean_assert_eq(s.str().size(), 200000u);
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -136,6 +160,8 @@ int main() {
     tst4();
     tst5();
     tst6();
+    tst7();
+    tst8();
     finalize_sexpr_module();
     finalize_util_module();
     return has_violations() ? 1 : 0;
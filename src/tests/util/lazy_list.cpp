@@ -14,6 +14,8 @@ Author: Leonardo de Moura
 #include "util/lazy_list.h"
 #include "util/lazy_list_fn.h"
 #include "util/list.h"
+#include "util/init_module.h"
+#include "util/thread_pool.h"
 using namespace lean;
 
 lazy_list<int> seq(int s) {
@@ -196,13 +198,34 @@ void tst6() {
     lean_assert(counter == 5);
 }
 
+static void tst7() {
+#if defined(LEAN_MULTI_THREAD)
+    display(take(10, first_success_par(std::vector<lazy_list<int>>({loop(), lazy_list<int>(), seq(1)}))));
+    display(first_success_par(std::vector<lazy_list<int>>({lazy_list<int>(), from(1, 1, 3), lazy_list<int>()})));
+    lean_assert(!first_success_par(std::vector<lazy_list<int>>({lazy_list<int>(), lazy_list<int>()})).pull());
+    // no element can be computed in 0 milliseconds
+    lean_assert(!timeout(seq(1), 0).pull());
+    lean_assert(!timeout(loop(), 0).pull());
+    // the threads of the pool are reused
+    for (unsigned i = 0; i < 1000; i++) {
+        lean_assert(par(lazy_list<int>(1), lazy_list<int>(2)).pull());
+        lean_assert(timeout(lazy_list<int>(i), 10000).pull()->first == static_cast<int>(i));
+    }
+    std::cout << "number of threads: " << get_thread_pool().get_num_threads() << "\n";
+    lean_assert(get_thread_pool().get_num_threads() <= 8);
+#endif
+}
+
 int main() {
     save_stack_info();
+    initialize_util_module();
     tst1();
     tst2();
     tst3();
     tst4();
     tst5();
     tst6();
+    tst7();
+    finalize_util_module();
     return has_violations() ? 1 : 0;
 }
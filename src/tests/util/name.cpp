@@ -6,10 +6,14 @@ Author: Leonardo de Moura
 */
 #include <cstring>
 #include <sstream>
+#include <vector>
 #include "util/test.h"
+#include "util/thread.h"
+#include "util/timeit.h"
 #include "util/name.h"
 #include "util/name_generator.h"
 #include "util/name_set.h"
+#include "util/name_map.h"
 #include "util/init_module.h"
 using namespace lean;
 
@@ -172,6 +176,153 @@ static void tst13() {
     std::cout << c2.next() << "\n";
 }
 
+static void tst14() {
+    name n1{"foo", "bla", "tst"};
+    name n2 = string_to_name("foo.bla.tst");
+    lean_assert(name::ptr_eq()(n1, n2));
+    lean_assert(name::ptr_eq()(n1.get_prefix(), name({"foo", "bla"})));
+    lean_assert(name::ptr_eq()(name(name("x"), 10u), name(name("x"), 10u)));
+    lean_assert(!name::ptr_eq()(name(name("x"), 10u), name(name("x"), 11u)));
+    lean_assert(n1 + name("a") == name(n2, "a"));
+    lean_assert(is_prefix_of(name("foo"), n2));
+    lean_assert(is_prefix_of(name{"foo", "bla"}, n2));
+    lean_assert(!is_prefix_of(name{"foo", "tst"}, n2));
+    lean_assert(!is_prefix_of(name{"foo", "bla", "tst", "a"}, n2));
+    name_generator g("tmp");
+    name f1 = g.next();
+    name f2(name("tmp"), 0u);
+    lean_assert(f1 == f2);
+#if defined(LEAN_COMPACT_NAMES)
+    lean_assert(name::ptr_eq()(f1, f2));
+#endif
+    // deserialized names are interned
+    std::ostringstream out;
+    serializer s(out);
+    s << n1 << f1;
+    std::istringstream in(out.str());
+    deserializer d(in);
+    name r1, r2;
+    d >> r1 >> r2;
+    lean_assert(name::ptr_eq()(r1, n1));
+    lean_assert(name::ptr_eq()(r2, f2));
+}
+
+static void tst15() {
+#if defined(LEAN_MULTI_THREAD)
+    // names created and deleted concurrently by different threads
+    constexpr unsigned num_threads = 8;
+    constexpr unsigned num_names   = 10000;
+    std::vector<thread> threads;
+    for (unsigned i = 0; i < num_threads; i++) {
+        threads.push_back(thread([=]() {
+                    for (unsigned j = 0; j < num_names; j++) {
+                        name n1(name{"foo", "bla"}, j % 100);
+                        name n2(name(name("foo"), "bla"), j % 100);
+                        lean_assert(name::ptr_eq()(n1, n2));
+                    }
+                }));
+    }
+    for (thread & t : threads)
+        t.join();
+#endif
+}
+
+static void tst16() {
+    constexpr unsigned num_names = 10000;
+    std::vector<name> ns;
+    name_map<unsigned> m;
+    for (unsigned i = 0; i < num_names; i++) {
+        ns.push_back(name(name{"foo", "bla", "very_long_component_name"}, i));
+        m.insert(ns.back(), i);
+    }
+    {
+        timeit timer(std::cout, "name_map lookups");
+        for (unsigned k = 0; k < 10; k++) {
+            for (unsigned i = 0; i < num_names; i++) {
+                name n(name{"foo", "bla", "very_long_component_name"}, i);
+                lean_assert(*m.find(n) == i);
+            }
+        }
+    }
+    std::ostringstream out;
+    serializer s(out);
+    for (name const & n : ns)
+        s << n;
+    {
+        timeit timer(std::cout, "name deserialization");
+        std::istringstream in(out.str());
+        deserializer d(in);
+        for (unsigned i = 0; i < num_names; i++) {
+            name n;
+            d >> n;
+            lean_assert(n == ns[i]);
+        }
+    }
+}
+
+static void tst17() {
+    name_generator g("tmp");
+    name a = g.next();
+    name b = a.expand();
+#if defined(LEAN_COMPACT_NAMES)
+    lean_assert(!name::ptr_eq()(a, b));
+#endif
+    lean_assert(a == b && b == a);
+    lean_assert(a.hash() == b.hash());
+    lean_assert(cmp(a, b) == 0);
+    lean_assert(quick_cmp(a, b) == 0);
+    lean_assert(a.to_string() == "tmp.0");
+    lean_assert(a.size() == b.size());
+    lean_assert(a.is_numeral() && a.get_numeral() == 0);
+    lean_assert(a.get_prefix() == name("tmp"));
+    lean_assert(is_prefix_of(name("tmp"), a));
+    lean_assert(is_prefix_of(a, b) && is_prefix_of(b, a));
+    lean_assert(cmp(g.next(), a) > 0);
+    name_generator c = g.mk_child();
+    name c0 = c.next();
+    lean_assert(c0 == name(name(name("tmp"), 2u), 0u));
+    lean_assert(is_prefix_of(name("tmp"), c0));
+    lean_assert(!is_prefix_of(a, c0));
+    lean_assert(name(a, "x") == name(b, "x"));
+    lean_assert(name(a, 1) == name(b, 1));
+    std::ostringstream out;
+    out << c0;
+    lean_assert(out.str() == "tmp.2.0");
+    name_set s;
+    s.insert(a);
+    lean_assert(s.contains(b));
+    // the prefix of the generator is updated when the numerals become too big
+    name_generator g2("tmp2");
+    for (unsigned i = 0; i < lean_max_compact_numeral; i++)
+        g2.next();
+    lean_assert(g2.next() == name(name(name("tmp2"), lean_max_compact_numeral), 0u));
+}
+
+static void tst19() {
+    name big_k(name("tmp"), lean_max_compact_numeral + 1);
+    name f1 = name::mk_fresh(name("tmp"), lean_max_compact_numeral + 1);
+    lean_assert(f1 == big_k && big_k == f1);
+    lean_assert(!name::ptr_eq()(f1, big_k));
+    lean_assert(f1.hash() == big_k.hash());
+    lean_assert(cmp(f1, big_k) == 0);
+    lean_assert(is_prefix_of(f1, big_k) && is_prefix_of(big_k, f1));
+    lean_assert(name(f1, "x") == name(big_k, "x"));
+    name_set s;
+    s.insert(big_k);
+    lean_assert(s.contains(f1));
+    lean_assert(name::mk_fresh(name("tmp"), 3) == name(name("tmp"), 3u));
+    lean_assert(name::mk_fresh(name{"tmp", "a"}.append_after(1), 0) == name(name{"tmp", "a_1"}, 0u));
+}
+
+static void tst18() {
+    name_generator g("tmp");
+    timeit timer(std::cout, "name_generator next");
+    for (unsigned i = 0; i < 1000000; i++) {
+        name n = g.next();
+        lean_assert(n.is_numeral());
+    }
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -188,6 +339,12 @@ int main() {
     tst11();
     tst12();
     tst13();
+    tst14();
+    tst15();
+    tst16();
+    tst17();
+    tst18();
+    tst19();
     finalize_util_module();
     return has_violations() ? 1 : 0;
 }
@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#include <iostream>
+#include <vector>
+#include <random>
+#include "util/test.h"
+#include "util/pvector.h"
+#include "util/list.h"
+#include "util/timeit.h"
+using namespace lean;
+
+static bool check(pvector<int> const & v1, std::vector<int> const & v2) {
+    if (v1.size() != v2.size())
+        return false;
+    for (unsigned i = 0; i < v2.size(); i++) {
+        if (v1[i] != v2[i])
+            return false;
+    }
+    unsigned i = 0;
+    bool ok = true;
+    v1.for_each([&](int v) { if (v != v2[i]) ok = false; i++; });
+    return ok;
+}
+
+static void tst1() {
+    pvector<int> v;
+    std::vector<int> r;
+    lean_assert(v.empty());
+    for (int i = 0; i < 5000; i++) {
+        v.push_back(i);
+        r.push_back(i);
+        lean_assert(v.back() == i);
+    }
+    lean_assert(check(v, r));
+    for (int i = 0; i < 3000; i++) {
+        v.pop_back();
+        r.pop_back();
+    }
+    lean_assert(check(v, r));
+    for (unsigned i = 0; i < r.size(); i += 7) {
+        v.set(i, -static_cast<int>(i));
+        r[i] = -static_cast<int>(i);
+    }
+    lean_assert(check(v, r));
+    while (!v.empty())
+        v.pop_back();
+    v.push_back(10);
+    lean_assert(v.size() == 1 && v[0] == 10);
+}
+
+static void tst2() {
+    // copies are O(1) snapshots, and updates do not affect them
+    pvector<int> v;
+    std::vector<int> r;
+    std::vector<pvector<int>> snapshots;
+    std::vector<std::vector<int>> expected;
+    std::mt19937 rng(10);
+    std::uniform_int_distribution<int> op(0, 9);
+    for (unsigned step = 0; step < 20000; step++) {
+        int k = op(rng);
+        if (k < 6 || r.empty()) {
+            v.push_back(step);
+            r.push_back(step);
+        } else if (k < 8) {
+            v.pop_back();
+            r.pop_back();
+        } else {
+            unsigned i = rng() % r.size();
+            v.set(i, -1);
+            r[i] = -1;
+        }
+        if (step % 1000 == 0) {
+            snapshots.push_back(v);
+            expected.push_back(r);
+            lean_assert(is_eqp(snapshots.back(), v));
+        }
+    }
+    lean_assert(check(v, r));
+    for (unsigned i = 0; i < snapshots.size(); i++) {
+        lean_assert(check(snapshots[i], expected[i]));
+    }
+    std::cout << "size: " << v.size() << ", snapshots: " << snapshots.size() << "\n";
+}
+
+static void tst3(unsigned sz, unsigned num) {
+    // benchmark: indexed access in persistent vectors and lists
+    pvector<unsigned> v;
+    list<unsigned> l;
+    for (unsigned i = 0; i < sz; i++) {
+        v.push_back(i);
+        l = cons(sz - i - 1, l);
+    }
+    unsigned sum1 = 0, sum2 = 0;
+    {
+        timeit timer(std::cout, "pvector indexed access");
+        for (unsigned j = 0; j < num; j++)
+            for (unsigned i = 0; i < sz; i += 97)
+                sum1 += v[i];
+    }
+    {
+        timeit timer(std::cout, "list indexed access");
+        for (unsigned j = 0; j < num; j++) {
+            for (unsigned i = 0; i < sz; i += 97) {
+                list<unsigned> it = l;
+                for (unsigned k = 0; k < i; k++)
+                    it = tail(it);
+                sum2 += head(it);
+            }
+        }
+    }
+    std::cout << "sums: " << sum1 << " " << sum2 << "\n";
+    lean_assert(sum1 == sum2);
+    {
+        timeit timer(std::cout, "pvector push_back with snapshots");
+        pvector<unsigned> w;
+        std::vector<pvector<unsigned>> snapshots;
+        for (unsigned i = 0; i < sz; i++) {
+            w.push_back(i);
+            if (i % 64 == 0)
+                snapshots.push_back(w);
+        }
+        std::cout << "snapshots: " << snapshots.size() << "\n";
+    }
+}
+
+int main() {
+    tst1();
+    tst2();
+    tst3(20000, 10);
+    return has_violations() ? 1 : 0;
+}
@@ -231,6 +231,31 @@ static void tst8() {
     t1.join();
 }
 
+static void tst9() {
+    std::cout << "starting tst9\n";
+    system_dostring("y = 0");
+    prewarm_thread_script_states(4);
+    thread_script_state_stats before = get_thread_script_state_stats();
+    std::vector<std::unique_ptr<interruptible_thread>> ths;
+    for (unsigned i = 0; i < 4; i++) {
+        ths.emplace_back(new interruptible_thread([]() {
+                    script_state S = get_thread_script_state();
+                    S.dostring("assert(y == 0)\n"
+                               "assert(fact(5) == 120)\n");
+                }));
+    }
+    for (auto & th : ths)
+        th->join();
+    thread_script_state_stats after = get_thread_script_state_stats();
+    unsigned num_reused  = after.m_num_reused - before.m_num_reused;
+    unsigned num_created = after.m_num_created - before.m_num_created;
+    std::cout << "reused: " << num_reused << ", created: " << num_created << "\n";
+    lean_assert(num_reused == 4);
+    lean_assert(num_created == 0);
+    lean_assert(after.m_uses.size() == before.m_uses.size() + 4);
+    display_thread_script_state_stats(std::cout);
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -242,6 +267,7 @@ int main() {
     tst6();
     tst7();
     tst8();
+    tst9();
     run_thread_finalizers();
     finalize_util_module();
     run_post_thread_finalizers();
@@ -15,6 +15,7 @@ Author: Leonardo de Moura
 #include "util/lean_path.h"
 #include "util/thread.h"
 #include "util/memory_pool.h"
+#include "util/thread_pool.h"
 
 namespace lean {
 void initialize_util_module() {
@@ -28,8 +29,10 @@ void initialize_util_module() {
     initialize_name();
     initialize_name_generator();
     initialize_lean_path();
+    initialize_thread_pool();
 }
 void finalize_util_module() {
+    finalize_thread_pool();
     finalize_lean_path();
     finalize_name_generator();
     finalize_name();
@@ -6,7 +6,9 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <utility>
+#include <vector>
 #include "util/interrupt.h"
+#include "util/thread_pool.h"
 #include "util/lazy_list.h"
 #include "util/list.h"
 
@@ -250,12 +252,12 @@ lazy_list<T> repeat_at_most(T const & v, F && f, unsigned k, char const * cname
    \brief Return a lazy list such that only the elements that can be computed in
    less than \c ms milliseconds are kept. That is, it uses a timeout for the \c pull
    method in the class lazy_list. If the \c pull method timeouts, the lazy list
-   is truncated.
+   is truncated. In particular, the empty lazy list is returned when \c ms is 0.
 
-   \remark the \c method is executed in a separate execution thread.
+   \remark the \c method is executed by a thread of the shared thread pool.
 
-   \remark \c check_ms is how often the main thread checks whether the child
-   thread finished.
+   \remark \c check_ms is how often the main thread checks its interrupt flag.
+   The main thread does not wait more than necessary when the pool thread finishes.
 */
 #if !defined(LEAN_MULTI_THREAD)
 template<typename T>
@@ -265,47 +267,32 @@ lazy_list<T> timeout(lazy_list<T> const & l, unsigned, unsigned) {
 #else
 template<typename T>
 lazy_list<T> timeout(lazy_list<T> const & l, unsigned ms, unsigned check_ms = g_small_sleep) {
-    if (check_ms == 0)
-        check_ms = 1;
     return mk_lazy_list<T>([=]() {
             typename lazy_list<T>::maybe_pair r;
-            atomic<bool> done(false);
-            interruptible_thread th([&]() {
-                    try {
-                        r = l.pull();
-                    } catch (...) {
-                        r = typename lazy_list<T>::maybe_pair();
-                    }
-                    done = true;
-                });
-            try {
-                auto start = chrono::steady_clock::now();
-                chrono::milliseconds d(ms);
-                chrono::milliseconds small(check_ms);
-                while (!done) {
-                    auto curr = chrono::steady_clock::now();
-                    if (chrono::duration_cast<chrono::milliseconds>(curr - start) > d)
-                        break;
-                    check_interrupted();
-                    this_thread::sleep_for(small);
-                }
-                th.request_interrupt();
-                th.join();
-                if (r)
-                    return some(mk_pair(r->first, timeout(r->second, ms, check_ms)));
-                else
-                    return r;
-            } catch (...) {
-                th.request_interrupt();
-                th.join();
-                throw;
+            if (ms == 0)
+                return r; // task_group::wait interprets 0 as "no timeout"
+            {
+                task_group g;
+                g.add([&]() {
+                        try {
+                            r = l.pull();
+                        } catch (...) {
+                            r = typename lazy_list<T>::maybe_pair();
+                        }
+                    });
+                g.wait([&]() { return g.done(0); }, ms, check_ms);
+                // the destructor of g interrupts the task if it did not finish yet
             }
+            if (r)
+                return some(mk_pair(r->first, timeout(r->second, ms, check_ms)));
+            else
+                return r;
         });
 }
 #endif
 
 /**
-   \brief Similar to interleave, but the heads are computed in parallel.
+   \brief Similar to interleave, but the heads are computed in parallel (by the shared thread pool).
    Moreover, when pulling results from the lists, if one finishes before the other,
    then the other one is interrupted.
 */
@@ -320,51 +307,88 @@ lazy_list<T> par(lazy_list<T> const & l1, lazy_list<T> const & l2, unsigned chec
     return mk_lazy_list<T>([=]() {
             typename lazy_list<T>::maybe_pair r1;
             typename lazy_list<T>::maybe_pair r2;
-            atomic<bool>  done1(false);
-            atomic<bool>  done2(false);
-            interruptible_thread th1([&]() {
-                    try {
-                        r1 = l1.pull();
-                    } catch (...) {
-                        r1 = typename lazy_list<T>::maybe_pair();
-                    }
-                    done1 = true;
-                });
-            interruptible_thread th2([&]() {
-                    try {
-                        r2 = l2.pull();
-                    } catch (...) {
-                        r2 = typename lazy_list<T>::maybe_pair();
-                    }
-                    done2 = true;
-                });
-            try {
-                chrono::milliseconds small(check_ms);
-                while (!done1 && !done2) {
-                    check_interrupted();
-                    this_thread::sleep_for(small);
-                }
-                th1.request_interrupt();
-                th2.request_interrupt();
-                th1.join();
-                th2.join();
-                if (r1 && r2) {
-                    lazy_list<T> tail(r2->first, par(r1->second, r2->second));
-                    return some(mk_pair(r1->first, tail));
-                } else if (r1) {
-                    return some(mk_pair(r1->first, par(r1->second, l2)));
-                } else if (r2) {
-                    return some(mk_pair(r2->first, par(l1, r2->second)));
-                } else {
-                    return r2;
+            {
+                task_group g;
+                g.add([&]() {
+                        try {
+                            r1 = l1.pull();
+                        } catch (...) {
+                            r1 = typename lazy_list<T>::maybe_pair();
+                        }
+                    });
+                g.add([&]() {
+                        try {
+                            r2 = l2.pull();
+                        } catch (...) {
+                            r2 = typename lazy_list<T>::maybe_pair();
+                        }
+                    });
+                g.wait([&]() { return g.done(0) || g.done(1); }, 0, check_ms);
+            }
+            if (r1 && r2) {
+                lazy_list<T> tail(r2->first, par(r1->second, r2->second, check_ms));
+                return some(mk_pair(r1->first, tail));
+            } else if (r1) {
+                return some(mk_pair(r1->first, par(r1->second, l2, check_ms)));
+            } else if (r2) {
+                return some(mk_pair(r2->first, par(l1, r2->second, check_ms)));
+            } else {
+                return r2;
+            }
+        });
+}
+#endif
+
+/**
+   \brief Return the elements of the first list in \c ls that is not empty. The heads of the lists are
+   computed in parallel (by the shared thread pool), the first list that produces an element is used,
+   and the computations of the other heads are interrupted.
+   If a list finishes without producing an element, the other lists keep running.
+*/
+#if !defined(LEAN_MULTI_THREAD)
+template<typename T>
+lazy_list<T> first_success_par(std::vector<lazy_list<T>> const & ls, unsigned = g_small_sleep) {
+    return mk_lazy_list<T>([=]() {
+            for (lazy_list<T> const & l : ls) {
+                if (auto r = l.pull())
+                    return r;
+            }
+            return typename lazy_list<T>::maybe_pair();
+        });
+}
+#else
+template<typename T>
+lazy_list<T> first_success_par(std::vector<lazy_list<T>> const & ls, unsigned check_ms = g_small_sleep) {
+    return mk_lazy_list<T>([=]() {
+            std::vector<typename lazy_list<T>::maybe_pair> rs(ls.size());
+            {
+                task_group g;
+                for (unsigned i = 0; i < ls.size(); i++) {
+                    g.add([&, i]() {
+                            try {
+                                rs[i] = ls[i].pull();
+                            } catch (...) {
+                                rs[i] = typename lazy_list<T>::maybe_pair();
+                            }
+                        });
                 }
-            } catch (...) {
-                th1.request_interrupt();
-                th2.request_interrupt();
-                th1.join();
-                th2.join();
-                throw;
+                g.wait([&]() {
+                        bool all_done = true;
+                        for (unsigned i = 0; i < ls.size(); i++) {
+                            if (!g.done(i))
+                                all_done = false;
+                            else if (rs[i])
+                                return true;
+                        }
+                        return all_done;
+                    }, 0, check_ms);
+            }
+            // If more than one list produced an element, we use the first one.
+            for (auto const & r : rs) {
+                if (r)
+                    return r;
             }
+            return typename lazy_list<T>::maybe_pair();
         });
 }
 #endif
@@ -137,6 +137,53 @@ void dostring(lua_State * L, char const * str) {
     exec(L);
 }
 
+static int string_writer(lua_State *, void const * p, size_t sz, void * ud) {
+    static_cast<std::string*>(ud)->append(static_cast<char const *>(p), sz);
+    return 0;
+}
+
+/** \brief Auxiliary Lua state used to compile code fragments. It does not contain any Lean module. */
+class compiler_state {
+    lua_State * m_state;
+public:
+    compiler_state():m_state(luaL_newstate()) {
+        if (m_state == nullptr)
+            throw exception("fail to create Lua interpreter");
+    }
+    ~compiler_state() { lua_close(m_state); }
+    lua_State * get() const { return m_state; }
+
+    /** \brief Return the bytecode for the function on the top of the stack. */
+    std::string dump() {
+        std::string r;
+        #if LUA_VERSION_NUM < 503
+        lua_dump(m_state, string_writer, &r);
+        #else
+        lua_dump(m_state, string_writer, &r, 0);
+        #endif
+        return r;
+    }
+};
+
+std::string compile_string(char const * str) {
+    compiler_state S;
+    check_result(S.get(), luaL_loadstring(S.get(), str));
+    return S.dump();
+}
+
+std::string compile_file(char const * fname) {
+    compiler_state S;
+    check_result(S.get(), luaL_loadfile(S.get(), fname));
+    return S.dump();
+}
+
+void dochunk(lua_State * L, std::string const & chunk) {
+    // The chunk name is ignored for precompiled chunks, the bytecode contains the original one.
+    int result = luaL_loadbuffer(L, chunk.data(), chunk.size(), "=chunk");
+    check_result(L, result);
+    exec(L);
+}
+
 void pcall(lua_State * L, int nargs, int nresults, int errorfun) {
     int result = lua_pcall(L, nargs, nresults, errorfun);
     check_result(L, result);
@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <string>
 #include <lua.hpp>
 
 namespace lean {
@@ -19,6 +20,12 @@ int load(lua_State * L, lua_Reader reader, void * data, char const * source);
 size_t objlen(lua_State * L, int idx);
 void dofile(lua_State * L, char const * fname);
 void dostring(lua_State * L, char const * str);
+/** \brief Compile the given string, and return the corresponding Lua bytecode. */
+std::string compile_string(char const * str);
+/** \brief Compile the given file, and return the corresponding Lua bytecode. */
+std::string compile_file(char const * fname);
+/** \brief Execute a chunk of Lua bytecode produced by #compile_string or #compile_file. */
+void dochunk(lua_State * L, std::string const & chunk);
 void pcall(lua_State * L, int nargs, int nresults, int errorfun);
 char const * tostring (lua_State * L, int idx);
 /**
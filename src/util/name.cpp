@@ -9,6 +9,7 @@ Author: Leonardo de Moura
 #include <algorithm>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include "util/thread.h"
 #include "util/name.h"
 #include "util/sstream.h"
@@ -28,6 +29,7 @@ constexpr char const * anonymous_str = "[anonymous]";
 struct name::imp {
     MK_LEAN_RC()
     bool     m_is_string;
+    bool     m_interned; // true if this object is stored in the name table
     unsigned m_hash;
     imp *    m_prefix;
     union {
@@ -37,7 +39,18 @@ struct name::imp {
 
     void dealloc();
 
-    imp(bool s, imp * p):m_rc(1), m_is_string(s), m_hash(0), m_prefix(p) { if (p) p->inc_ref(); }
+    imp(bool s, imp * p):m_rc(1), m_is_string(s), m_interned(false), m_hash(0), m_prefix(p) { if (p) p->inc_ref(); }
+
+    /** \brief Increment the reference counter if it is not zero, and return true if succeeded.
+        An object whose reference counter is zero is being deleted, and must not be resurrected. */
+    bool try_inc_ref() {
+        unsigned rc = m_rc.load();
+        while (rc != 0) {
+            if (m_rc.compare_exchange_weak(rc, rc + 1))
+                return true;
+        }
+        return false;
+    }
 
     static void display_core(std::ostream & out, imp * p, char const * sep) {
         lean_assert(p != nullptr);
@@ -57,24 +70,98 @@ struct name::imp {
         else
             display_core(out, p, sep);
     }
+};
+
+DEF_THREAD_MEMORY_POOL(get_numeric_name_allocator, sizeof(name::imp));
 
-    friend void copy_limbs(imp * p, buffer<name::imp *> & limbs) {
-        limbs.clear();
-        while (p != nullptr) {
-            limbs.push_back(p);
-            p = p->m_prefix;
+/**
+   \brief Table of interned hierarchical names. Each distinct name is represented by a single
+   name::imp object. Thus, two names are equal iff they are pointer equal.
+
+   The table is split into shards, each one protected by its own mutex.
+   The table does not keep its objects alive, an object is removed from it when its reference
+   counter reaches zero.
+*/
+class name_table {
+    struct key {
+        name::imp *  m_prefix;
+        bool         m_is_string;
+        char const * m_str;
+        unsigned     m_k;
+        unsigned     m_hash;
+        key(name::imp * p, char const * s, unsigned h):m_prefix(p), m_is_string(true), m_str(s), m_k(0), m_hash(h) {}
+        key(name::imp * p, unsigned k, unsigned h):m_prefix(p), m_is_string(false), m_str(nullptr), m_k(k), m_hash(h) {}
+        explicit key(name::imp * n):m_prefix(n->m_prefix), m_is_string(n->m_is_string),
+                                    m_str(n->m_is_string ? n->m_str : nullptr), m_k(n->m_is_string ? 0 : n->m_k),
+                                    m_hash(n->m_hash) {}
+    };
+    struct key_hash { unsigned operator()(key const & k) const { return k.m_hash; } };
+    struct key_eq {
+        bool operator()(key const & k1, key const & k2) const {
+            // prefixes are interned
+            return
+                k1.m_prefix == k2.m_prefix && k1.m_is_string == k2.m_is_string &&
+                (k1.m_is_string ? strcmp(k1.m_str, k2.m_str) == 0 : k1.m_k == k2.m_k);
+        }
+    };
+    typedef std::unordered_map<key, name::imp *, key_hash, key_eq> map;
+    static constexpr unsigned num_shards = 64;
+    struct shard {
+        mutex m_mutex;
+        map   m_map;
+    };
+    shard m_shards[num_shards];
+    shard & get_shard(unsigned h) { return m_shards[h % num_shards]; }
+public:
+    /** \brief Return the interned object for the given key (with its reference counter incremented),
+        or create a new one using \c mk */
+    template<typename Key, typename MK>
+    name::imp * find_or_insert(Key const & k, MK && mk) {
+        shard & s = get_shard(k.m_hash);
+        lock_guard<mutex> lock(s.m_mutex);
+        auto it = s.m_map.find(k);
+        if (it != s.m_map.end()) {
+            if (it->second->try_inc_ref())
+                return it->second;
+            // The object is being deleted by another thread.
+            // Remark: the key of the entry points to memory owned by this object.
+            s.m_map.erase(it);
         }
-        std::reverse(limbs.begin(), limbs.end());
+        name::imp * r  = mk();
+        r->m_interned  = true;
+        s.m_map.insert(mk_pair(key(r), r));
+        return r;
+    }
+    template<typename MK>
+    name::imp * find_or_insert(name::imp * p, char const * str, unsigned h, MK && mk) {
+        return find_or_insert(key(p, str, h), mk);
+    }
+    template<typename MK>
+    name::imp * find_or_insert(name::imp * p, unsigned k, unsigned h, MK && mk) {
+        return find_or_insert(key(p, k, h), mk);
+    }
+    /** \brief Remove \c n from the table. \pre n->get_rc() == 0 */
+    void erase(name::imp * n) {
+        lean_assert(n->m_interned);
+        key k(n);
+        shard & s = get_shard(k.m_hash);
+        lock_guard<mutex> lock(s.m_mutex);
+        auto it = s.m_map.find(k);
+        // The entry may have been replaced by a new object, see find_or_insert
+        if (it != s.m_map.end() && it->second == n)
+            s.m_map.erase(it);
     }
 };
 
-DEF_THREAD_MEMORY_POOL(get_numeric_name_allocator, sizeof(name::imp));
+static name_table * g_name_table = nullptr;
 
 void name::imp::dealloc() {
     imp * curr = this;
     while (true) {
         lean_assert(curr->get_rc() == 0);
         imp * p = curr->m_prefix;
+        if (curr->m_interned && g_name_table)
+            g_name_table->erase(curr);
         if (curr->m_is_string)
             delete[] reinterpret_cast<char*>(curr);
         else
@@ -85,10 +172,135 @@ void name::imp::dealloc() {
     }
 }
 
+/** \brief Return true if new names with prefix \c p can be interned. */
+static bool use_name_table(name::imp * p) {
+    // Remark: names created before initialize_name (or after finalize_name) are not interned.
+    return g_name_table && (p == nullptr || p->m_interned);
+}
+
+/*
+   Compact names.
+
+   A numeral name whose prefix is interned (or anonymous), and whose numeral is smaller than 2^16,
+   is not allocated. Instead, the numeral and the pointer to the prefix are stored in the field
+   name::m_ptr, and the least significant bit is set to 1 (name::imp objects are aligned).
+   The compact name owns a reference to its prefix.
+   This is the representation used for the names produced by name_generator.
+
+   Compact names are never used as the prefix of other names, they are expanded into
+   (interned) name::imp objects. So, the same name may be represented by a compact name and by
+   a name::imp object. The compact representation is canonical: the constructors only produce
+   name::imp objects for numeral names that cannot be represented as compact names.
+
+   The compact representation is only used on 64-bit platforms (see LEAN_COMPACT_NAMES at name.h).
+*/
+#if defined(LEAN_COMPACT_NAMES)
+typedef std::uintptr_t word;
+constexpr unsigned compact_numeral_shift = 48;
+static_assert(lean_max_compact_numeral < (1u << (64 - compact_numeral_shift)), "invalid compact numeral bound");
+constexpr word     compact_ptr_mask      = (static_cast<word>(1) << compact_numeral_shift) - 2;
+
+static bool is_compact(name::imp * p) { return (reinterpret_cast<word>(p) & 1) != 0; }
+static name::imp * compact_prefix(name::imp * p) {
+    lean_assert(is_compact(p));
+    return reinterpret_cast<name::imp *>(reinterpret_cast<word>(p) & compact_ptr_mask);
+}
+static unsigned compact_numeral(name::imp * p) {
+    lean_assert(is_compact(p));
+    return static_cast<unsigned>(reinterpret_cast<word>(p) >> compact_numeral_shift);
+}
+/** \brief Return true if a name with the given prefix and numeral can be represented as a compact name. */
+static bool can_be_compact(name::imp * p, unsigned k) {
+    return
+        g_name_table && (p == nullptr || p->m_interned) &&
+        k <= lean_max_compact_numeral &&
+        (reinterpret_cast<word>(p) & ~compact_ptr_mask) == 0;
+}
+static name::imp * mk_compact(name::imp * p, unsigned k) {
+    lean_assert(can_be_compact(p, k));
+    return reinterpret_cast<name::imp *>(reinterpret_cast<word>(p) | (static_cast<word>(k) << compact_numeral_shift) | 1);
+}
+#else
+static bool is_compact(name::imp *) { return false; }
+static name::imp * compact_prefix(name::imp *) { lean_unreachable(); return nullptr; }
+static unsigned compact_numeral(name::imp *) { lean_unreachable(); return 0; }
+static bool can_be_compact(name::imp *, unsigned) { return false; }
+static name::imp * mk_compact(name::imp *, unsigned) { lean_unreachable(); return nullptr; }
+#endif
+
+static unsigned numeral_hash(name::imp * p, unsigned k) {
+    return p ? ::lean::hash(p->m_hash, k) : k;
+}
+static void inc_ref(name::imp * p) {
+    if (is_compact(p)) {
+        if (name::imp * q = compact_prefix(p))
+            q->inc_ref();
+    } else if (p) {
+        p->inc_ref();
+    }
+}
+static void dec_ref(name::imp * p) {
+    if (is_compact(p)) {
+        if (name::imp * q = compact_prefix(p))
+            q->dec_ref();
+    } else if (p) {
+        p->dec_ref();
+    }
+}
+
+static name::imp * mk_numeral_imp(name::imp * p, unsigned k, bool intern = true) {
+    unsigned h = numeral_hash(p, k);
+    auto mk = [&]() {
+        name::imp * r = new (get_numeric_name_allocator().allocate()) name::imp(false, p);
+        r->m_k        = k;
+        r->m_hash     = h;
+        return r;
+    };
+    return intern && use_name_table(p) ? g_name_table->find_or_insert(p, k, h, mk) : mk();
+}
+
+/** \brief Return a name::imp object (with a new reference) representing the same name as \c p.
+    That is, compact names are expanded. */
+static name::imp * to_imp(name::imp * p) {
+    if (is_compact(p)) {
+        return mk_numeral_imp(compact_prefix(p), compact_numeral(p));
+    } else {
+        if (p) p->inc_ref();
+        return p;
+    }
+}
+
+/** \brief Auxiliary object for accessing the name::imp object that represents a name. */
+class imp_ref {
+    name::imp * m_ptr;
+public:
+    explicit imp_ref(name::imp * p):m_ptr(to_imp(p)) {}
+    ~imp_ref() { if (m_ptr) m_ptr->dec_ref(); }
+    name::imp * get() const { return m_ptr; }
+};
+
+/** \brief Return the numeral name <tt>p.k</tt> (with a new reference), if \c intern is false,
+    and it cannot be represented as a compact name, then the result is not interned. */
+static name::imp * mk_numeral(name::imp * p, unsigned k, bool intern) {
+    name::imp * r;
+    if (!is_compact(p) && can_be_compact(p, k)) {
+        r = mk_compact(p, k);
+        inc_ref(r);
+    } else {
+        imp_ref q(p);
+        if (can_be_compact(q.get(), k)) {
+            r = mk_compact(q.get(), k);
+            inc_ref(r);
+        } else {
+            r = mk_numeral_imp(q.get(), k, intern);
+        }
+    }
+    return r;
+}
+
 name::name(imp * p) {
     m_ptr = p;
-    if (m_ptr)
-        m_ptr->inc_ref();
+    inc_ref(m_ptr);
 }
 
 name::name() {
@@ -98,23 +310,21 @@ name::name() {
 name::name(name const & prefix, char const * name) {
     size_t sz  = strlen(name);
     lean_assert(sz < (1u << 31));
-    char * mem = new char[sizeof(imp) + sz + 1];
-    m_ptr      = new (mem) imp(true, prefix.m_ptr);
-    std::memcpy(mem + sizeof(imp), name, sz + 1);
-    m_ptr->m_str       = mem + sizeof(imp);
-    if (m_ptr->m_prefix)
-        m_ptr->m_hash = hash_str(sz, name, m_ptr->m_prefix->m_hash);
-    else
-        m_ptr->m_hash = hash_str(sz, name, 0);
+    imp_ref p(prefix.m_ptr);
+    unsigned h = p.get() ? hash_str(sz, name, p.get()->m_hash) : hash_str(sz, name, 0);
+    auto mk = [&]() {
+        char * mem = new char[sizeof(imp) + sz + 1];
+        imp * r    = new (mem) imp(true, p.get());
+        std::memcpy(mem + sizeof(imp), name, sz + 1);
+        r->m_str   = mem + sizeof(imp);
+        r->m_hash  = h;
+        return r;
+    };
+    m_ptr = use_name_table(p.get()) ? g_name_table->find_or_insert(p.get(), name, h, mk) : mk();
 }
 
 name::name(name const & prefix, unsigned k, bool) {
-    m_ptr      = new (get_numeric_name_allocator().allocate()) imp(false, prefix.m_ptr);
-    m_ptr->m_k = k;
-    if (m_ptr->m_prefix)
-        m_ptr->m_hash = ::lean::hash(m_ptr->m_prefix->m_hash, k);
-    else
-        m_ptr->m_hash = k;
+    m_ptr = mk_numeral(prefix.m_ptr, k, true);
 }
 
 name::name(name const & prefix, unsigned k):name(prefix, k, true) {
@@ -128,8 +338,7 @@ name::name(unsigned k):name(name(), k, true) {
 }
 
 name::name(name const & other):m_ptr(other.m_ptr) {
-    if (m_ptr)
-        m_ptr->inc_ref();
+    inc_ref(m_ptr);
 }
 
 name::name(name && other):m_ptr(other.m_ptr) {
@@ -149,8 +358,7 @@ name::name(std::initializer_list<char const *> const & l):name() {
 }
 
 name::~name() {
-    if (m_ptr)
-        m_ptr->dec_ref();
+    dec_ref(m_ptr);
 }
 
 static name * g_anonymous = nullptr;
@@ -167,20 +375,40 @@ name name::mk_internal_unique_name() {
     return name(id);
 }
 
-name & name::operator=(name const & other) { LEAN_COPY_REF(other); }
+name name::mk_fresh(name const & prefix, unsigned k) {
+    name r;
+    r.m_ptr = mk_numeral(prefix.m_ptr, k, false);
+    return r;
+}
+
+name & name::operator=(name const & other) {
+    inc_ref(other.m_ptr);
+    dec_ref(m_ptr);
+    m_ptr = other.m_ptr;
+    return *this;
+}
 
-name & name::operator=(name && other) { LEAN_MOVE_REF(other); }
+name & name::operator=(name && other) {
+    if (this != &other) {
+        dec_ref(m_ptr);
+        m_ptr = other.m_ptr;
+        other.m_ptr = nullptr;
+    }
+    return *this;
+}
 
 name_kind name::kind() const {
     if (m_ptr == nullptr)
         return name_kind::ANONYMOUS;
+    else if (is_compact(m_ptr))
+        return name_kind::NUMERAL;
     else
         return m_ptr->m_is_string ? name_kind::STRING : name_kind::NUMERAL;
 }
 
 unsigned name::get_numeral() const {
     lean_assert(is_numeral());
-    return m_ptr->m_k;
+    return is_compact(m_ptr) ? compact_numeral(m_ptr) : m_ptr->m_k;
 }
 
 char const * name::get_string() const {
@@ -188,9 +416,12 @@ char const * name::get_string() const {
     return m_ptr->m_str;
 }
 
-bool operator==(name const & a, name const & b) {
-    name::imp * i1 = a.m_ptr;
-    name::imp * i2 = b.m_ptr;
+static bool eq_core(name::imp * i1, name::imp * i2) {
+    lean_assert(!is_compact(i1) && !is_compact(i2));
+    if (i1 == i2)
+        return true;
+    if (i1 && i2 && i1->m_interned && i2->m_interned)
+        return false;
     while (true) {
         if (i1 == i2)
             return true;
@@ -214,12 +445,81 @@ bool operator==(name const & a, name const & b) {
     }
 }
 
+bool operator==(name const & a, name const & b) {
+    name::imp * i1 = a.m_ptr;
+    name::imp * i2 = b.m_ptr;
+    if (i1 == i2)
+        return true;
+    if (is_compact(i1) || is_compact(i2)) {
+        if (i1 == nullptr || i2 == nullptr || a.hash() != b.hash() || !a.is_numeral() || !b.is_numeral() ||
+            a.get_numeral() != b.get_numeral())
+            return false;
+        return eq_core(is_compact(i1) ? compact_prefix(i1) : i1->m_prefix,
+                       is_compact(i2) ? compact_prefix(i2) : i2->m_prefix);
+    }
+    return eq_core(i1, i2);
+}
+
+/** \brief A component of a hierarchical name. */
+struct name_limb {
+    bool         m_is_string;
+    char const * m_str;
+    unsigned     m_k;
+    name_limb(char const * str):m_is_string(true), m_str(str), m_k(0) {}
+    name_limb(unsigned k):m_is_string(false), m_str(nullptr), m_k(k) {}
+};
+
+/** \brief Store the components of the name \c p in \c limbs.
+    Compact names are decoded in place. So, this function does not allocate name::imp objects,
+    nor access the table of interned names. */
+static void copy_limbs(name::imp * p, buffer<name_limb> & limbs) {
+    limbs.clear();
+    if (is_compact(p)) {
+        limbs.push_back(name_limb(compact_numeral(p)));
+        p = compact_prefix(p);
+    }
+    for (; p != nullptr; p = p->m_prefix) {
+        if (p->m_is_string)
+            limbs.push_back(name_limb(p->m_str));
+        else
+            limbs.push_back(name_limb(p->m_k));
+    }
+    std::reverse(limbs.begin(), limbs.end());
+}
+
+static int cmp(name_limb const & l1, name_limb const & l2) {
+    if (l1.m_is_string != l2.m_is_string)
+        return l1.m_is_string ? 1 : -1;
+    if (l1.m_is_string)
+        return strcmp(l1.m_str, l2.m_str);
+    else if (l1.m_k != l2.m_k)
+        return l1.m_k < l2.m_k ? -1 : 1;
+    else
+        return 0;
+}
+
+static unsigned depth(name::imp * p) {
+    unsigned r = 0;
+    for (; p; p = p->m_prefix)
+        r++;
+    return r;
+}
+
 bool is_prefix_of(name const & n1, name const & n2) {
     if (n2.is_atomic())
         return n1 == n2;
-    buffer<name::imp*> limbs1, limbs2;
-    name::imp* i1 = n1.m_ptr;
-    name::imp* i2 = n2.m_ptr;
+    name::imp * i1 = n1.m_ptr;
+    name::imp * i2 = n2.m_ptr;
+    if (i1 && !is_compact(i1) && !is_compact(i2) && i1->m_interned && i2->m_interned) {
+        unsigned d1 = depth(i1);
+        unsigned d2 = depth(i2);
+        if (d1 > d2)
+            return false;
+        for (; d2 > d1; d2--)
+            i2 = i2->m_prefix;
+        return i1 == i2;
+    }
+    buffer<name_limb> limbs1, limbs2;
     copy_limbs(i1, limbs1);
     copy_limbs(i2, limbs2);
     unsigned sz1 = limbs1.size();
@@ -228,59 +528,53 @@ bool is_prefix_of(name const & n1, name const & n2) {
         return false;
     else if (sz1 == sz2 && n1.hash() != n2.hash())
         return false;
-    auto it1 = limbs1.begin();
-    auto it2 = limbs2.begin();
-    for (; it1 != limbs1.end(); ++it1, ++it2) {
-        i1 = *it1;
-        i2 = *it2;
-        if (i1->m_is_string != i2->m_is_string)
-            return false;
-        if (i1->m_is_string) {
-            if (strcmp(i1->m_str, i2->m_str) != 0)
-                return false;
-        } else if (i1->m_k != i2->m_k) {
+    for (unsigned i = 0; i < sz1; i++) {
+        if (cmp(limbs1[i], limbs2[i]) != 0)
             return false;
-        }
     }
     return true;
 }
 
 bool operator==(name const & a, char const * b) {
-    return a.m_ptr->m_is_string && strcmp(a.m_ptr->m_str, b) == 0;
+    return a.is_string() && strcmp(a.m_ptr->m_str, b) == 0;
 }
 
 int cmp(name::imp * i1, name::imp * i2) {
-    buffer<name::imp *> limbs1, limbs2;
+    buffer<name_limb> limbs1, limbs2;
     copy_limbs(i1, limbs1);
     copy_limbs(i2, limbs2);
-    auto it1 = limbs1.begin();
-    auto it2 = limbs2.begin();
-    for (; it1 != limbs1.end() && it2 != limbs2.end(); ++it1, ++it2) {
-        i1 = *it1;
-        i2 = *it2;
-
-        if (i1->m_is_string != i2->m_is_string)
-            return i1->m_is_string ? 1 : -1;
-
-        if (i1->m_is_string) {
-            int c = strcmp(i1->m_str, i2->m_str);
-            if (c != 0)
-                return c;
-        } else if (i1->m_k != i2->m_k) {
-            return i1->m_k < i2->m_k ? -1 : 1;
-        }
+    unsigned sz1 = limbs1.size();
+    unsigned sz2 = limbs2.size();
+    for (unsigned i = 0; i < sz1 && i < sz2; i++) {
+        int c = cmp(limbs1[i], limbs2[i]);
+        if (c != 0)
+            return c;
     }
-    if (it1 == limbs1.end() && it2 == limbs2.end())
+    if (sz1 == sz2)
         return 0;
-    else return it1 == limbs1.end() ? -1 : 1;
+    else
+        return sz1 < sz2 ? -1 : 1;
+}
+
+name name::expand() const {
+    name r;
+    r.m_ptr = to_imp(m_ptr);
+    return r;
 }
 
 bool name::is_atomic() const {
+    if (is_compact(m_ptr))
+        return compact_prefix(m_ptr) == nullptr;
     return m_ptr == nullptr || m_ptr->m_prefix == nullptr;
 }
 
 name name::get_prefix() const {
-    return is_atomic() ? name() : name(m_ptr->m_prefix);
+    if (is_atomic())
+        return name();
+    else if (is_compact(m_ptr))
+        return name(compact_prefix(m_ptr));
+    else
+        return name(m_ptr->m_prefix);
 }
 
 static unsigned num_digits(unsigned k) {
@@ -297,6 +591,8 @@ static unsigned num_digits(unsigned k) {
 size_t name::size() const {
     if (m_ptr == nullptr) {
         return strlen(anonymous_str);
+    } else if (is_compact(m_ptr)) {
+        return is_atomic() ? num_digits(get_numeral()) : get_prefix().size() + strlen(lean_name_separator) + num_digits(get_numeral());
     } else {
         imp * i       = m_ptr;
         size_t sep_sz = strlen(lean_name_separator);
@@ -319,11 +615,13 @@ size_t name::size() const {
 }
 
 unsigned name::hash() const {
+    if (is_compact(m_ptr))
+        return numeral_hash(compact_prefix(m_ptr), compact_numeral(m_ptr));
     return m_ptr ? m_ptr->m_hash : 11;
 }
 
 bool name::is_safe_ascii() const {
-    imp * i       = m_ptr;
+    imp * i       = is_compact(m_ptr) ? compact_prefix(m_ptr) : m_ptr;
     while (i) {
         if (i->m_is_string) {
             if (!::lean::is_safe_ascii(i->m_str))
@@ -336,12 +634,24 @@ bool name::is_safe_ascii() const {
 
 std::string name::to_string(char const * sep) const {
     std::ostringstream s;
-    imp::display(s, m_ptr, sep);
+    if (is_compact(m_ptr)) {
+        if (!is_atomic())
+            s << get_prefix().to_string(sep) << sep;
+        s << get_numeral();
+    } else {
+        imp::display(s, m_ptr, sep);
+    }
     return s.str();
 }
 
 std::ostream & operator<<(std::ostream & out, name const & n) {
-    name::imp::display(out, n.m_ptr);
+    if (is_compact(n.m_ptr)) {
+        if (!n.is_atomic())
+            out << n.get_prefix() << lean_name_separator;
+        out << n.get_numeral();
+    } else {
+        name::imp::display(out, n.m_ptr);
+    }
     return out;
 }
 
@@ -353,13 +663,13 @@ name operator+(name const & n1, name const & n2) {
     } else {
         name prefix;
         if (!n2.is_atomic())
-            prefix = n1 + name(n2.m_ptr->m_prefix);
+            prefix = n1 + n2.get_prefix();
         else
             prefix = n1;
-        if (n2.m_ptr->m_is_string)
-            return name(prefix, n2.m_ptr->m_str);
+        if (n2.is_string())
+            return name(prefix, n2.get_string());
         else
-            return name(prefix, n2.m_ptr->m_k);
+            return name(prefix, n2.get_numeral());
     }
 }
 
@@ -628,6 +938,7 @@ void open_name(lua_State * L) {
 }
 
 void initialize_name() {
+    g_name_table = new name_table();
     g_anonymous = new name();
     g_name_sd   = new name_sd();
     g_next_id   = new atomic<unsigned>(0);
@@ -637,6 +948,8 @@ void finalize_name() {
     delete g_next_id;
     delete g_name_sd;
     delete g_anonymous;
+    delete g_name_table;
+    g_name_table = nullptr;
 }
 }
 void print(lean::name const & n) { std::cout << n << std::endl; }
@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <cstdint>
 #include <string>
 #include <iostream>
 #include <functional>
@@ -16,11 +17,25 @@ Author: Leonardo de Moura
 #include "util/optional.h"
 #include "util/list.h"
 
+// Compact numeral names store a pointer and a 16-bit numeral in a single word (see name.cpp).
+// So, they are only available on 64-bit platforms.
+#if !defined(LEAN_EMSCRIPTEN) && !defined(LEAN_NO_COMPACT_NAMES) && defined(UINTPTR_MAX) && UINTPTR_MAX == 0xffffffffffffffffull
+#define LEAN_COMPACT_NAMES
+#endif
+
 namespace lean {
 constexpr char const * lean_name_separator = ".";
+/** \brief When LEAN_COMPACT_NAMES is defined, numeral names <tt>p.k</tt> where <tt>k <= lean_max_compact_numeral</tt>
+    do not require memory allocation (when \c p is not a temporary name). */
+constexpr unsigned lean_max_compact_numeral = (1u << 16) - 1;
 enum class name_kind { ANONYMOUS, STRING, NUMERAL };
 /**
    \brief Hierarchical names.
+
+   Names are interned: after initialize_name, each distinct hierarchical name is represented
+   by a single object. Thus, equality is a pointer comparison.
+   Moreover, on 64-bit platforms, numeral names with small numerals (e.g., the ones created by
+   name_generator) are encoded in the name object itself, and do not require memory allocation.
 */
 class name {
 public:
@@ -63,6 +78,12 @@ public:
         </code>
     */
     static name mk_internal_unique_name();
+    /**
+       \brief Return the numeral name <tt>prefix.k</tt>. The result is not stored in the table of
+       interned names. So, it should only be used to create names that are known to be fresh
+       (e.g., the ones produced by name_generator), since interning them is a waste of time.
+    */
+    static name mk_fresh(name const & prefix, unsigned k);
     name & operator=(name const & other);
     name & operator=(name && other);
     /** \brief Return true iff \c n1 is a prefix of \c n2. */
@@ -96,6 +117,11 @@ public:
         \pre !is_atomic()
     */
     name get_prefix() const;
+    /**
+        \brief Return a name equal to this one that does not use the compact representation for numeral names.
+        It should be used for names that will be the prefix of many other names (e.g., the prefix of a name_generator).
+    */
+    name expand() const;
     /** \brief Convert this hierarchical name into a string. */
     std::string to_string(char const * sep = lean_name_separator) const;
     /** \brief Size of the this name (in characters). */
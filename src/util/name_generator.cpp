@@ -4,7 +4,6 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
-#include <limits>
 #include <algorithm>
 #include "util/name_generator.h"
 
@@ -13,12 +12,13 @@ static name * g_tmp_prefix = nullptr;
 name_generator::name_generator():name_generator(*g_tmp_prefix) {}
 
 name name_generator::next() {
-    if (m_next_idx == std::numeric_limits<unsigned>::max()) {
-        // avoid overflow
-        m_prefix   = name(m_prefix, m_next_idx);
+    if (m_next_idx == lean_max_compact_numeral) {
+        // avoid overflow, and keep the generated names compact
+        m_prefix   = name(m_prefix, m_next_idx).expand();
         m_next_idx = 0;
     }
-    name r(m_prefix, m_next_idx);
+    // the generated names are unique, there is no need to intern them
+    name r = name::mk_fresh(m_prefix, m_next_idx);
     m_next_idx++;
     return r;
 }
@@ -13,14 +13,17 @@ namespace lean {
    \brief A generator of unique names modulo a prefix.
    If the initial prefix is independent of all other names in the system, then all generated names are unique.
 
-   \remark There is no risk of overflow in the m_next_idx. If m_next_idx reaches std::numeric_limits<unsigned>::max(),
-   then the prefix becomes name(m_prefix, m_next_idx), and m_next_idx is reset to 0
+   \remark There is no risk of overflow in the m_next_idx. If m_next_idx reaches lean_max_compact_numeral,
+   then the prefix becomes name(m_prefix, m_next_idx), and m_next_idx is reset to 0.
+   Thus, the generated names use the compact representation for numeral names (see name.h), and
+   they do not require memory allocation. Names that cannot use the compact representation are
+   not interned (see name::mk_fresh).
 */
 class name_generator {
     name     m_prefix;
     unsigned m_next_idx;
 public:
-    name_generator(name const & prefix):m_prefix(prefix), m_next_idx(0) { lean_assert(!prefix.is_anonymous()); }
+    name_generator(name const & prefix):m_prefix(prefix.expand()), m_next_idx(0) { lean_assert(!prefix.is_anonymous()); }
     name_generator();
 
     name const & prefix() const { return m_prefix; }
@@ -0,0 +1,256 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#pragma once
+#include <vector>
+#include <utility>
+#include "util/rc.h"
+#include "util/debug.h"
+
+namespace lean {
+/**
+   \brief Persistent vector.
+
+   It is implemented as a tree of nodes with up to 32 entries (leaves store values),
+   and an extra leaf (the tail) for the last elements.
+   It uses a O(1) copy operation. Different vectors can share nodes, and the sharing is thread-safe.
+   Access, update, push_back and pop_back are O(log_32 n), and push_back/pop_back
+   are usually performed in the tail only.
+
+   Nodes that are not shared are updated in place.
+*/
+template<typename T>
+class pvector {
+    struct cell;
+    struct node {
+        cell * m_ptr;
+        node():m_ptr(nullptr) {}
+        explicit node(cell * ptr):m_ptr(ptr) { if (m_ptr) ptr->inc_ref(); }
+        node(node const & s):m_ptr(s.m_ptr) { if (m_ptr) m_ptr->inc_ref(); }
+        node(node && s):m_ptr(s.m_ptr) { s.m_ptr = nullptr; }
+        ~node() { if (m_ptr) m_ptr->dec_ref(); }
+        node & operator=(node const & n) { LEAN_COPY_REF(n); }
+        node & operator=(node&& n) { LEAN_MOVE_REF(n); }
+        operator bool() const { return m_ptr != nullptr; }
+        bool is_shared() const { return m_ptr && m_ptr->get_rc() > 1; }
+        cell * operator->() const { lean_assert(m_ptr); return m_ptr; }
+        friend bool is_eqp(node const & n1, node const & n2) { return n1.m_ptr == n2.m_ptr; }
+        friend void swap(node & n1, node & n2) { std::swap(n1.m_ptr, n2.m_ptr); }
+        node steal() { node r; swap(r, *this); return r; }
+    };
+
+    struct cell {
+        std::vector<T>    m_values;   // only used in leaves
+        std::vector<node> m_children; // only used in internal nodes
+        MK_LEAN_RC();
+        void dealloc() { delete this; }
+        cell():m_rc(0) {}
+        cell(cell const & s):m_values(s.m_values), m_children(s.m_children), m_rc(0) {}
+    };
+
+    static unsigned const bits  = 5;
+    static unsigned const width = 1u << bits;
+    static unsigned const mask  = width - 1;
+
+    node     m_root;  // tree containing full leaves
+    node     m_tail;  // last (non empty) leaf
+    unsigned m_size;
+    unsigned m_shift; // bits * (height of m_root - 1)
+
+    static node mk_leaf() {
+        node r(new cell());
+        r->m_values.reserve(width);
+        return r;
+    }
+
+    static node ensure_unshared(node && n) {
+        if (n.is_shared())
+            return node(new cell(*n.m_ptr));
+        else
+            return n;
+    }
+
+    unsigned tail_size() const { return m_tail ? m_tail->m_values.size() : 0; }
+    unsigned tail_offset() const { return m_size - tail_size(); }
+
+    static node mk_path(unsigned shift, node const & leaf) {
+        if (shift == 0)
+            return leaf;
+        node r(new cell());
+        r->m_children.push_back(mk_path(shift - bits, leaf));
+        return r;
+    }
+
+    /** \brief Add \c leaf to the internal node \c n at level \c shift, \c off is the position of the first element of \c leaf. */
+    static node push_leaf(node && n, unsigned shift, unsigned off, node const & leaf) {
+        node r = ensure_unshared(std::move(n));
+        unsigned idx = (off >> shift) & mask;
+        if (idx < r->m_children.size())
+            r->m_children[idx] = push_leaf(r->m_children[idx].steal(), shift - bits, off, leaf);
+        else
+            r->m_children.push_back(mk_path(shift - bits, leaf));
+        return r;
+    }
+
+    void push_tail() {
+        unsigned off = tail_offset();
+        node leaf    = m_tail.steal();
+        if (!m_root) {
+            m_root  = leaf;
+            m_shift = 0;
+        } else if ((off >> bits) == (1u << m_shift)) {
+            // root is full
+            node new_root(new cell());
+            new_root->m_children.push_back(m_root);
+            new_root->m_children.push_back(mk_path(m_shift, leaf));
+            m_root   = new_root;
+            m_shift += bits;
+        } else {
+            m_root = push_leaf(m_root.steal(), m_shift, off, leaf);
+        }
+    }
+
+    /** \brief Remove the last leaf of the internal node \c n, and store it in \c leaf. */
+    static node pop_leaf(node && n, unsigned shift, node & leaf) {
+        node r = ensure_unshared(std::move(n));
+        if (shift == bits) {
+            leaf = r->m_children.back();
+            r->m_children.pop_back();
+        } else {
+            node c = pop_leaf(r->m_children.back().steal(), shift - bits, leaf);
+            if (c->m_children.empty())
+                r->m_children.pop_back();
+            else
+                r->m_children.back() = c;
+        }
+        return r;
+    }
+
+    node pop_tail() {
+        if (m_shift == 0)
+            return m_root.steal();
+        node leaf;
+        m_root = pop_leaf(m_root.steal(), m_shift, leaf);
+        if (m_root->m_children.size() == 1) {
+            node c  = m_root->m_children[0];
+            m_root  = c;
+            m_shift -= bits;
+        }
+        return leaf;
+    }
+
+    static node update(node && n, unsigned shift, unsigned i, T const & v) {
+        node r = ensure_unshared(std::move(n));
+        if (shift == 0) {
+            r->m_values[i & mask] = v;
+        } else {
+            unsigned idx = (i >> shift) & mask;
+            r->m_children[idx] = update(r->m_children[idx].steal(), shift - bits, i, v);
+        }
+        return r;
+    }
+
+    template<typename F>
+    static void for_each(cell const * c, unsigned shift, F && f) {
+        if (shift == 0) {
+            for (T const & v : c->m_values)
+                f(v);
+        } else {
+            for (node const & n : c->m_children)
+                for_each(n.m_ptr, shift - bits, f);
+        }
+    }
+
+public:
+    pvector():m_size(0), m_shift(0) {}
+    pvector(pvector const & s):m_root(s.m_root), m_tail(s.m_tail), m_size(s.m_size), m_shift(s.m_shift) {}
+    pvector(pvector && s):m_root(std::move(s.m_root)), m_tail(std::move(s.m_tail)), m_size(s.m_size), m_shift(s.m_shift) {}
+
+    pvector & operator=(pvector const & s) {
+        m_root = s.m_root; m_tail = s.m_tail; m_size = s.m_size; m_shift = s.m_shift;
+        return *this;
+    }
+    pvector & operator=(pvector && s) {
+        m_root = std::move(s.m_root); m_tail = std::move(s.m_tail); m_size = s.m_size; m_shift = s.m_shift;
+        return *this;
+    }
+
+    unsigned size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T const & operator[](unsigned i) const {
+        lean_assert(i < m_size);
+        unsigned off = tail_offset();
+        if (i >= off)
+            return m_tail->m_values[i - off];
+        cell const * c = m_root.m_ptr;
+        for (unsigned shift = m_shift; shift > 0; shift -= bits)
+            c = c->m_children[(i >> shift) & mask].m_ptr;
+        return c->m_values[i & mask];
+    }
+
+    T const & back() const {
+        lean_assert(!empty());
+        return m_tail->m_values.back();
+    }
+
+    void push_back(T const & v) {
+        if (tail_size() == width)
+            push_tail();
+        if (!m_tail)
+            m_tail = mk_leaf();
+        else
+            m_tail = ensure_unshared(m_tail.steal());
+        m_tail->m_values.push_back(v);
+        m_size++;
+    }
+
+    void pop_back() {
+        lean_assert(!empty());
+        if (tail_size() > 1) {
+            m_tail = ensure_unshared(m_tail.steal());
+            m_tail->m_values.pop_back();
+        } else if (m_size > 1) {
+            m_tail = pop_tail();
+        } else {
+            m_tail = node();
+        }
+        m_size--;
+    }
+
+    void set(unsigned i, T const & v) {
+        lean_assert(i < m_size);
+        unsigned off = tail_offset();
+        if (i >= off) {
+            m_tail = ensure_unshared(m_tail.steal());
+            m_tail->m_values[i - off] = v;
+        } else {
+            m_root = update(m_root.steal(), m_shift, i, v);
+        }
+    }
+
+    void clear() {
+        m_root  = node();
+        m_tail  = node();
+        m_size  = 0;
+        m_shift = 0;
+    }
+
+    /** \brief Apply \c f to every element of the vector (from the first to the last one). */
+    template<typename F>
+    void for_each(F && f) const {
+        if (m_root)
+            for_each(m_root.m_ptr, m_shift, f);
+        if (m_tail)
+            for (T const & v : m_tail->m_values)
+                f(v);
+    }
+
+    friend bool is_eqp(pvector const & v1, pvector const & v2) {
+        return is_eqp(v1.m_root, v2.m_root) && is_eqp(v1.m_tail, v2.m_tail);
+    }
+};
+}
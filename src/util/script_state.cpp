@@ -134,6 +134,20 @@ struct script_state::imp {
         return import_explicit(std::string(fname));
     }
 
+    void dochunk(std::string const & chunk) {
+        ::lean::dochunk(m_state, chunk);
+    }
+
+    bool import_explicit(std::string const & fname, std::string const & chunk) {
+        if (m_imported_modules.find(fname) == m_imported_modules.end()) {
+            dochunk(chunk);
+            m_imported_modules.insert(fname);
+            return true;
+        } else {
+            return false;
+        }
+    }
+
     bool import(char const * fname) {
         return import_explicit(find_file(std::string(fname)));
     }
@@ -173,6 +187,14 @@ bool script_state::import_explicit(char const * str) {
     return m_ptr->import_explicit(str);
 }
 
+void script_state::dochunk(std::string const & chunk) {
+    m_ptr->dochunk(chunk);
+}
+
+bool script_state::import_explicit(char const * fname, std::string const & chunk) {
+    return m_ptr->import_explicit(std::string(fname), chunk);
+}
+
 lua_State * script_state::get_state() {
     return m_ptr->m_state;
 }
@@ -6,6 +6,7 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <memory>
+#include <string>
 #include <lua.hpp>
 
 namespace lean {
@@ -50,6 +51,16 @@ public:
        If the file was already included, then nothing happens, and method returns false.
     */
     bool import_explicit(char const * fname);
+    /**
+       \brief Execute a chunk of Lua bytecode produced by #compile_string or #compile_file.
+       This method throws an exception if an error occurs.
+    */
+    void dochunk(std::string const & chunk);
+    /**
+       \brief Similar to #import_explicit, but \c chunk is the precompiled bytecode for
+       the file \c fname (see #compile_file).
+    */
+    bool import_explicit(char const * fname, std::string const & chunk);
 
     lua_State * get_state();
 
@@ -9,7 +9,10 @@
 #include <cstring>
 #include <utility>
 #include <vector>
+#include <limits>
 #include "util/sstream.h"
+#include "util/hash.h"
+#include "util/buffer.h"
 #include "util/escaped.h"
 #include "util/interrupt.h"
 #include "util/numerics/mpz.h"
@@ -66,14 +69,181 @@ bool get_pp_colors(options const & o) {
 unsigned get_pp_width(options const & o) {
     return o.get_unsigned(*g_pp_width, LEAN_DEFAULT_PP_WIDTH);
 }
+static unsigned add_width(unsigned w1, unsigned w2) {
+    unsigned r = w1 + w2;
+    return r < w1 ? std::numeric_limits<unsigned>::max() : r;
+}
+
+struct format_text : public format::cell {
+    std::string m_text;
+    bool        m_is_name;
+    format_text(std::string const & s, bool is_name):
+        format::cell(format::TEXT, hash_str(s.size(), s.c_str(), 17)), m_text(s), m_is_name(is_name) {
+        m_flat_width  = s.size();
+        m_break_width = s.size();
+    }
+};
+
+struct format_nest : public format::cell {
+    int    m_indent;
+    format m_body;
+    format_nest(int i, format const & f, format::cell const * c):
+        format::cell(format::NEST, hash(static_cast<unsigned>(i), c->m_hash)), m_indent(i), m_body(f) {
+        m_flat_differs = c->m_flat_differs;
+        m_has_break    = c->m_has_break;
+        m_flat_width   = c->m_flat_width;
+        m_break_width  = c->m_break_width;
+    }
+};
+
+/** \brief Cell for COMPOSE and CHOICE */
+struct format_binary : public format::cell {
+    format m_first;
+    format m_second;
+    format_binary(format::format_kind k, format const & f1, format::cell const * c1,
+                  format const & f2, format::cell const * c2):
+        format::cell(k, hash(hash(c1->m_hash, c2->m_hash), static_cast<unsigned>(k))), m_first(f1), m_second(f2) {
+        if (k == format::COMPOSE) {
+            m_flat_differs = c1->m_flat_differs || c2->m_flat_differs;
+            m_has_break    = c1->m_has_break || c2->m_has_break;
+            m_flat_width   = add_width(c1->m_flat_width, c2->m_flat_width);
+            m_break_width  = c1->m_has_break ? c1->m_break_width : add_width(c1->m_break_width, c2->m_break_width);
+        } else {
+            lean_assert(k == format::CHOICE);
+            /* flatten (x <|> y) = flatten x, and y is used when computing the space up to a line break */
+            m_flat_differs = true;
+            m_has_break    = c2->m_has_break;
+            m_flat_width   = c1->m_flat_width;
+            m_break_width  = c2->m_break_width;
+        }
+    }
+};
+
+struct format_flat : public format::cell {
+    format m_body;
+    format_flat(format const & f, format::cell const * c):
+        format::cell(format::FLAT, hash(c->m_hash, 7u)), m_body(f) {
+        m_flat_width  = c->m_flat_width;
+        m_break_width = c->m_flat_width;
+    }
+};
+
+struct format_color_begin : public format::cell {
+    format::format_color m_color;
+    format_color_begin(format::format_color c):format::cell(format::COLOR_BEGIN, hash(static_cast<unsigned>(c), 11u)), m_color(c) {}
+};
+
+static format_text const * to_text(format::cell const * c) {
+    lean_assert(c->m_kind == format::TEXT);
+    return static_cast<format_text const *>(c);
+}
+static format_nest const * to_nest(format::cell const * c) {
+    lean_assert(c->m_kind == format::NEST);
+    return static_cast<format_nest const *>(c);
+}
+static format_binary const * to_binary(format::cell const * c) {
+    lean_assert(c->m_kind == format::COMPOSE || c->m_kind == format::CHOICE);
+    return static_cast<format_binary const *>(c);
+}
+static format_flat const * to_flat(format::cell const * c) {
+    lean_assert(c->m_kind == format::FLAT);
+    return static_cast<format_flat const *>(c);
+}
+static format_color_begin const * to_color(format::cell const * c) {
+    lean_assert(c->m_kind == format::COLOR_BEGIN);
+    return static_cast<format_color_begin const *>(c);
+}
+
+static format * g_nil       = nullptr;
+static format * g_color_end = nullptr;
+
+void format::steal(format & f, buffer<cell*> & todo) {
+    cell * c = f.m_ptr;
+    f.m_ptr  = nullptr;
+    if (c && c->dec_ref_core())
+        todo.push_back(c);
+}
+
+void format::cell::dealloc() {
+    // Documents are often deep (e.g., long sequences of +=), so we avoid recursion here.
+    buffer<cell*> todo;
+    todo.push_back(this);
+    while (!todo.empty()) {
+        cell * it = todo.back();
+        todo.pop_back();
+        switch (it->m_kind) {
+        case format_kind::TEXT:
+            delete static_cast<format_text*>(it);
+            break;
+        case format_kind::NEST:
+            steal(static_cast<format_nest*>(it)->m_body, todo);
+            delete static_cast<format_nest*>(it);
+            break;
+        case format_kind::COMPOSE: case format_kind::CHOICE:
+            steal(static_cast<format_binary*>(it)->m_first, todo);
+            steal(static_cast<format_binary*>(it)->m_second, todo);
+            delete static_cast<format_binary*>(it);
+            break;
+        case format_kind::FLAT:
+            steal(static_cast<format_flat*>(it)->m_body, todo);
+            delete static_cast<format_flat*>(it);
+            break;
+        case format_kind::COLOR_BEGIN:
+            delete static_cast<format_color_begin*>(it);
+            break;
+        case format_kind::NIL: case format_kind::LINE: case format_kind::COLOR_END:
+            delete it;
+            break;
+        }
+    }
+}
+
+template<typename T> static std::string to_text_string(T const & v) {
+    std::ostringstream out;
+    out << v;
+    return out.str();
+}
+
+format::format(cell * c):m_ptr(c) { m_ptr->inc_ref(); }
+format::format():format(g_nil ? g_nil->m_ptr : new cell(format_kind::NIL, 3)) {}
+format::format(char const * v):format(mk_text(v)) {}
+format::format(std::string const & v):format(mk_text(v)) {}
+format::format(int v):format(mk_text(to_text_string(v))) {}
+format::format(unsigned v):format(mk_text(to_text_string(v))) {}
+format::format(double v):format(mk_text(to_text_string(v))) {}
+format::format(name const & v):format(mk_text(to_text_string(v), true)) {}
+format::format(mpz const & v):format(mk_text(to_text_string(v))) {}
+format::format(mpq const & v):format(mk_text(to_text_string(v))) {}
+format::format(format const & f1, format const & f2):format(compose(f1, f2)) {}
+format::format(std::initializer_list<format> const & l):format() {
+    lean_assert(l.size() >= 2);
+    for (format const & f : l)
+        *this = compose(*this, f);
+}
+
+format::cell * format::mk_text(std::string const & s, bool is_name) {
+    return new format_text(s, is_name);
+}
+
+bool is_name(format const & f) {
+    return format::is_text(f) && to_text(f.m_ptr)->m_is_name;
+}
+
 format compose(format const & f1, format const & f2) {
-    return format(format::sexpr_compose({f1.m_value, f2.m_value}));
+    if (format::is_fnil(f1))
+        return f2;
+    if (format::is_fnil(f2))
+        return f1;
+    return format(new format_binary(format::COMPOSE, f1, f1.m_ptr, f2, f2.m_ptr));
+}
+format choice(format const & f1, format const & f2) {
+    return format(new format_binary(format::CHOICE, f1, f1.m_ptr, f2, f2.m_ptr));
 }
 format nest(int i, format const & f) {
-    return format(format::sexpr_nest(i, f.m_value));
+    return format(new format_nest(i, f, f.m_ptr));
 }
 format highlight(format const & f, format::format_color const c) {
-    return format(format::sexpr_highlight(f.m_value, c));
+    return compose(format(new format_color_begin(c)), compose(f, *g_color_end));
 }
 format highlight_keyword(format const & f) {
     return highlight(f, LEAN_KEYWORD_HIGHLIGHT_COLOR);
@@ -86,7 +256,11 @@ format highlight_command(format const & f) {
 }
 // Commonly used format objects
 format mk_line() {
-    return format(format::sexpr_line());
+    format::cell * c  = new format::cell(format::LINE, 5);
+    c->m_flat_differs = true;
+    c->m_has_break    = true;
+    c->m_flat_width   = 1;
+    return format(c);
 }
 
 static format * g_line = nullptr;
@@ -111,53 +285,20 @@ format const & rcurly() { return *g_rcurly; }
 format const & comma() { return *g_comma; }
 format const & colon() { return *g_colon; }
 format const & dot() { return *g_dot; }
-// Auxiliary flag used to mark whether flatten
-// produce a different sexpr
-LEAN_THREAD_VALUE(bool, g_diff_flatten, false);
-//
-sexpr format::flatten(sexpr const & s) {
-    check_system("formatter");
-    lean_assert(is_cons(s));
-    switch (sexpr_kind(s)) {
-    case format_kind::NIL:
-        /* flatten NIL = NIL */
-        return s;
-    case format_kind::NEST:
-        /* flatten (NEST i x) = flatten x */
-        return flatten(sexpr_nest_s(s));
-    case format_kind::COMPOSE:
-        /* flatten (s_1 <> ... <> s_n ) = flatten s_1 <> ... <> flatten s_n */
-        return sexpr_flat_compose(map(sexpr_compose_list(s),
-                                      [](sexpr const & s) {
-                                          return flatten(s);
-                                      }));
-    case format_kind::CHOICE:
-        /* flatten (x <|> y) = flatten x */
-        g_diff_flatten = true;
-        return flatten(sexpr_choice_1(s));
-    case format_kind::LINE:
-        g_diff_flatten = true;
-        return sexpr_text(sexpr(" "));
-    case format_kind::FLAT_COMPOSE:
-    case format_kind::TEXT:
-    case format_kind::COLOR_BEGIN:
-    case format_kind::COLOR_END:
-        return s;
-    }
-    lean_unreachable(); // LCOV_EXCL_LINE
-}
+
+/* flatten does not copy the document, it just marks it to be rendered in flat mode. */
 format flatten(format const & f){
-    return format(format::flatten(f.m_value));
+    if (!f.m_ptr->m_flat_differs)
+        return f;
+    return format(new format_flat(f, f.m_ptr));
 }
 format group(format const & f) {
-    g_diff_flatten = false;
-    format flat_f = flatten(f);
-    if (g_diff_flatten) {
-        return choice(flat_f, f);
+    if (f.m_ptr->m_flat_differs) {
+        return choice(flatten(f), f);
     } else {
-        // flat_f and f are essentially the same format object.
+        // flatten(f) and f are essentially the same format object.
         // So, we don't need to create a choice.
-        return flat_f;
+        return f;
     }
 }
 format above(format const & f1, format const & f2) {
@@ -176,109 +317,67 @@ format wrap(format const & f1, format const & f2) {
     return f1 + choice(format(" "), line()) + f2;
 }
 
-/**
-   \brief Auxiliary exception used to sign that the amount of
-   available space was exhausted. It is used in \c space_upto_line_break and
-   \c space_upto_line_break_list_exceeded
-*/
-struct space_exceeded {};
+format operator+(format const & f1, format const & f2) {
+    return compose(f1, f2);
+}
 
-/**
-   \brief Return true iff the space upto line break fits in the available space.
-*/
-bool format::space_upto_line_break_list_exceeded(sexpr const & s, int available, std::vector<pair<sexpr, unsigned>> const & todo) {
-    try {
-        bool found_newline = false;
-        available -= space_upto_line_break(s, available, found_newline);
-        auto it    = todo.end();
-        auto begin = todo.begin();
-        while (it != begin && !found_newline) {
-            --it;
-            if (available < 0)
-                return true;
-            available -= space_upto_line_break(it->first, available, found_newline);
-        }
-        return available < 0;
-    } catch (space_exceeded) {
-        return true;
-    }
+format operator^(format const & f1, format const & f2) {
+    return format {f1, format(" "), f2};
 }
 
 /**
-   \brief Return the space upto line break. If the space exceeds available, then throw an exception.
+   \brief Entry in the layout stack used by \c format::pretty.
+
+   \c m_rest is the width of this entry and all entries below it up to the first line break,
+   and \c m_rest_break is true iff there is such line break. Entries below a given entry
+   are not modified while the entry is in the stack. So, these values are computed
+   when the entry is pushed, and choices are resolved in constant time.
 */
-int format::space_upto_line_break(sexpr const & s, int available, bool & found_newline) {
-    // s : format
-    lean_assert(!found_newline);
-    lean_assert(sexpr_kind(s) <= format_kind::COLOR_END);
-
-    switch (sexpr_kind(s)) {
-    case format_kind::NIL:
-    case format_kind::COLOR_BEGIN:
-    case format_kind::COLOR_END:
-    {
-        return 0;
-    }
-    case format_kind::COMPOSE:
-    case format_kind::FLAT_COMPOSE:
-    {
-        sexpr list  = sexpr_compose_list(s);
-        int len = 0;
-        while (!is_nil(list) && !found_newline) {
-            sexpr const & h = car(list);
-            list = cdr(list);
-            len += space_upto_line_break(h, available, found_newline);
-            if (len > available)
-                throw space_exceeded();
-        }
-        return len;
-    }
-    case format_kind::NEST:
-    {
-        sexpr const & x = sexpr_nest_s(s);
-        return space_upto_line_break(x, available, found_newline);
-    }
-    case format_kind::TEXT: {
-        return sexpr_text_length(s);
-    }
-    case format_kind::LINE:
-        found_newline = true;
-        return 0;
-    case format_kind::CHOICE:
-    {
-        sexpr const & x = sexpr_choice_2(s);
-        return space_upto_line_break(x, available, found_newline);
-    }
-    }
-    lean_unreachable(); // LCOV_EXCL_LINE
-}
+struct layout_entry {
+    format::cell const * m_cell;
+    unsigned             m_indent;
+    bool                 m_flat;
+    bool                 m_rest_break;
+    unsigned             m_rest;
+    layout_entry(format::cell const * c, unsigned indent, bool flat, bool rest_break, unsigned rest):
+        m_cell(c), m_indent(indent), m_flat(flat), m_rest_break(rest_break), m_rest(rest) {}
+};
 
-format operator+(format const & f1, format const & f2) {
-    return format{f1, f2};
+/** \brief Return the space up to the first line break when \c c is rendered on top of \c todo. */
+static unsigned space_upto_line_break(format::cell const * c, bool flat, std::vector<layout_entry> const & todo,
+                                      bool & found_newline) {
+    unsigned r    = flat ? c->m_flat_width : c->m_break_width;
+    found_newline = !flat && c->m_has_break;
+    if (!found_newline && !todo.empty()) {
+        r             = add_width(r, todo.back().m_rest);
+        found_newline = todo.back().m_rest_break;
+    }
+    return r;
 }
 
-format operator^(format const & f1, format const & f2) {
-    return format {f1, format(" "), f2};
+static void push_entry(std::vector<layout_entry> & todo, format::cell const * c, unsigned indent, bool flat) {
+    bool found_newline;
+    unsigned r = space_upto_line_break(c, flat, todo, found_newline);
+    todo.emplace_back(c, indent, flat, found_newline, r);
 }
 
 std::ostream & format::pretty(std::ostream & out, unsigned w, bool colors, format const & f) {
     unsigned pos        = 0;
-    std::vector<pair<sexpr, unsigned>> todo;
-    todo.push_back(std::make_pair(f.m_value, 0));
+    std::vector<layout_entry> todo;
+    push_entry(todo, f.m_ptr, 0, false);
     while (!todo.empty()) {
         check_system("formatter");
-        auto pair       = todo.back();
-        sexpr s         = pair.first;
-        unsigned indent = pair.second;
+        cell const * c  = todo.back().m_cell;
+        unsigned indent = todo.back().m_indent;
+        bool flat       = todo.back().m_flat;
         todo.pop_back();
 
-        switch (sexpr_kind(s)) {
+        switch (c->m_kind) {
         case format_kind::NIL:
             break;
         case format_kind::COLOR_BEGIN:
             if (colors) {
-                format::format_color c = static_cast<format::format_color>(to_int(cdr(s)));
-                out << "\e[" << (31 + c % 7) << "m";
+                out << "\e[" << (31 + to_color(c)->m_color % 7) << "m";
             }
             break;
         case format_kind::COLOR_END:
@@ -287,36 +386,44 @@ std::ostream & format::pretty(std::ostream & out, unsigned w, bool colors, forma
             }
             break;
         case format_kind::COMPOSE:
-        case format_kind::FLAT_COMPOSE: {
-            unsigned old_sz     = todo.size();
-            for_each(sexpr_compose_list(s), [&](sexpr const & c) { todo.emplace_back(c, indent); });
-            std::reverse(todo.begin() + old_sz, todo.end());
+            push_entry(todo, to_binary(c)->m_second.m_ptr, indent, flat);
+            push_entry(todo, to_binary(c)->m_first.m_ptr, indent, flat);
             break;
-        }
         case format_kind::NEST:
-            todo.emplace_back(sexpr_nest_s(s), indent + sexpr_nest_i(s));
+            push_entry(todo, to_nest(c)->m_body.m_ptr, indent + to_nest(c)->m_indent, flat);
+            break;
+        case format_kind::FLAT:
+            push_entry(todo, to_flat(c)->m_body.m_ptr, indent, true);
             break;
         case format_kind::LINE:
-            pos        = indent;
-            out << "\n";
-            for (unsigned i = 0; i < indent; i++)
+            if (flat) {
+                pos++;
                 out << " ";
+            } else {
+                pos        = indent;
+                out << "\n";
+                for (unsigned i = 0; i < indent; i++)
+                    out << " ";
+            }
             break;
         case format_kind::TEXT:
-            pos += sexpr_text_length(s);
-            if (is_string(cdr(s)))
-                out << to_string(cdr(s));
-            else
-                out << cdr(s);
+            pos += to_text(c)->m_text.size();
+            out << to_text(c)->m_text;
             break;
         case format_kind::CHOICE: {
-            sexpr const & x = sexpr_choice_1(s);
-            sexpr const & y = sexpr_choice_2(s);;
-            int available   = static_cast<int>(w) - static_cast<int>(pos);
-            if (!space_upto_line_break_list_exceeded(x, available, todo))
-                todo.emplace_back(x, indent);
-            else
-                todo.emplace_back(y, indent);
+            cell const * x = to_binary(c)->m_first.m_ptr;
+            cell const * y = to_binary(c)->m_second.m_ptr;
+            if (flat) {
+                push_entry(todo, x, indent, true);
+            } else {
+                int available  = static_cast<int>(w) - static_cast<int>(pos);
+                bool found_newline;
+                unsigned space = space_upto_line_break(x, false, todo, found_newline);
+                if (available >= 0 && space <= static_cast<unsigned>(available))
+                    push_entry(todo, x, indent, false);
+                else
+                    push_entry(todo, y, indent, false);
+            }
         }
         }
     }
@@ -509,6 +616,8 @@ void initialize_format() {
     register_bool_option(*g_pp_unicode, LEAN_DEFAULT_PP_UNICODE, "(pretty printer) use unicode characters");
     register_bool_option(*g_pp_colors, LEAN_DEFAULT_PP_COLORS, "(pretty printer) use colors");
     register_unsigned_option(*g_pp_width, LEAN_DEFAULT_PP_WIDTH, "(pretty printer) line width");
+    g_nil = new format();
+    g_color_end = new format(new format::cell(format::COLOR_END, 13));
     g_line = new format(mk_line());
     g_space = new format(" ");
     g_lp = new format("(");
@@ -534,6 +643,8 @@ void finalize_format() {
     delete g_comma;
     delete g_colon;
     delete g_dot;
+    delete g_color_end;
+    delete g_nil;
     delete g_pp_indent;
     delete g_pp_unicode;
     delete g_pp_colors;
@@ -14,6 +14,8 @@ Author: Soonho Kong
 #include <vector>
 #include "util/pair.h"
 #include "util/debug.h"
+#include "util/rc.h"
+#include "util/buffer.h"
 #include "util/lua.h"
 #include "util/numerics/mpz.h"
 #include "util/sexpr/sexpr.h"
@@ -23,168 +25,70 @@ class options;
 /**
    \brief Format
 
-   uses `sexpr` as an internal representation.
+   Documents are immutable DAGs of reference counted cells.
 
-   nil                    = ["NIL"]
-   text         s         = ("TEXT"  . s)
-   choice       f1 f2     = ("CHOICE"  f1 . f2)
-   compose      f1 ... fn = ["COMPOSE" f1 ... fn]
-   line                   = ["LINE"]
-   nest         n  f      = ("NEST" n . f)
-   highlight    c  f      = ("HIGHLIGHT" c . f)
-*/
+   nil                    = NIL
+   text         s         = (TEXT s)
+   choice       f1 f2     = (CHOICE f1 f2)
+   compose      f1 f2     = (COMPOSE f1 f2)
+   line                   = LINE
+   nest         n  f      = (NEST n f)
+   flatten      f         = (FLAT f)
+   highlight    c  f      = (COMPOSE (COLOR_BEGIN c) (COMPOSE f COLOR_END))
 
+   Every cell caches the width of the document when rendered in flat mode,
+   and the width up to the first line break when rendered in normal mode.
+   The layout engine uses this information to resolve choices in constant time,
+   and the whole document is rendered in a single linear pass.
+*/
 class format {
 public:
-    enum format_kind { NIL, NEST, COMPOSE, FLAT_COMPOSE, CHOICE, LINE, TEXT, COLOR_BEGIN, COLOR_END};
+    enum format_kind { NIL, NEST, COMPOSE, FLAT, CHOICE, LINE, TEXT, COLOR_BEGIN, COLOR_END};
     enum format_color {RED, GREEN, ORANGE, BLUE, PINK, CYAN, GREY};
+    struct cell;
 private:
-    sexpr m_value;
-    static sexpr flatten(sexpr const & s);
-
-    // Functions for the internal sexpr representation
-    static inline format_kind sexpr_kind(sexpr const & s) {
-        lean_assert(is_cons(s));
-        return static_cast<format_kind>(to_int(car(s)));
-    }
-    static inline sexpr sexpr_compose(sexpr const & l) {
-        lean_assert(is_list(l));
-        return sexpr(sexpr(format_kind::COMPOSE), l);
-    }
-    static inline sexpr sexpr_flat_compose(sexpr const & l) {
-        lean_assert(is_list(l));
-        return sexpr(sexpr(format_kind::FLAT_COMPOSE), l);
-    }
-    static inline sexpr sexpr_compose(std::initializer_list<sexpr> const & l) {
-        return sexpr_compose(sexpr(l));
-    }
-    static inline sexpr const & sexpr_compose_list(sexpr const & s) {
-        lean_assert(sexpr_kind(s) == format_kind::COMPOSE || sexpr_kind(s) == format_kind::FLAT_COMPOSE);
-        return cdr(s);
-    }
-    static inline sexpr sexpr_choice(sexpr const & s1, sexpr const & s2) {
-        return sexpr(sexpr(format_kind::CHOICE), sexpr(s1, s2));
-    }
-    static inline sexpr const & sexpr_choice_1(sexpr const & s) {
-        return car(cdr(s));
-    }
-    static inline sexpr const & sexpr_choice_2(sexpr const & s) {
-        return cdr(cdr(s));
-    }
-    static inline sexpr sexpr_nest(int i, sexpr const & s) {
-        return sexpr(sexpr(format_kind::NEST), sexpr(i, s));
-    }
-    static inline int sexpr_nest_i(sexpr const & s) {
-        lean_assert(sexpr_kind(s) == format_kind::NEST);
-        return to_int(car(cdr(s)));
-    }
-    static inline sexpr const & sexpr_nest_s(sexpr const & s) {
-        lean_assert(sexpr_kind(s) == format_kind::NEST);
-        return cdr(cdr(s));
-    }
-    static inline sexpr sexpr_text(sexpr const & s) {
-        return sexpr(sexpr(format_kind::TEXT), s);
-    }
-    static inline sexpr const & sexpr_text_t(sexpr const & s) {
-        lean_assert(sexpr_kind(s) == format_kind::TEXT);
-        return cdr(s);
-    }
-    static inline size_t sexpr_text_length(sexpr const & s) {
-        lean_assert(sexpr_kind(s) == format_kind::TEXT);
-        sexpr const & content = cdr(s);
-        if (is_string(content)) {
-            return to_string(content).length();
-        } else {
-            std::stringstream ss;
-            ss << content;
-            return ss.str().length();
-        }
-    }
-    static inline sexpr sexpr_text(std::string const & s) {
-        return sexpr(sexpr(format_kind::TEXT), sexpr(s));
-    }
-    static inline sexpr sexpr_color_begin(format_color c) {
-        return sexpr(sexpr(format_kind::COLOR_BEGIN), sexpr(c));
-    }
-    static inline format_color sexpr_color_begin(sexpr const & s) {
-        lean_assert(sexpr_kind(s) == format_kind::TEXT);
-        return static_cast<format_color>(to_int(cdr(s)));
-    }
-    static inline sexpr sexpr_color_end() {
-        return sexpr{sexpr(format_kind::COLOR_END)};
-    }
-    static inline sexpr sexpr_highlight(sexpr const & s, format_color c) {
-        return sexpr_compose({sexpr_color_begin(c), s, sexpr_color_end()});
-    }
-    static inline sexpr sexpr_nil() {
-        return sexpr{sexpr(format::format_kind::NIL)};
-    }
-    static inline sexpr sexpr_line() {
-        return sexpr{sexpr(format::format_kind::LINE)};
-    }
+    cell * m_ptr;
+    explicit format(cell * c);
+    static void steal(format & f, buffer<cell*> & todo);
 
-    // Functions used inside of pretty printing
-    static bool space_upto_line_break_list_exceeded(sexpr const & s, int available, std::vector<pair<sexpr, unsigned>> const & todo);
-    static int space_upto_line_break(sexpr const & s, int available, bool & found);
-
-    static bool is_fnil(format const & f)   {
-        return to_int(car(f.m_value)) == format_kind::NIL;
-    }
-    static bool is_compose(format const & f)   {
-        return to_int(car(f.m_value)) == format_kind::COMPOSE;
-    }
-    static bool is_flat_compose(format const & f)   {
-        return to_int(car(f.m_value)) == format_kind::FLAT_COMPOSE;
-    }
-    static bool is_nest(format const & f) {
-        return to_int(car(f.m_value)) == format_kind::NEST;
-    }
-    static bool is_text(format const & f) {
-        return to_int(car(f.m_value)) == format_kind::TEXT;
-    }
-    static bool is_line(format const & f) {
-        return to_int(car(f.m_value)) == format_kind::LINE;
-    }
-    static bool is_choice(format const & f) {
-        return to_int(car(f.m_value)) == format_kind::CHOICE;
-    }
-    friend format choice(format const & f1, format const & f2) {
-        return format(sexpr_choice(f1.m_value, f2.m_value));
-    }
+    static bool is_fnil(format const & f)   { return f.kind() == format_kind::NIL; }
+    static bool is_compose(format const & f) { return f.kind() == format_kind::COMPOSE; }
+    static bool is_flat(format const & f) { return f.kind() == format_kind::FLAT; }
+    static bool is_nest(format const & f) { return f.kind() == format_kind::NEST; }
+    static bool is_text(format const & f) { return f.kind() == format_kind::TEXT; }
+    static bool is_line(format const & f) { return f.kind() == format_kind::LINE; }
+    static bool is_choice(format const & f) { return f.kind() == format_kind::CHOICE; }
+    static cell * mk_text(std::string const & s, bool is_name = false);
+    friend format choice(format const & f1, format const & f2);
+    friend void initialize_format();
 
 public:
     // Constructors
-    format():m_value(sexpr_nil()) {}
-    explicit format(sexpr const & v):m_value(v) {}
-    explicit format(char const * v):m_value(sexpr_text(sexpr(v))) {}
-    explicit format(std::string const & v):m_value(sexpr_text(sexpr(v))) {}
-    explicit format(int v):m_value(sexpr_text(sexpr(v))) {}
-    explicit format(double v):m_value(sexpr_text(sexpr(v))) {}
-    explicit format(unsigned v):m_value(sexpr_text(sexpr(mpz(v)))) {}
-    explicit format(name const & v):m_value(sexpr_text(sexpr(v))) {}
-    explicit format(mpz const & v):m_value(sexpr_text(sexpr(v))) {}
-    explicit format(mpq const & v):m_value(sexpr_text(sexpr(v))) {}
-    format(format const & f1, format const & f2):m_value(sexpr_compose({f1.m_value, f2.m_value})) {}
-    format(format const & f):m_value(f.m_value) {}
-    format(std::initializer_list<format> const & l):format() {
-        lean_assert(l.size() >= 2);
-        auto it = l.begin();
-        sexpr const & s1 = (it++)->m_value;
-        sexpr const & s2 = (it++)->m_value;
-        m_value = sexpr_compose({s1, s2});
+    format();
+    explicit format(char const * v);
+    explicit format(std::string const & v);
+    explicit format(int v);
+    explicit format(double v);
+    explicit format(unsigned v);
+    explicit format(name const & v);
+    explicit format(mpz const & v);
+    explicit format(mpq const & v);
+    format(format const & f1, format const & f2);
+    format(format const & f);
+    format(format && f):m_ptr(f.m_ptr) { f.m_ptr = nullptr; }
+    format(std::initializer_list<format> const & l);
+    ~format();
 
-        m_value = std::accumulate(it, l.end(), m_value,
-                                  [](sexpr const & result, const format f) {
-                                      return sexpr_compose({result, f.m_value});
-                                  });
-    }
+    format & operator=(format const & f);
+    format & operator=(format && f);
 
-    format_kind kind() const {
-        return sexpr_kind(m_value);
-    }
-    unsigned hash() const { return m_value.hash(); }
+    format_kind kind() const;
+    unsigned hash() const;
 
-    explicit operator bool() const { return static_cast<bool>(m_value); }
+    explicit operator bool() const { return m_ptr != nullptr; }
+
+    /** \brief Return the width of this document when it is rendered in a single line. */
+    unsigned flat_width() const;
 
     friend format compose(format const & f1, format const & f2);
     friend format nest(int i, format const & f);
@@ -220,9 +124,42 @@ public:
     friend std::ostream & operator<<(std::ostream & out, pair<format const &, options const &> const & p);
 
     /** \brief Return true iff f is just a name */
-    friend bool is_name(format const & f) { return format::is_text(f) && ::lean::is_name(cdr(f.m_value)); }
+    friend bool is_name(format const & f);
+};
+
+/**
+   \brief Header shared by all format cells. The layout information is
+   computed once, when the cell is created.
+*/
+struct format::cell {
+    MK_LEAN_RC(); // Declare m_rc counter
+    void dealloc();
+public:
+    format_kind m_kind;
+    /** \brief Flatten(f) differs from f, i.e., f contains a line break or a choice. */
+    bool        m_flat_differs;
+    /** \brief Normal rendering contains a line break. */
+    bool        m_has_break;
+    /** \brief Width when rendered in flat mode (saturated at UINT_MAX). */
+    unsigned    m_flat_width;
+    /** \brief Width up to the first line break when rendered in normal mode (saturated at UINT_MAX). */
+    unsigned    m_break_width;
+    unsigned    m_hash;
+    cell(format_kind k, unsigned h):
+        m_rc(0), m_kind(k), m_flat_differs(false), m_has_break(false), m_flat_width(0), m_break_width(0), m_hash(h) {}
 };
 
+inline format::format(format const & f):m_ptr(f.m_ptr) { if (m_ptr) m_ptr->inc_ref(); }
+inline format::~format() { if (m_ptr) m_ptr->dec_ref(); }
+inline format & format::operator=(format const & f) { LEAN_COPY_REF(f); }
+inline format & format::operator=(format && f) { LEAN_MOVE_REF(f); }
+inline format::format_kind format::kind() const { return m_ptr->m_kind; }
+inline unsigned format::hash() const { return m_ptr->m_hash; }
+inline unsigned format::flat_width() const { return m_ptr->m_flat_width; }
+
+format choice(format const & f1, format const & f2);
+format flatten(format const & f);
+bool is_name(format const & f);
 format wrap(format const & f1, format const & f2);
 format compose(format const & f1, format const & f2);
 format nest(int i, format const & f);
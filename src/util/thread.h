@@ -99,6 +99,9 @@ public:
     operator T() const { return m_value; }
     void store(T const & v) { m_value = v; }
     T load() const { return m_value; }
+    bool compare_exchange_weak(T & expected, T const & desired) {
+        if (m_value == expected) { m_value = desired; return true; } else { expected = m_value; return false; }
+    }
     atomic & operator|=(T const & v) { m_value |= v; return *this; }
     atomic & operator+=(T const & v) { m_value += v; return *this; }
     atomic & operator-=(T const & v) { m_value -= v; return *this; }
@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#include <algorithm>
+#include "util/debug.h"
+#include "util/thread_pool.h"
+
+namespace lean {
+#if defined(LEAN_MULTI_THREAD)
+void task_signal::notify() {
+    lock_guard<mutex> lk(m_mutex);
+    m_cv.notify_all();
+}
+
+thread_pool::thread_pool():m_num_idle(0), m_stop(false) {}
+
+thread_pool::~thread_pool() {
+    {
+        lock_guard<mutex> lk(m_mutex);
+        m_stop = true;
+        for (thread_ptr & th : m_threads)
+            th->request_interrupt();
+    }
+    m_cv.notify_all();
+    for (thread_ptr & th : m_threads)
+        th->join();
+}
+
+void thread_pool::finish(pool_task_ref const & t) {
+    t->m_done = true;
+    t->m_signal->notify();
+}
+
+void thread_pool::worker(unsigned idx) {
+    while (true) {
+        pool_task_ref t;
+        {
+            unique_lock<mutex> lk(m_mutex);
+            while (!m_stop && m_queue.empty())
+                m_cv.wait(lk);
+            if (m_stop)
+                return;
+            t = m_queue.front();
+            m_queue.pop_front();
+            m_num_idle--;
+            // the flag may have been set when the previous task was cancelled
+            reset_interrupt();
+            t->m_state  = pool_task::state::Running;
+            t->m_worker = idx;
+        }
+        try {
+            t->m_fn();
+        } catch (...) {
+            // tasks are responsible for reporting their own failures
+        }
+        t->m_fn = std::function<void()>(); // release resources captured by the task
+        {
+            // the thread must be idle before the task is marked as done, otherwise
+            // the next submit may create an unnecessary thread
+            lock_guard<mutex> lk(m_mutex);
+            t->m_state = pool_task::state::Done;
+            m_num_idle++;
+        }
+        finish(t);
+    }
+}
+
+void thread_pool::submit(pool_task_ref const & t) {
+    lock_guard<mutex> lk(m_mutex);
+    m_queue.push_back(t);
+    if (m_queue.size() > m_num_idle) {
+        unsigned idx = m_threads.size();
+        m_threads.push_back(thread_ptr(new interruptible_thread([=]() { worker(idx); })));
+        m_num_idle++;
+    }
+    m_cv.notify_one();
+}
+
+void thread_pool::cancel(pool_task_ref const & t) {
+    {
+        lock_guard<mutex> lk(m_mutex);
+        if (t->m_state == pool_task::state::Running)
+            m_threads[t->m_worker]->request_interrupt();
+        if (t->m_state != pool_task::state::Waiting)
+            return;
+        t->m_state = pool_task::state::Done;
+        m_queue.erase(std::find(m_queue.begin(), m_queue.end(), t));
+    }
+    finish(t);
+}
+
+unsigned thread_pool::get_num_threads() {
+    lock_guard<mutex> lk(m_mutex);
+    return m_threads.size();
+}
+
+static thread_pool * g_thread_pool = nullptr;
+
+thread_pool & get_thread_pool() {
+    lean_assert(g_thread_pool);
+    return *g_thread_pool;
+}
+
+task_group::task_group():m_signal(std::make_shared<task_signal>()) {}
+
+task_group::~task_group() {
+    cancel();
+}
+
+unsigned task_group::add(std::function<void()> const & fn) {
+    pool_task_ref t = std::make_shared<pool_task>(fn, m_signal);
+    m_tasks.push_back(t);
+    get_thread_pool().submit(t);
+    return m_tasks.size() - 1;
+}
+
+bool task_group::wait(std::function<bool()> const & pred, unsigned ms, unsigned check_ms) {
+    if (check_ms == 0)
+        check_ms = 1;
+    auto start = chrono::steady_clock::now();
+    while (true) {
+        {
+            unique_lock<mutex> lk(m_signal->m_mutex);
+            if (pred())
+                return true;
+            chrono::milliseconds d(check_ms);
+            if (ms > 0) {
+                auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+                if (elapsed >= chrono::milliseconds(ms))
+                    return false;
+                d = std::min(d, chrono::milliseconds(ms) - elapsed);
+            }
+            m_signal->m_cv.wait_for(lk, d);
+            if (pred())
+                return true;
+        }
+        check_interrupted();
+    }
+}
+
+void task_group::cancel() {
+    if (m_tasks.empty())
+        return;
+    for (pool_task_ref const & t : m_tasks)
+        get_thread_pool().cancel(t);
+    unique_lock<mutex> lk(m_signal->m_mutex);
+    while (!std::all_of(m_tasks.begin(), m_tasks.end(), [](pool_task_ref const & t) { return t->m_done.load(); }))
+        m_signal->m_cv.wait(lk);
+    m_tasks.clear();
+}
+
+void initialize_thread_pool() {
+    if (!g_thread_pool)
+        g_thread_pool = new thread_pool();
+}
+
+void finalize_thread_pool() {
+    delete g_thread_pool;
+    g_thread_pool = nullptr;
+}
+#else
+void initialize_thread_pool() {}
+void finalize_thread_pool() {}
+#endif
+}
@@ -0,0 +1,111 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#pragma once
+#include <memory>
+#include <functional>
+#include <vector>
+#include <deque>
+#include "util/thread.h"
+#include "util/interrupt.h"
+
+namespace lean {
+#if defined(LEAN_MULTI_THREAD)
+class thread_pool;
+class task_group;
+
+/** \brief Synchronization object used to wait for the completion of the tasks in a task_group. */
+class task_signal {
+    friend class thread_pool;
+    friend class task_group;
+    mutex              m_mutex;
+    condition_variable m_cv;
+public:
+    void notify();
+};
+
+/** \brief Task executed by the shared thread pool. */
+class pool_task {
+    friend class thread_pool;
+    friend class task_group;
+    enum class state { Waiting, Running, Done };
+    std::function<void()>        m_fn;
+    std::shared_ptr<task_signal> m_signal;
+    state                        m_state;  // protected by the thread_pool mutex
+    unsigned                     m_worker; // index of the thread executing the task when m_state == Running
+    atomic<bool>                 m_done;
+public:
+    pool_task(std::function<void()> const & fn, std::shared_ptr<task_signal> const & s):
+        m_fn(fn), m_signal(s), m_state(state::Waiting), m_worker(0), m_done(false) {}
+};
+typedef std::shared_ptr<pool_task> pool_task_ref;
+
+/**
+   \brief Pool of interruptible threads used to execute short-lived tasks (e.g., the alternatives of
+   the \c par and \c timeout combinators, and the goals solved in parallel by \c all_goals) without
+   creating a thread for each one of them.
+
+   The pool grows on demand: a new thread is created whenever a task is submitted and there is no idle
+   thread. So, a task never waits for another one to finish before it starts, and nested uses of
+   the pool cannot deadlock. The threads are only destroyed when the pool is destroyed.
+*/
+class thread_pool {
+    typedef std::unique_ptr<interruptible_thread> thread_ptr;
+    mutex                      m_mutex;
+    condition_variable         m_cv;
+    std::deque<pool_task_ref>  m_queue;
+    std::vector<thread_ptr>    m_threads;
+    unsigned                   m_num_idle; // threads that are not executing a task
+    bool                       m_stop;
+
+    void worker(unsigned idx);
+    static void finish(pool_task_ref const & t);
+public:
+    thread_pool();
+    ~thread_pool();
+    /** \brief Execute \c t in one of the threads of the pool. */
+    void submit(pool_task_ref const & t);
+    /**
+       \brief Cancel the given task. If it did not start yet, it will not be executed.
+       Otherwise, the interrupt flag of the thread executing it is set.
+    */
+    void cancel(pool_task_ref const & t);
+    /** \brief Return the number of threads in the pool. */
+    unsigned get_num_threads();
+};
+
+/** \brief Return the thread pool shared by all modules. */
+thread_pool & get_thread_pool();
+
+/**
+   \brief Set of tasks executed by the shared thread pool. The destructor cancels the tasks that
+   did not finish yet, and waits for them.
+*/
+class task_group {
+    std::shared_ptr<task_signal> m_signal;
+    std::vector<pool_task_ref>   m_tasks;
+public:
+    task_group();
+    ~task_group();
+    /** \brief Execute \c fn in the shared thread pool, and return its index in this group. */
+    unsigned add(std::function<void()> const & fn);
+    /** \brief Return true iff the i-th task finished (or was cancelled before starting). */
+    bool done(unsigned i) const { return m_tasks[i]->m_done; }
+    /**
+       \brief Wait until \c pred returns true or \c ms milliseconds have passed (if \c ms is not 0).
+       The predicate is evaluated whenever a task in this group finishes. Return the last value of \c pred.
+
+       \remark The interrupt flag of the current thread is checked every \c check_ms milliseconds.
+    */
+    bool wait(std::function<bool()> const & pred, unsigned ms = 0, unsigned check_ms = g_small_sleep);
+    /** \brief Cancel the tasks that did not finish yet, and wait for them. */
+    void cancel();
+};
+#endif
+
+void initialize_thread_pool();
+void finalize_thread_pool();
+}
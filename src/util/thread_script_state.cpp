@@ -5,21 +5,31 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <vector>
-#include <utility>
 #include <string>
 #include <memory>
 #include <iostream>
+#include <chrono>
 #include "util/thread.h"
-#include "util/pair.h"
-#include "util/script_state.h"
+#include "util/optional.h"
+#include "util/lua.h"
+#include "util/thread_script_state.h"
 
 namespace lean {
+/** \brief Code block executed by system_dostring or module imported by system_import */
+struct code_block {
+    bool        m_module;
+    std::string m_name;   // module file name, it is only used when m_module is true
+    std::string m_chunk;  // Lua bytecode
+    code_block(bool m, std::string const & n, std::string const & c):m_module(m), m_name(n), m_chunk(c) {}
+};
+
 struct script_state_manager {
     mutex                                m_code_mutex;
-    std::vector<pair<bool, std::string>> m_code;
+    std::vector<code_block>              m_code;
     mutex                                m_state_mutex;
     std::vector<script_state>            m_states;
     std::vector<script_state>            m_available_states;
+    thread_script_state_stats            m_stats;
     script_state_manager() {}
     ~script_state_manager() {}
 };
@@ -41,68 +51,127 @@ static script_state_manager & get_script_state_manager() {
 
 static bool is_manager_alive() { return g_manager; }
 
-/** \brief Execute \c code in all states in the pool */
-void system_dostring(char const * code) {
+static void execute(script_state & s, code_block const & b) {
+    if (b.m_module)
+        s.import_explicit(b.m_name.c_str(), b.m_chunk);
+    else
+        s.dochunk(b.m_chunk);
+}
+
+static void system_execute(code_block const & b) {
     script_state_manager & m = get_script_state_manager();
     {
         // Execute code in all existing states
         lock_guard<mutex> lk(m.m_state_mutex);
         for (auto & s : m.m_states) {
-            s.dostring(code);
+            execute(s, b);
         }
     }
     {
         // Save code for future states
         lock_guard<mutex> lk(m.m_code_mutex);
-        m.m_code.push_back(mk_pair(true, code));
+        m.m_code.push_back(b);
     }
 }
 
+/** \brief Execute \c code in all states in the pool */
+void system_dostring(char const * code) {
+    system_execute(code_block(false, std::string(), compile_string(code)));
+}
+
+static bool is_system_module(char const * fname) {
+    script_state_manager & m = get_script_state_manager();
+    lock_guard<mutex> lk(m.m_code_mutex);
+    for (auto const & b : m.m_code) {
+        if (b.m_module && b.m_name == fname)
+            return true;
+    }
+    return false;
+}
+
 /** \brief Import \c fname in all states in the pool */
 void system_import(char const * fname) {
-    script_state_manager & m = get_script_state_manager();
+    if (is_system_module(fname))
+        return; // module was already compiled and imported
+    system_execute(code_block(true, fname, compile_file(fname)));
+}
+
+/** \brief Create a new state, and execute the existing code in it */
+static script_state mk_state(script_state_manager & m) {
+    lock_guard<mutex> lk(m.m_code_mutex);
+    script_state r;
+    for (auto const & b : m.m_code)
+        execute(r, b);
     {
-        // Import file in all existing states
+        // save new state in vector of all states
         lock_guard<mutex> lk(m.m_state_mutex);
-        for (auto & s : m.m_states) {
-            s.import_explicit(fname);
-        }
-    }
-    {
-        // Save module for future states
-        lock_guard<mutex> lk(m.m_code_mutex);
-        m.m_code.push_back(mk_pair(false, fname));
+        m.m_states.push_back(r);
     }
+    return r;
 }
 
 static script_state get_state() {
     script_state_manager & m = get_script_state_manager();
+    auto start = std::chrono::steady_clock::now();
+    bool reused = false;
+    optional<script_state> r;
     {
         // Try to reuse existing state
         lock_guard<mutex> lk(m.m_state_mutex);
         if (!m.m_available_states.empty()) {
-            script_state r(m.m_available_states.back());
+            r = m.m_available_states.back();
             m.m_available_states.pop_back();
-            return r;
+            reused = true;
         }
     }
-
+    if (!r)
+        r = mk_state(m);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     {
-        // Execute existing code in new state
-        lock_guard<mutex> lk(m.m_code_mutex);
-        script_state r;
-        for (auto const & p : m.m_code) {
-            if (p.first)
-                r.dostring(p.second.c_str());
-            else
-                r.import_explicit(p.second.c_str());
-        }
+        lock_guard<mutex> lk(m.m_state_mutex);
+        thread_script_state_stats & st = m.m_stats;
+        if (reused)
+            st.m_num_reused++;
+        else
+            st.m_num_created++;
+        st.m_total_secs += secs;
+        if (secs > st.m_max_secs)
+            st.m_max_secs = secs;
+        st.m_uses.emplace_back(secs, reused);
+    }
+    return *r;
+}
+
+void prewarm_thread_script_states(unsigned num) {
+    script_state_manager & m = get_script_state_manager();
+    while (true) {
         {
-            // save new state in vector of all states
             lock_guard<mutex> lk(m.m_state_mutex);
-            m.m_states.push_back(r);
+            if (m.m_available_states.size() >= num)
+                return;
         }
-        return r;
+        script_state s = mk_state(m);
+        lock_guard<mutex> lk(m.m_state_mutex);
+        m.m_available_states.push_back(s);
+    }
+}
+
+thread_script_state_stats get_thread_script_state_stats() {
+    script_state_manager & m = get_script_state_manager();
+    lock_guard<mutex> lk(m.m_state_mutex);
+    return m.m_stats;
+}
+
+void display_thread_script_state_stats(std::ostream & out) {
+    thread_script_state_stats st = get_thread_script_state_stats();
+    unsigned num = st.m_num_created + st.m_num_reused;
+    out << "script states: " << st.m_num_created << " created, " << st.m_num_reused << " reused";
+    if (num > 0)
+        out << ", first use " << st.m_total_secs / num << " secs on average, " << st.m_max_secs << " secs max";
+    out << "\n";
+    for (unsigned i = 0; i < st.m_uses.size(); i++) {
+        out << "  thread #" << i + 1 << ": first use " << st.m_uses[i].m_secs << " secs, "
+            << (st.m_uses[i].m_reused ? "reused" : "created") << "\n";
     }
 }
 
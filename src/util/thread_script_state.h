@@ -5,13 +5,15 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <iostream>
+#include <vector>
 #include "util/script_state.h"
 namespace lean {
 /**
     \brief Execute the given piece of code in all global/system script_state objects.
 
-    \remark The code fragments are saved. If a thread needs to create a new
-    script_state object, all code blocks are executed.
+    \remark The code fragments are compiled once and the bytecode is saved.
+    If a thread needs to create a new script_state object, all code blocks are executed.
 
     \remark System code should be installed when Lean is started.
 */
@@ -19,10 +21,17 @@ void system_dostring(char const * code);
 /**
    \brief Import the given module in all global/system script_state objects.
 
-   \remark The module name is saved. If a thread needs to create a new
-   script_state object, all modules are imported.
+   \remark The module is compiled once, and its bytecode is saved.
+   If a thread needs to create a new script_state object, all modules are imported.
+   Modules that have already been imported are ignored.
 */
 void system_import(char const * fname);
+/**
+   \brief Make sure the pool contains at least \c num script_state objects that
+   are not being used by any thread. This method should be invoked before creating
+   worker threads that use #get_thread_script_state.
+*/
+void prewarm_thread_script_states(unsigned num);
 /**
    \brief Retrieve a script_state object for the current thread.
    The thread has exclusive access until the thread is destroyed,
@@ -39,6 +48,25 @@ script_state get_thread_script_state();
 */
 void release_thread_script_state();
 
+/** \brief First invocation of #get_thread_script_state in a thread. */
+struct thread_script_state_use {
+    double m_secs;   // time spent, in seconds
+    bool   m_reused; // true if the script_state object was obtained from the pool
+    thread_script_state_use(double secs, bool reused):m_secs(secs), m_reused(reused) {}
+};
+
+/** \brief Statistics for the first invocation of #get_thread_script_state in each thread. */
+struct thread_script_state_stats {
+    unsigned m_num_created;  // number of threads that had to create a new script_state object
+    unsigned m_num_reused;   // number of threads that obtained a script_state object from the pool
+    double   m_total_secs;   // total time spent, in seconds
+    double   m_max_secs;     // maximum time spent by a single thread, in seconds
+    std::vector<thread_script_state_use> m_uses; // one entry per thread, in the order they requested a state
+    thread_script_state_stats():m_num_created(0), m_num_reused(0), m_total_secs(0.0), m_max_secs(0.0) {}
+};
+thread_script_state_stats get_thread_script_state_stats();
+void display_thread_script_state_stats(std::ostream & out);
+
 void enable_script_state_recycling(bool flag);
 void initialize_thread_script_state();
 void finalize_thread_script_state();
@@ -0,0 +1,44 @@
+import data.nat data.list data.bool
+open nat list bool
+
+definition fib : nat → nat
+| fib 0     := 1
+| fib 1     := 1
+| fib (n+2) := fib (n+1) + fib n
+
+definition ins : nat → list nat → list nat
+| ins a []     := [a]
+| ins a (b::l) := if a ≤ b then a::b::l else b::ins a l
+
+definition isort : list nat → list nat
+| isort []     := []
+| isort (a::l) := ins a (isort l)
+
+-- The following commands are evaluated by the bytecode evaluator.
+eval 30 * 40
+eval 2 + 3 * 4 - 1
+eval fib 10
+eval isort [5, 3, 9, 1, 4, 1]
+eval length (isort [5, 3, 9, 1, 4, 1])
+eval band tt (bnot ff)
+eval (show nat, from 2 + 2)
+eval (have h : nat, from fib 5, h + 1)
+-- well-founded recursion, the recursor for acc is applied to a proof
+eval 100 mod 7
+eval gcd 12 18
+
+-- Closures and proofs are not first-order data, the normalizer is used instead.
+eval λ x : nat, x + 0
+eval (eq.refl (2:nat))
+
+set_option eval.vm false
+eval 30 * 40
+eval 2 + 3 * 4 - 1
+eval fib 10
+eval isort [5, 3, 9, 1, 4, 1]
+eval length (isort [5, 3, 9, 1, 4, 1])
+eval band tt (bnot ff)
+eval (show nat, from 2 + 2)
+eval (have h : nat, from fib 5, h + 1)
+eval 100 mod 7
+eval gcd 12 18
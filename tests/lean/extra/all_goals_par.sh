@@ -0,0 +1,20 @@
+#!/bin/bash
+# Check that the all_goals examples in ../run/all_goals_par.lean take the expected paths:
+# the merge of the solutions computed in parallel, the sequential execution for goals sharing
+# metavariables, and the failure reported by the parallel execution
+set -e
+if [ $# -ne 1 ]; then
+    echo "Usage: all_goals_par.sh [lean-executable-path]"
+    exit 1
+fi
+LEAN=$1
+export LEAN_PATH=../../../library:../run
+"$LEAN" --profile ../run/all_goals_par.lean > all_goals_par.produced.out 2>&1
+stats=`grep "^parallel all_goals:" all_goals_par.produced.out`
+echo "$stats"
+if [ "$stats" != "parallel all_goals: 3 merged, 1 dependent, 0 conflicts, 1 failures" ]; then
+    echo "FAILED: expected 3 merged, 1 dependent, 0 conflicts and 1 failures"
+    exit 1
+fi
+rm -f -- all_goals_par.produced.out
+echo "done"
@@ -0,0 +1,28 @@
+-- Closed pre-terms that occur in many declarations of the same file
+open nat
+
+definition f (a : nat) : nat := succ (succ a)
+definition g : nat → nat → nat := λ a b, f a
+
+definition c1 : nat → nat := f
+definition c2 : nat → nat := f
+definition c3 : nat := f (succ zero)
+definition c4 : nat := f (succ zero)
+
+example : c3 = c4 := rfl
+example : (f (succ zero)) = succ (succ (succ zero)) := rfl
+
+section
+  parameter (A : Type)
+  definition id1 (a : A) : A := a
+  -- the pre-term (nat → nat) does not depend on the section parameter
+  definition h (a : A) : nat → nat := f
+end
+
+namespace foo
+  definition f (a : nat) : nat := a
+  -- here f refers to foo.f, so the cached result for the root f must not be used
+  example : f (succ zero) = succ zero := rfl
+end foo
+
+example : f (succ zero) = succ (succ (succ zero)) := rfl
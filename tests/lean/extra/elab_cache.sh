@@ -0,0 +1,20 @@
+#!/bin/bash
+# Check that the elaborator cache is used when the same closed pre-terms occur in many declarations
+set -e
+if [ $# -ne 1 ]; then
+    echo "Usage: elab_cache.sh [lean-executable-path]"
+    exit 1
+fi
+LEAN=$1
+export LEAN_PATH=../../../library:.
+"$LEAN" --profile elab_cache.lean > elab_cache.produced.out 2>&1
+stats=`grep "^elaborator cache:" elab_cache.produced.out`
+echo "$stats"
+hits=`echo "$stats" | sed 's/^elaborator cache: \([0-9]*\) hits.*$/\1/'`
+weight=`echo "$stats" | sed 's/^.*total weight of reused pre-terms: \([0-9]*\)$/\1/'`
+if [ "$hits" -eq 0 -o "$weight" -eq 0 ]; then
+    echo "FAILED: the elaborator cache was not used"
+    exit 1
+fi
+rm -f -- elab_cache.produced.out
+echo "done"
@@ -0,0 +1,19 @@
+#!/bin/bash
+# Check that the eval commands in ../eval_vm.lean that should be handled by the bytecode evaluator
+# do not fall back to the normalizer (the results are the same)
+set -e
+if [ $# -ne 1 ]; then
+    echo "Usage: eval_vm.sh [lean-executable-path]"
+    exit 1
+fi
+LEAN=$1
+export LEAN_PATH=../../../library:..
+"$LEAN" --profile ../eval_vm.lean > eval_vm.produced.out 2>&1
+stats=`grep "^bytecode evaluator:" eval_vm.produced.out`
+echo "$stats"
+if [ "$stats" != "bytecode evaluator: 10 successes, 2 failures" ]; then
+    echo "FAILED: expected 10 successes and 2 failures"
+    exit 1
+fi
+rm -f -- eval_vm.produced.out
+echo "done"
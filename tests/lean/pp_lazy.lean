@@ -0,0 +1,12 @@
+import data.nat
+open nat
+
+set_option pp.lazy true
+set_option pp.max_depth 3
+
+check λ (f : ℕ → ℕ) (a b : ℕ), f (f (f (f (f a)))) = f (f (f (f (f b))))
+check (λ x : ℕ, x + 1) ((λ y : ℕ, y * 2) 3)
+
+set_option pp.lazy false
+check λ (f : ℕ → ℕ) (a b : ℕ), f (f (f (f (f a)))) = f (f (f (f (f b))))
+check (λ x : ℕ, x + 1) ((λ y : ℕ, y * 2) 3)
@@ -0,0 +1,30 @@
+import data.nat
+open nat
+
+attribute nat.add [unfold-c 2]
+attribute nat.rec_on [unfold-c 2]
+
+set_option tactic.par_goals 4
+
+example (a b c d : nat) : (a + 0 = 0 + a ∧ b + 0 = 0 + b) ∧ (c + 0 = 0 + c ∧ d + 0 = 0 + d) :=
+begin
+  apply and.intro,
+  all_goals apply and.intro,
+  all_goals esimp[of_num],
+  all_goals rewrite zero_add
+end
+
+
+-- the goals share the metavariable for the witness, so they are solved sequentially
+example : ∃ x : nat, x = 0 ∧ 0 = x :=
+begin
+  apply exists.intro,
+  apply and.intro,
+  all_goals try (apply eq.refl)
+end
+
+-- all_goals fails on the second goal, the parallel execution reports the failure
+example (a b : Prop) (Ha : a) : (a ∧ b) ∨ a :=
+begin
+  (apply or.inl; apply and.intro; all_goals assumption | apply or.inr; assumption)
+end
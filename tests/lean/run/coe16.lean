@@ -0,0 +1,26 @@
+-- Coercions are retrieved using the (from-class, to-class) index, including the ones obtained by transitivity
+namespace play
+constants A B C D : Type.{1}
+constant a2b : A → B
+constant b2c : B → C
+constant c2d : C → D
+constant d2fn : D → (D → D)
+constant b2sort : B → Type.{1}
+attribute a2b [coercion]
+attribute c2d [coercion]
+attribute b2c [coercion]
+attribute d2fn [coercion]
+attribute b2sort [coercion]
+
+constants (a : A) (b : B) (d : D)
+constant fC : C → C
+constant fD : D → D
+
+check fC a
+check fD a
+check fD b
+check a d
+check (λ x : b, x)
+example : fD a = fD (c2d (b2c (a2b a))) := rfl
+example : a d = d2fn (c2d (b2c (a2b a))) d := rfl
+end play
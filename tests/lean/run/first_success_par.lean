@@ -0,0 +1,20 @@
+import logic
+open tactic
+
+theorem tst1 (a b : Prop) (Ha : a) (Hb : b) : b :=
+by first_success_par [exact Ha, assumption]
+
+theorem tst2 (a b : Prop) (Ha : a) (Hb : b) : a :=
+by first_success_par [assumption, fail]
+
+theorem tst3 (a b c : Prop) (Ha : a) (Hb : b) (Hc : c) : c :=
+by first_success_par [exact Ha, exact Hb, exact Hc]
+
+theorem tst4 (a b : Prop) (Ha : a) (Hb : b) : a ∧ b :=
+begin
+  apply and.intro,
+  all_goals first_success_par [fail, first_success_par [exact Hb, assumption]]
+end
+
+example (a : Prop) (Ha : a) : a :=
+by first_success_par [assumption]
@@ -0,0 +1,29 @@
+-- The resolution of an identifier must be updated when the set of open namespaces,
+-- the aliases or the declarations in the environment change.
+open nat
+
+definition f : nat := 0
+
+namespace foo
+  definition f : nat := 1
+  example : f = 1 := rfl
+  example : f = 1 := rfl
+end foo
+
+example : f = 0 := rfl
+
+namespace bar
+  example : f = 0 := rfl
+  definition f : nat := 2
+  example : f = 2 := rfl
+end bar
+
+section
+  open foo
+  example : foo.f = 1 := rfl
+end
+
+example : f = 0 := rfl
+open bar
+example : bar.f = 2 := rfl
+example : _root_.f = 0 := rfl
@@ -0,0 +1,69 @@
+-- Large pattern-matching definitions used to track the time spent in the equation compiler.
+-- Many of the equations overlap, and the compiler produces identical subproblems
+-- for different branches of the case tree.
+open nat bool inhabited
+
+inductive color :=
+| c1 : color | c2 : color | c3 : color | c4 : color | c5 : color
+| c6 : color | c7 : color | c8 : color | c9 : color | c10 : color
+
+namespace color
+
+definition mix : color → color → color → color → nat
+| mix c1 c1 _  _  := 1
+| mix _  c2 c2 _  := 2
+| mix _  _  c3 c3 := 3
+| mix c4 _  _  c4 := 4
+| mix c5 c5 c5 _  := 5
+| mix _  c6 c6 c6 := 6
+| mix c7 _  c7 c7 := 7
+| mix c8 c8 _  c8 := 8
+| mix c9 c9 c9 c9 := 9
+| mix _  _  _  _  := 0
+
+example : mix c1 c1 c9 c10 = 1 := rfl
+example : mix c3 c2 c2 c1  = 2 := rfl
+example : mix c9 c9 c9 c9  = 9 := rfl
+example : mix c10 c1 c2 c3 = 0 := rfl
+
+definition to_nat : color → nat
+| to_nat c1  := 1 | to_nat c2 := 2 | to_nat c3 := 3 | to_nat c4 := 4 | to_nat c5  := 5
+| to_nat c6  := 6 | to_nat c7 := 7 | to_nat c8 := 8 | to_nat c9 := 9 | to_nat c10 := 10
+
+definition before : color → color → bool
+| before c1 c1 := ff | before c1 _ := tt
+| before c2 c1 := ff | before c2 c2 := ff | before c2 _ := tt
+| before c3 c1 := ff | before c3 c2 := ff | before c3 c3 := ff | before c3 _ := tt
+| before c4 c5 := tt | before c4 c6 := tt | before c4 c7 := tt | before c4 c8 := tt | before c4 c9 := tt | before c4 c10 := tt
+| before c5 c6 := tt | before c5 c7 := tt | before c5 c8 := tt | before c5 c9 := tt | before c5 c10 := tt
+| before _  _  := ff
+
+example : before c1 c2 = tt := rfl
+example : before c4 c9 = tt := rfl
+example : before c9 c4 = ff := rfl
+
+end color
+
+inductive tree :=
+| leaf : tree
+| node : tree → color → tree → tree
+
+namespace tree
+open color
+
+definition rotate : tree → tree
+| rotate (node (node (node a c1 b) c2 c) c3 d) := node (node a c1 b) c2 (node c c3 d)
+| rotate (node (node a c1 (node b c2 c)) c3 d) := node (node a c1 b) c2 (node c c3 d)
+| rotate (node a c1 (node (node b c2 c) c3 d)) := node (node a c1 b) c2 (node c c3 d)
+| rotate (node a c1 (node b c2 (node c c3 d))) := node (node a c1 b) c2 (node c c3 d)
+| rotate t                                     := t
+
+example : rotate leaf = leaf := rfl
+example : rotate (node leaf c1 (node leaf c2 (node leaf c3 leaf))) =
+          node (node leaf c1 leaf) c2 (node leaf c3 leaf) := rfl
+
+definition depth : tree → nat
+| depth leaf         := 0
+| depth (node l _ r) := succ (depth l + depth r)
+
+end tree
@@ -0,0 +1,57 @@
+-- Inductive declarations modeled after the ones in library/data. They exercise the generation of
+-- the auxiliary declarations (rec_on, induction_on, cases_on, no_confusion, below, brec_on).
+open nat
+
+inductive weekday :=
+| mon : weekday | tue : weekday | wed : weekday | thu : weekday
+| fri : weekday | sat : weekday | sun : weekday
+
+inductive opcode :=
+| op0  : opcode | op1  : opcode | op2  : opcode | op3  : opcode | op4  : opcode
+| op5  : opcode | op6  : opcode | op7  : opcode | op8  : opcode | op9  : opcode
+| op10 : opcode | op11 : opcode | op12 : opcode | op13 : opcode | op14 : opcode
+| op15 : opcode | op16 : opcode | op17 : opcode | op18 : opcode | op19 : opcode
+| op20 : opcode | op21 : opcode | op22 : opcode | op23 : opcode | op24 : opcode
+
+inductive mylist (A : Type) : Type :=
+| nil {} : mylist A
+| cons   : A → mylist A → mylist A
+
+inductive myvector (A : Type) : nat → Type :=
+| nil {} : myvector A zero
+| cons   : Π {n}, A → myvector A n → myvector A (succ n)
+
+inductive term :=
+| var   : nat → term
+| const : nat → term
+| app   : term → term → term
+| lam   : nat → term → term
+| pi    : nat → term → term → term
+| lett  : nat → term → term → term → term
+| sort  : nat → term
+| mvar  : nat → term → term
+
+inductive expr (A : Type) :=
+| atom : A → expr A
+| op   : nat → expr_list A → expr A
+| bind : nat → expr A → expr A
+with expr_list :=
+| nil  : expr_list A
+| cons : expr A → expr_list A → expr_list A
+
+inductive ord :=
+| zero : ord
+| succ : ord → ord
+| lim  : (nat → ord) → ord
+
+inductive le : nat → nat → Prop :=
+| refl : Π n, le n n
+| step : Π {n m}, le n m → le n (succ m)
+
+check @weekday.no_confusion
+check @opcode.cases_on
+check @myvector.brec_on
+check @term.below
+check @expr_list.rec_on
+check @ord.brec_on
+check @le.induction_on
@@ -0,0 +1,26 @@
+-- Goals with many hypotheses, used to track the time spent looking up hypotheses by name
+-- in tactics such as clear, revert and assumption.
+import logic
+
+example {p0 p1 p2 p3 p4 p5 p6 p7 p8 p9 p10 p11 p12 p13 p14 p15 p16 p17 p18 p19 p20 p21 p22 p23 p24 p25 p26 p27 p28 p29 p30 p31 p32 p33 p34 p35 p36 p37 p38 p39 : Prop} : p0 → p1 → p2 → p3 → p4 → p5 → p6 → p7 → p8 → p9 → p10 → p11 → p12 → p13 → p14 → p15 → p16 → p17 → p18 → p19 → p20 → p21 → p22 → p23 → p24 → p25 → p26 → p27 → p28 → p29 → p30 → p31 → p32 → p33 → p34 → p35 → p36 → p37 → p38 → p39 → p0 ∧ p39 :=
+begin
+  intros [H0, H1, H2, H3, H4, H5, H6, H7, H8, H9, H10, H11, H12, H13, H14, H15, H16, H17, H18, H19, H20, H21, H22, H23, H24, H25, H26, H27, H28, H29, H30, H31, H32, H33, H34, H35, H36, H37, H38, H39],
+  clears [H1, H2, H3, H4, H5, H6, H7, H8, H9, H10, H11, H12, H13, H14, H15, H16, H17, H18, H19, H20, H21, H22, H23, H24, H25, H26, H27, H28, H29, H30, H31, H32, H33, H34, H35, H36, H37, H38],
+  revert H39,
+  intro H,
+  exact and.intro H0 H
+end
+
+-- intro without names must generate fresh names that do not clash with the existing ones
+example {p0 p1 p2 p3 p4 p5 p6 p7 p8 p9 p10 p11 p12 p13 p14 p15 p16 p17 p18 p19 p20 p21 p22 p23 p24 p25 p26 p27 p28 p29 p30 p31 p32 p33 p34 p35 p36 p37 p38 p39 : Prop} : p0 → p1 → p2 → p3 → p4 → p5 → p6 → p7 → p8 → p9 → p10 → p11 → p12 → p13 → p14 → p15 → p16 → p17 → p18 → p19 → p20 → p21 → p22 → p23 → p24 → p25 → p26 → p27 → p28 → p29 → p30 → p31 → p32 → p33 → p34 → p35 → p36 → p37 → p38 → p39 → p20 :=
+begin
+  intros,
+  assumption
+end
+
+-- when several hypotheses share a user name, the most recent one is used
+example {a b : Prop} (H : a) : b → b :=
+begin
+  intro H,
+  exact H
+end
@@ -0,0 +1,14 @@
+-- Repeated rewriting on large arithmetic goals, used to track the time spent by the rewriter
+-- locating the subterms that match the rewrite rules. The rewrite steps must finish within
+-- the time limits given to try_for.
+import data.nat
+open nat
+
+example (x0 x1 x2 x3 x4 x5 x6 x7 x8 x9 x10 x11 x12 x13 x14 x15 x16 x17 x18 x19 x20 x21 x22 x23 x24 x25 x26 x27 x28 x29 x30 x31 x32 x33 x34 x35 x36 x37 x38 x39 x40 x41 x42 x43 x44 x45 x46 x47 x48 x49 x50 x51 x52 x53 x54 x55 x56 x57 x58 x59 : nat) : (x0 + 0) * 1 + (x1 + 0) * 1 + (x2 + 0) * 1 + (x3 + 0) * 1 + (x4 + 0) * 1 + (x5 + 0) * 1 + (x6 + 0) * 1 + (x7 + 0) * 1 + (x8 + 0) * 1 + (x9 + 0) * 1 + (x10 + 0) * 1 + (x11 + 0) * 1 + (x12 + 0) * 1 + (x13 + 0) * 1 + (x14 + 0) * 1 + (x15 + 0) * 1 + (x16 + 0) * 1 + (x17 + 0) * 1 + (x18 + 0) * 1 + (x19 + 0) * 1 + (x20 + 0) * 1 + (x21 + 0) * 1 + (x22 + 0) * 1 + (x23 + 0) * 1 + (x24 + 0) * 1 + (x25 + 0) * 1 + (x26 + 0) * 1 + (x27 + 0) * 1 + (x28 + 0) * 1 + (x29 + 0) * 1 + (x30 + 0) * 1 + (x31 + 0) * 1 + (x32 + 0) * 1 + (x33 + 0) * 1 + (x34 + 0) * 1 + (x35 + 0) * 1 + (x36 + 0) * 1 + (x37 + 0) * 1 + (x38 + 0) * 1 + (x39 + 0) * 1 + (x40 + 0) * 1 + (x41 + 0) * 1 + (x42 + 0) * 1 + (x43 + 0) * 1 + (x44 + 0) * 1 + (x45 + 0) * 1 + (x46 + 0) * 1 + (x47 + 0) * 1 + (x48 + 0) * 1 + (x49 + 0) * 1 + (x50 + 0) * 1 + (x51 + 0) * 1 + (x52 + 0) * 1 + (x53 + 0) * 1 + (x54 + 0) * 1 + (x55 + 0) * 1 + (x56 + 0) * 1 + (x57 + 0) * 1 + (x58 + 0) * 1 + (x59 + 0) * 1 = x0 + x1 + x2 + x3 + x4 + x5 + x6 + x7 + x8 + x9 + x10 + x11 + x12 + x13 + x14 + x15 + x16 + x17 + x18 + x19 + x20 + x21 + x22 + x23 + x24 + x25 + x26 + x27 + x28 + x29 + x30 + x31 + x32 + x33 + x34 + x35 + x36 + x37 + x38 + x39 + x40 + x41 + x42 + x43 + x44 + x45 + x46 + x47 + x48 + x49 + x50 + x51 + x52 + x53 + x54 + x55 + x56 + x57 + x58 + x59 :=
+by try_for (rewrite [*add_zero, *mul_one]) 10000
+
+example (x0 x1 x2 x3 x4 x5 x6 x7 x8 x9 x10 x11 x12 x13 x14 x15 x16 x17 x18 x19 x20 x21 x22 x23 x24 x25 x26 x27 x28 x29 x30 x31 x32 x33 x34 x35 x36 x37 x38 x39 x40 x41 x42 x43 x44 x45 x46 x47 x48 x49 x50 x51 x52 x53 x54 x55 x56 x57 x58 x59 : nat) : (x0 + 0) * 1 + (x1 + 0) * 1 + (x2 + 0) * 1 + (x3 + 0) * 1 + (x4 + 0) * 1 + (x5 + 0) * 1 + (x6 + 0) * 1 + (x7 + 0) * 1 + (x8 + 0) * 1 + (x9 + 0) * 1 + (x10 + 0) * 1 + (x11 + 0) * 1 + (x12 + 0) * 1 + (x13 + 0) * 1 + (x14 + 0) * 1 + (x15 + 0) * 1 + (x16 + 0) * 1 + (x17 + 0) * 1 + (x18 + 0) * 1 + (x19 + 0) * 1 + (x20 + 0) * 1 + (x21 + 0) * 1 + (x22 + 0) * 1 + (x23 + 0) * 1 + (x24 + 0) * 1 + (x25 + 0) * 1 + (x26 + 0) * 1 + (x27 + 0) * 1 + (x28 + 0) * 1 + (x29 + 0) * 1 + (x30 + 0) * 1 + (x31 + 0) * 1 + (x32 + 0) * 1 + (x33 + 0) * 1 + (x34 + 0) * 1 + (x35 + 0) * 1 + (x36 + 0) * 1 + (x37 + 0) * 1 + (x38 + 0) * 1 + (x39 + 0) * 1 + (x40 + 0) * 1 + (x41 + 0) * 1 + (x42 + 0) * 1 + (x43 + 0) * 1 + (x44 + 0) * 1 + (x45 + 0) * 1 + (x46 + 0) * 1 + (x47 + 0) * 1 + (x48 + 0) * 1 + (x49 + 0) * 1 + (x50 + 0) * 1 + (x51 + 0) * 1 + (x52 + 0) * 1 + (x53 + 0) * 1 + (x54 + 0) * 1 + (x55 + 0) * 1 + (x56 + 0) * 1 + (x57 + 0) * 1 + (x58 + 0) * 1 + (x59 + 0) * 1 = x0 + x1 + x2 + x3 + x4 + x5 + x6 + x7 + x8 + x9 + x10 + x11 + x12 + x13 + x14 + x15 + x16 + x17 + x18 + x19 + x20 + x21 + x22 + x23 + x24 + x25 + x26 + x27 + x28 + x29 + x30 + x31 + x32 + x33 + x34 + x35 + x36 + x37 + x38 + x39 + x40 + x41 + x42 + x43 + x44 + x45 + x46 + x47 + x48 + x49 + x50 + x51 + x52 + x53 + x54 + x55 + x56 + x57 + x58 + x59 :=
+begin
+  try_for (rewrite *add_zero) 10000,
+  try_for (rewrite *mul_one) 10000
+end
@@ -0,0 +1,45 @@
+-- A structure-heavy hierarchy modeled after library/algebra. Each structure command generates
+-- projections, coercions to its parents, eta and projection-over-mk theorems, which are type checked
+-- by the kernel. It is used to track the time spent checking these auxiliary declarations.
+import algebra.ordered_field
+open algebra
+
+namespace bench
+structure s_mul [class] (A : Type) := (mul : A → A → A)
+structure s_add [class] (A : Type) := (add : A → A → A)
+structure s_one [class] (A : Type) := (one : A)
+structure s_zero [class] (A : Type) := (zero : A)
+structure s_inv [class] (A : Type) := (inv : A → A)
+structure s_neg [class] (A : Type) := (neg : A → A)
+
+structure s_semigroup [class] (A : Type) extends s_mul A :=
+(mul_assoc : ∀a b c, mul (mul a b) c = mul a (mul b c))
+
+structure s_monoid [class] (A : Type) extends s_semigroup A, s_one A :=
+(one_mul : ∀a, mul one a = a) (mul_one : ∀a, mul a one = a)
+
+structure s_group [class] (A : Type) extends s_monoid A, s_inv A :=
+(mul_left_inv : ∀a, mul (inv a) a = one)
+
+structure s_add_semigroup [class] (A : Type) extends s_add A :=
+(add_assoc : ∀a b c, add (add a b) c = add a (add b c))
+
+structure s_add_monoid [class] (A : Type) extends s_add_semigroup A, s_zero A :=
+(zero_add : ∀a, add zero a = a) (add_zero : ∀a, add a zero = a)
+
+structure s_add_group [class] (A : Type) extends s_add_monoid A, s_neg A :=
+(add_left_inv : ∀a, add (neg a) a = zero)
+
+structure s_ring [class] (A : Type) extends s_add_group A, s_monoid A :=
+(add_comm : ∀a b, add a b = add b a)
+(left_distrib : ∀a b c, mul a (add b c) = add (mul a b) (mul a c))
+(right_distrib : ∀a b c, mul (add a b) c = add (mul a c) (mul b c))
+
+structure s_field [class] (A : Type) extends s_ring A, s_inv A :=
+(mul_comm : ∀a b, mul a b = mul b a)
+(zero_ne_one : zero ≠ one)
+(mul_inv_cancel : ∀{a}, a ≠ zero → mul a (inv a) = one)
+end bench
+
+check @bench.s_field.mul_inv_cancel
+check @ordered_field.rec_on
@@ -0,0 +1,18 @@
+-- Pretty print the type of every declaration in the standard library.
+-- We report separately the time spent producing the format objects and
+-- the time spent rendering them.
+local env   = import_modules("standard")
+local fmt   = get_formatter_factory()(env)
+local fs    = {}
+local initt = os.clock()
+env:for_each_decl(function(d)
+                     fs[#fs + 1] = fmt(d:type())
+                  end
+)
+print(string.format("formatted %d types, elapsed time: %.2f", #fs, os.clock() - initt))
+initt = os.clock()
+local sz = 0
+for i = 1, #fs do
+   sz = sz + #tostring(fs[i])
+end
+print(string.format("rendered %d characters, elapsed time: %.2f", sz, os.clock() - initt))